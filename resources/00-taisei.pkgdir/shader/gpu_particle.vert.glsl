@@ -0,0 +1,92 @@
+#version 330 core
+
+#include "lib/defs.glslh"
+#include "lib/render_context.glslh"
+#include "lib/util.glslh"
+#include "interface/gpu_particle.glslh"
+
+// Closed form of n iterations of move_update() (see move.c) with no attraction.
+// Also returns the velocity that was applied on the last iteration.
+vec2 particle_position(float n, out vec2 last_velocity) {
+	vec2 p0 = particlePosVelocity.xy;
+	vec2 v0 = particlePosVelocity.zw;
+	vec2 a = particleMotion.xy;
+	float r = particleMotion.z;
+
+	if(r == 1.0) {
+		last_velocity = v0 + a * max(0.0, n - 1.0);
+		return p0 + v0 * n + a * (0.5 * n * (n - 1.0));
+	}
+
+	// v[k] = r^k * (v0 - vinf) + vinf
+	vec2 vinf = a / (1.0 - r);
+	float rn = n > 0.0 ? pow(r, n) : 1.0;
+	float rn1 = n > 1.0 ? pow(r, n - 1.0) : 1.0;
+	last_velocity = rn1 * (v0 - vinf) + vinf;
+	return p0 + (v0 - vinf) * ((1.0 - rn) / (1.0 - r)) + vinf * n;
+}
+
+vec3 rotate_axis(vec3 p, vec3 axis, float a) {
+	float c = cos(a);
+	float s = sin(a);
+	return p * c + cross(axis, p) * s + axis * (dot(axis, p) * (1.0 - c));
+}
+
+void main(void) {
+	float t = time - particleTiming.x;
+	float lifetime = particleTiming.y;
+
+	if(t <= -1.0 || t >= lifetime + 1.0) {
+		// Dead or not yet born; emit a degenerate primitive outside of the clip volume.
+		gl_Position = vec4(-2.0, -2.0, -2.0, 1.0);
+		color = vec4(0);
+		customParams = vec4(0);
+		return;
+	}
+
+	// With render interpolation, time lags behind by up to one frame; don't let
+	// particles spawned on the current frame pop in late.
+	t = max(t, 0.0);
+
+	float tf = t / lifetime;
+
+	vec2 last_velocity;
+	vec2 pos = particle_position(t, last_velocity);
+
+	vec4 rotation = particleRotation;
+	float rot_angle = rotation.x + rotation.y * t;
+
+	if(rotation.z > 0.0 && last_velocity != vec2(0)) {
+		rot_angle = angle(last_velocity) + rotation.w;
+	}
+
+	vec4 fade = particleFade;
+	float opacity = pow(max(0.0, mix(fade.x, fade.y, tf)), fade.z);
+	opacity = clamp(opacity, 0.0, 1.0);
+
+	if(fade.w > 0.0) {
+		opacity *= min(1.0, tf / fade.w);
+	}
+
+	opacity *= particleMotion.w;
+
+	vec2 scale = mix(particleScale.xy, particleScale.zw, tf);
+
+	vec2 v = (vertPos + particleDimensions.zw) * particleDimensions.xy;
+	float ia = particleRotationAxis.w;
+	v = vec2(cos(ia) * v.x - sin(ia) * v.y, sin(ia) * v.x + cos(ia) * v.y);
+	v *= scale;
+
+	vec3 p = rotate_axis(vec3(v, 0.0), particleRotationAxis.xyz, rot_angle);
+	p.xy += pos;
+
+	gl_Position = r_projectionMatrix * r_modelViewMatrix * vec4(p, 1.0);
+
+	texCoordRaw = vertTexCoord;
+	texCoord = uv_to_region(particleTexRegion, vertTexCoord);
+	texCoordOverlay = vertTexCoord;
+	texRegion = particleTexRegion;
+	color = particleRGBA;
+	dimensions = particleDimensions.xy;
+	customParams = vec4(opacity, 0.0, 0.0, 0.0);
+}
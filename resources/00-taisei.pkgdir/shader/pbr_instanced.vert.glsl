@@ -0,0 +1,20 @@
+#version 330
+
+#include "lib/render_context.glslh"
+#include "interface/pbr.glslh"
+
+// Per-instance model matrix, applied before the modelview (see pbr_set_instance_transforms)
+ATTRIBUTE(4) mat4 instanceTransform;
+
+void main(void) {
+	mat4 mv = r_modelViewMatrix * instanceTransform;
+
+	pos = (mv * vec4(position,1.0)).xyz;
+	normal = normalize(mat3(mv)*normalIn);
+	tangent = normalize(mat3(mv)*tangentIn.xyz);
+	bitangent = normalize(mat3(mv)*cross(normalIn.xyz, tangentIn.xyz)*tangentIn.w);
+
+	gl_Position = r_projectionMatrix * vec4(pos, 1.0);
+	texCoord = (r_textureMatrix * vec4(texCoordRawIn, 0.0, 1.0)).xy;
+	texCoordRaw = texCoordRawIn;
+}
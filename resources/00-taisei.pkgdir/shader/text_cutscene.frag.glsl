@@ -1,6 +1,7 @@
 #version 330 core
 
 #include "lib/sprite_main.frag.glslh"
+#include "lib/text.glslh"
 
 float sampleNoise(vec2 tc) {
 	tc.y *= fwidth(tc.x) / fwidth(tc.y);
@@ -15,7 +16,7 @@ void spriteMain(out vec4 fragColor) {
 	mask = 1.0 - smoothstep(slide_factor * o * o, slide_factor * o, mask + (slide_factor - 1.0) * xpos);
 	mask = smoothstep(0.2, 0.8, mask);
 
-	vec3 outlines = texture(tex, texCoord).rgb;
+	vec3 outlines = glyphCoverage(texture(tex, texCoord).rgb);
 
 	vec4 highlight = color;
 	vec4 fill      = vec4(color.rgb * 0.9, color.a) * mask;
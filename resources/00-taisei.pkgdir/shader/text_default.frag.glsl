@@ -1,7 +1,8 @@
 #version 330 core
 
 #include "lib/sprite_main.frag.glslh"
+#include "lib/text.glslh"
 
 void spriteMain(out vec4 fragColor) {
-    fragColor = color * vec4(texture(tex, texCoord).r);
+    fragColor = color * vec4(glyphCoverage(texture(tex, texCoord).rgb).r);
 }
@@ -2,6 +2,7 @@
 
 #include "lib/render_context.glslh"
 #include "lib/sprite_main.frag.glslh"
+#include "lib/text.glslh"
 #include "lib/util.glslh"
 
 vec3 colormap(float p) {
@@ -28,7 +29,7 @@ void spriteMain(out vec4 fragColor) {
 	vec4 g = vec4(colormap(fract(-0.5 * t + go)), 0);
 	clr = alphaCompose(clr, g);
 
-	vec3 outlines = texture(tex, texCoord).rgb;
+	vec3 outlines = glyphCoverage(texture(tex, texCoord).rgb);
 	vec4 border = vec4(vec3(g.rgb), 0.5) * outlines.g;
 	vec4 fill = clr * outlines.r;
 
@@ -2,6 +2,7 @@
 
 #include "lib/render_context.glslh"
 #include "lib/sprite_main.frag.glslh"
+#include "lib/text.glslh"
 #include "lib/util.glslh"
 
 float sampleNoise(vec2 tc) {
@@ -13,7 +14,7 @@ void spriteMain(out vec4 fragColor) {
 	float t = customParams.x;
 	float r = customParams.y;
 
-	vec4 glyph = texture(tex, texCoord);
+	vec3 glyph = glyphCoverage(texture(tex, texCoord).rgb);
 	float noise = sampleNoise(texCoordOverlay);
 
 	float d = 0.5;
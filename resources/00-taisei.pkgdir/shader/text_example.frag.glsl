@@ -2,6 +2,7 @@
 
 #include "lib/render_context.glslh"
 #include "lib/sprite_main.frag.glslh"
+#include "lib/text.glslh"
 #include "lib/util.glslh"
 
 void spriteMain(out vec4 fragColor) {
@@ -20,7 +21,7 @@ void spriteMain(out vec4 fragColor) {
     vec2 tc_atlas = uv_to_region(texRegion, tc);
 
     // Display the glyph.
-    fragColor = color * vec4(texture(tex, tc_atlas).r * a);
+    fragColor = color * vec4(glyphCoverage(texture(tex, tc_atlas).rgb).r * a);
 
     // Visualize global overlay coordinates. You could use them to span a texture across all glyphs.
     fragColor *= vec4(tc_overlay.x, tc_overlay.y, 0, 1);
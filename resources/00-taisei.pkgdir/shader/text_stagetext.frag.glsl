@@ -2,6 +2,7 @@
 
 #include "lib/render_context.glslh"
 #include "lib/sprite_main.frag.glslh"
+#include "lib/text.glslh"
 #include "lib/util.glslh"
 
 float tc_mask(vec2 tc) {
@@ -19,12 +20,12 @@ void spriteMain(out vec4 fragColor) {
     tc /= dimensions;
 
     float a = tc_mask(tc);
-    vec4 textfrag = color * texture(tex, uv_to_region(texRegion, flip_topleft_to_native(tc))).r * a;
+    vec4 textfrag = color * glyphCoverage(texture(tex, uv_to_region(texRegion, flip_topleft_to_native(tc))).rgb).r * a;
 
     tc -= vec2(1) / dimensions;
     a = tc_mask(tc);
 
-    vec4 shadowfrag = vec4(vec3(0), color.a) * texture(tex, uv_to_region(texRegion, flip_topleft_to_native(tc))).r * a;
+    vec4 shadowfrag = vec4(vec3(0), color.a) * glyphCoverage(texture(tex, uv_to_region(texRegion, flip_topleft_to_native(tc))).rgb).r * a;
 
     fragColor = textfrag;
     fragColor = mix(shadowfrag, textfrag, sqrt(textfrag.a));
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+
+import subprocess
+
+import zipfile_zstd
+
+from zipfile import (
+    ZIP_ZSTANDARD,
+    ZipFile,
+    ZipInfo,
+)
+
+from concurrent.futures import (
+    ThreadPoolExecutor,
+)
+
+from pathlib import Path
+
+from taiseilib.common import (
+    DirPathType,
+    TaiseiError,
+    add_common_args,
+    run_main,
+    write_depfile,
+)
+
+
+# Renderer backends that need their shaders translated, and the SPIRV-Cross arguments to do so.
+# The sources are stored as shader-bundle/<backend>/<shader object name>.glsl.
+# gles20 is not here: ESSL 1.00 has no attribute locations, so it needs reflection data that
+# only the runtime translator provides.
+BACKENDS = {
+    'gles30': ['--version', '300', '--es'],
+}
+
+SPVC_COMMON_ARGS = [
+    '--remove-unused-variables',
+]
+
+# Fixed timestamp, so that the archive only changes when the shaders do.
+ZIP_DATE_TIME = (1980, 1, 1, 0, 0, 0)
+
+
+def object_name(spv_path, root):
+    # e.g. <root>/lasers/sdf_apply.frag.spv -> lasers/sdf_apply.frag
+    return spv_path.relative_to(root).with_suffix('').as_posix()
+
+
+def translate(spvc, spv_path, stage, backend_args):
+    cmd = [spvc, str(spv_path), '--stage', stage] + SPVC_COMMON_ARGS + backend_args
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+
+    if result.returncode != 0:
+        raise TaiseiError(f'{" ".join(cmd)} failed:\n{result.stderr.decode("utf8", "replace")}')
+
+    return result.stdout
+
+
+def gen_bundle(args):
+    root = args.root.resolve()
+    inputs = sorted(p.resolve() for p in args.inputs)
+    jobs = []
+
+    with ThreadPoolExecutor() as ex:
+        for spv_path in inputs:
+            name = object_name(spv_path, root)
+            stage = name.split('.')[-1]
+
+            for backend, backend_args in BACKENDS.items():
+                arcname = f'shader-bundle/{backend}/{name}.glsl'
+                jobs.append((arcname, ex.submit(translate, args.spvc, spv_path, stage, backend_args)))
+
+        with ZipFile(str(args.output), 'w', ZIP_ZSTANDARD, compresslevel=20) as zf:
+            for arcname, job in sorted(jobs, key=lambda j: j[0]):
+                zi = ZipInfo(arcname, ZIP_DATE_TIME)
+                zi.compress_type = ZIP_ZSTANDARD
+                zi.external_attr = 0o644 << 16  # -rw-r--r--
+                zf.writestr(zi, job.result())
+
+    print(f'Bundled {len(jobs)} shader sources for {", ".join(BACKENDS)}')
+
+    if args.depfile is not None:
+        write_depfile(args.depfile, args.output, inputs + [Path(__file__).resolve()])
+
+
+def main(args):
+    import argparse
+    parser = argparse.ArgumentParser(description='Pre-translate shaders for backends that can\'t use them as is.', prog=args[0])
+
+    parser.add_argument('output',
+        type=Path,
+        help='the output archive path'
+    )
+
+    parser.add_argument('inputs',
+        type=Path,
+        nargs='+',
+        help='SPIR-V binaries of the shader objects, compiled from the GLSL sources'
+    )
+
+    parser.add_argument('--root',
+        type=DirPathType,
+        required=True,
+        help='directory the SPIR-V binaries were built into; shader names are relative to it'
+    )
+
+    parser.add_argument('--spvc',
+        required=True,
+        help='path to the spirv-cross executable'
+    )
+
+    add_common_args(parser, depfile=True)
+
+    args = parser.parse_args(args[1:])
+    gen_bundle(args)
+
+
+if __name__ == '__main__':
+    run_main(main)
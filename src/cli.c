@@ -28,8 +28,12 @@ enum {
 	OPT_CUTSCENE_LIST,
 	OPT_FORCE_INTRO,
 	OPT_REREPLAY,
+	OPT_DUMP_FRAMES,
+	OPT_VERIFY_REPLAYS,
 	OPT_POPCACHE,
 	OPT_UNLOCKALL,
+	OPT_BENCH_PIXMAPS,
+	OPT_BENCH_TEXT,
 };
 
 static void print_help(struct TsOption* opts) {
@@ -79,6 +83,8 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		{{"replay",             required_argument,  0, 'r'},            "Play a replay from %s", "FILE"},
 		{{"verify-replay",      required_argument,  0, 'R'},            "Play a replay from %s in headless mode, crash as soon as it desyncs unless --rereplay is used", "FILE"},
 		{{"rereplay",           required_argument,  0, OPT_REREPLAY},   "Re-record replay into %s; specify input with -r or -R", "OUTFILE"},
+		{{"verify-replays",     required_argument,  0, OPT_VERIFY_REPLAYS}, "Verify all replays in %s in headless mode, then print a summary", "DIR"},
+		{{"dump-frames",        required_argument,  0, OPT_DUMP_FRAMES}, "Save every frame of the replay given with -r as numbered PNGs in directory %s, or as a raw video stream if it ends with .y4m", "PATH"},
 #ifdef DEBUG
 		{{"play",               no_argument,        0, 'p'},            "Play a specific stage"},
 		{{"sid",                required_argument,  0, 'i'},            "Select stage by %s", "ID"},
@@ -91,6 +97,8 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		{{"intro",              no_argument,        0, OPT_FORCE_INTRO}, "Play the intro cutscene even if already seen"},
 		{{"skip-to-bookmark",   required_argument,  0, 'b'},            "Fast-forward stage to a specific STAGE_BOOKMARK call"},
 		{{"unlock-all",         no_argument,        0, OPT_UNLOCKALL},  "Unlock all content"},
+		{{"bench-pixmaps",      optional_argument,  0, OPT_BENCH_PIXMAPS}, "Benchmark pixmap conversions on all images in %s (default: res/gfx), then exit", "PATH"},
+		{{"bench-text",         no_argument,        0, OPT_BENCH_TEXT}, "Benchmark text rendering, then exit"},
 #endif
 		{{"frameskip",          optional_argument,  0, 'f'},            "Disable FPS limiter, render only every %s frame", "FRAME"},
 		{{"credits",            no_argument,        0, 'c'},            "Show the credits scene and exit"},
@@ -158,10 +166,17 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 			a->type = CLI_VerifyReplay;
 			stralloc(&a->filename, optarg);
 			break;
+		case OPT_VERIFY_REPLAYS:
+			a->type = CLI_VerifyReplays;
+			stralloc(&a->filename, optarg);
+			break;
 		case OPT_REREPLAY:
 			stralloc(&a->out_replay, optarg);
 			env_set("TAISEI_REPLAY_DESYNC_CHECK_FREQUENCY", 1, false);
 			break;
+		case OPT_DUMP_FRAMES:
+			stralloc(&a->dump_frames, optarg);
+			break;
 		case 'p':
 			a->type = CLI_SelectStage;
 			break;
@@ -219,6 +234,13 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 			a->type = CLI_DumpVFSTree,
 			stralloc(&a->filename, optarg ? optarg : "");
 			break;
+		case OPT_BENCH_PIXMAPS:
+			a->type = CLI_BenchPixmaps;
+			stralloc(&a->filename, optarg ? optarg : "res/gfx");
+			break;
+		case OPT_BENCH_TEXT:
+			a->type = CLI_BenchText;
+			break;
 		case 'c':
 			a->type = CLI_Credits;
 			break;
@@ -296,6 +318,17 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		log_fatal("--rereplay requires --replay or --verify-replay");
 	}
 
+	if(a->dump_frames) {
+		if(a->type != CLI_PlayReplay) {
+			log_fatal("--dump-frames requires --replay");
+		}
+
+		// Render every frame as fast as possible
+		if(!a->frameskip) {
+			a->frameskip = 1;
+		}
+	}
+
 	return 0;
 }
 
@@ -304,4 +337,6 @@ void free_cli_action(CLIAction *a) {
 	a->filename = NULL;
 	mem_free(a->out_replay);
 	a->out_replay = NULL;
+	mem_free(a->dump_frames);
+	a->dump_frames = NULL;
 }
@@ -15,9 +15,12 @@ typedef enum {
 	CLI_RunNormally = 0,
 	CLI_PlayReplay,
 	CLI_VerifyReplay,
+	CLI_VerifyReplays,
 	CLI_SelectStage,
 	CLI_DumpStages,
 	CLI_DumpVFSTree,
+	CLI_BenchPixmaps,
+	CLI_BenchText,
 	CLI_Quit,
 	CLI_QuitLate,
 	CLI_Credits,
@@ -28,6 +31,7 @@ typedef struct CLIAction CLIAction;
 struct CLIAction {
 	char *filename;
 	char *out_replay;
+	char *dump_frames;
 	PlayerMode *plrmode;
 	CLIActionType type;
 	int stageid;
@@ -113,9 +113,53 @@ static inline bool ent_is_drawable(EntityInterface *ent) {
 	return (ent->draw_layer & ~LAYER_LOW_MASK) > LAYER_NODRAW && ent->draw_func;
 }
 
+#define ENT_DRAW_STATE_FIELDS (RSB_SHADER | RSB_BLEND | RSB_CAPABILITIES | RSB_CULL | RSB_DEPTH_FUNC)
+
+typedef struct EntDrawState {
+	// The state at the start of ent_draw(), for everything a block can cover
+	const RenderStateBlock *baseline;
+	// The block in effect between entities: the last drawn entity's, or the baseline
+	const RenderStateBlock *current;
+} EntDrawState;
+
+static void ent_draw_state_init(EntDrawState *ds) {
+	ds->baseline = ds->current = r_state_block(&(RenderStateBlockParams) {
+		.fields = ENT_DRAW_STATE_FIELDS,
+		.shader = r_shader_current(),
+		.blend = r_blend_current(),
+		.capabilities = r_capabilities_current(),
+		.cull = r_cull_current(),
+		.depth_func = r_depth_func_current(),
+	});
+}
+
+static inline void ent_apply_draw_state(EntDrawState *ds, EntityInterface *ent) {
+	// Applied outside of the entity's own state push/pop, so that a run of entities sharing
+	// the same block costs a pointer comparison each. Entities without a block get the
+	// baseline state back. A different block replaces the current one directly, unless it
+	// doesn't cover everything the current one set; then the baseline is restored first.
+	const RenderStateBlock *blk = ent->draw_state ? ent->draw_state : ds->baseline;
+
+	if(blk != ds->current) {
+		uint cur_fields = r_state_block_params(ds->current)->fields;
+
+		if((r_state_block_params(blk)->fields & cur_fields) != cur_fields) {
+			r_state_block_apply(ds->baseline);
+		}
+
+		ds->current = blk;
+	}
+
+	r_state_block_apply(blk);
+}
+
 void ent_draw(EntityPredicate predicate) {
 	call_hooks(&entities.hooks.pre_draw, NULL);
 	dynarray_qsort(&entities.registered, ent_cmp);
+	r_state_push();
+
+	EntDrawState ds;
+	ent_draw_state_init(&ds);
 
 	if(predicate) {
 		dynarray_foreach(&entities.registered, int i, EntityInterface **pent, {
@@ -124,6 +168,7 @@ void ent_draw(EntityPredicate predicate) {
 
 			if(ent_is_drawable(ent) && predicate(ent)) {
 				call_hooks(&entities.hooks.pre_draw, ent);
+				ent_apply_draw_state(&ds, ent);
 				r_state_push();
 				ent->draw_func(ent);
 				r_state_pop();
@@ -137,6 +182,7 @@ void ent_draw(EntityPredicate predicate) {
 
 			if(ent_is_drawable(ent)) {
 				call_hooks(&entities.hooks.pre_draw, ent);
+				ent_apply_draw_state(&ds, ent);
 				r_state_push();
 				ent->draw_func(ent);
 				r_state_pop();
@@ -145,7 +191,9 @@ void ent_draw(EntityPredicate predicate) {
 		});
 	}
 
+	r_state_block_apply(ds.baseline);
 	call_hooks(&entities.hooks.post_draw, NULL);
+	r_state_pop();
 }
 
 DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) {
@@ -212,6 +260,18 @@ void ent_area_damage_ellipse(Ellipse ellipse, const DamageInfo *damage, EntityAr
 	}
 }
 
+uint32_t ent_get_total_spawns(void) {
+	return entities.total_spawns;
+}
+
+void ent_count_by_type(uint counts[_ENT_TYPE_ENUM_END]) {
+	memset(counts, 0, sizeof(*counts) * _ENT_TYPE_ENUM_END);
+
+	dynarray_foreach_elem(&entities.registered, EntityInterface **pent, {
+		++counts[(*pent)->type];
+	});
+}
+
 void ent_hook_pre_draw(EntityDrawHookCallback callback, void *arg) {
 	add_hook(&entities.hooks.pre_draw, callback, arg);
 }
@@ -87,6 +87,7 @@ typedef void (*EntityAreaDamageCallback)(EntityInterface *ent, cmplx ent_origin,
 	LIST_INTERFACE(typename); \
 	EntityDrawFunc draw_func; \
 	EntityDamageFunc damage_func; \
+	const struct RenderStateBlock *draw_state; \
 	drawlayer_t draw_layer; \
 	uint32_t spawn_id; \
 	uint index; \
@@ -138,6 +139,9 @@ DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) attr_non
 void ent_area_damage(cmplx origin, float radius, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) attr_nonnull(3);
 void ent_area_damage_ellipse(Ellipse ellipse, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) attr_nonnull(2);
 
+uint32_t ent_get_total_spawns(void);
+void ent_count_by_type(uint counts[_ENT_TYPE_ENUM_END]) attr_nonnull(1);
+
 void ent_hook_pre_draw(EntityDrawHookCallback callback, void *arg);
 void ent_unhook_pre_draw(EntityDrawHookCallback callback);
 void ent_hook_post_draw(EntityDrawHookCallback callback, void *arg);
@@ -15,7 +15,9 @@
 #include "vfs/public.h"
 #include "thread.h"
 
-struct evloop_s evloop;
+struct evloop_s evloop = {
+	.interpolation = 1,
+};
 
 void eventloop_enter(void *context, LogicFrameFunc frame_logic, RenderFrameFunc frame_render, PostLoopFunc on_leave, uint target_fps) {
 	assert(thread_current_is_main());
@@ -60,6 +62,10 @@ FrameTimes eventloop_get_frame_times(void) {
 	return evloop.frame_times;
 }
 
+float eventloop_get_interpolation(void) {
+	return evloop.interpolation;
+}
+
 LogicFrameAction run_logic_frame(LoopFrame *frame) {
 	assert(frame == evloop.stack_ptr);
 
@@ -122,7 +128,11 @@ RenderFrameAction run_render_frame(LoopFrame *frame) {
 	assert(evloop.stack_ptr == stack_prev);
 
 	if(a == RFRAME_SWAP) {
-		video_swap_buffers();
+		if(evloop.defer_present) {
+			video_swap_buffers_deferred();
+		} else {
+			video_swap_buffers();
+		}
 	}
 
 	fpscounter_update(&global.fps.render);
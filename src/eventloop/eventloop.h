@@ -44,3 +44,7 @@ void eventloop_enter(
 void eventloop_run(void);
 
 FrameTimes eventloop_get_frame_times(void);
+
+// Position of the frame being rendered between the previous logic frame (0) and the current one
+// (1). Always 1, unless rendering is uncapped and interpolation is enabled; see ENVIRON.rst.
+float eventloop_get_interpolation(void);
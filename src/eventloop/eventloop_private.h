@@ -29,6 +29,13 @@ extern struct evloop_s {
 	LoopFrame stack[EVLOOP_STACK_SIZE];
 	LoopFrame *stack_ptr;
 	FrameTimes frame_times;
+
+	// If set, run_render_frame only finishes the frame; the executor must present it
+	// with video_present_pending() (see executor_synchro.c).
+	bool defer_present;
+
+	// See eventloop_get_interpolation()
+	float interpolation;
 } evloop;
 
 void eventloop_leave(void);
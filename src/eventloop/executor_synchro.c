@@ -13,6 +13,10 @@
 #include "framerate.h"
 #include "thread.h"
 #include "global.h"
+#include "video.h"
+#include "pacing.h"
+
+#define INTERPOLATION_STEPS 16
 
 void eventloop_run(void) {
 	assert(thread_current_is_main());
@@ -25,7 +29,7 @@ void eventloop_run(void) {
 	evloop.frame_times.target = frame->frametime;
 	evloop.frame_times.start = time_get();
 	evloop.frame_times.next = evloop.frame_times.start + evloop.frame_times.target;
-	int32_t sleep = env_get("TAISEI_FRAMELIMITER_SLEEP", 3);
+	bool allow_sleep = env_get("TAISEI_FRAMELIMITER_SLEEP", 1);
 	bool compensate = env_get("TAISEI_FRAMELIMITER_COMPENSATE", 1);
 	bool uncapped_rendering_env, uncapped_rendering;
 
@@ -38,6 +42,29 @@ void eventloop_run(void) {
 	uncapped_rendering = uncapped_rendering_env;
 	uint32_t frame_num = 0;
 
+	// In pipelined mode, the logic for the next frame runs right after the current frame has
+	// been rendered, but before it's presented. The draw commands for frame N are then already
+	// queued up in the driver, and the GPU processes them while the CPU simulates frame N+1,
+	// instead of the swap stalling the whole loop. This costs up to one logic frame of latency.
+	// Not compatible with uncapped rendering, which may run several logic frames per render.
+	bool pipelined = (
+		!global.is_replay_verification &&
+		!uncapped_rendering_env &&
+		env_get("TAISEI_FRAMELIMITER_PIPELINED", 0)
+	);
+	bool logic_ahead = false;
+	LogicFrameAction lframe_action_ahead = LFRAME_WAIT;
+	evloop.defer_present = pipelined;
+
+	// In uncapped mode, frames are only rendered if they would differ from the previous one:
+	// that is, if a logic frame has been processed since, or (with interpolation) if the
+	// interpolation factor has advanced by at least 1/INTERPOLATION_STEPS of a logic frame.
+	bool interpolate = uncapped_rendering_env && env_get("TAISEI_FRAMELIMITER_INTERPOLATE", 0);
+	float last_interpolation = 1;
+	hrtime_t last_render_time = 0;
+	evloop.interpolation = 1;
+	pacing_reset();
+
 begin_main_loop:
 	while(frame != NULL) {
 
@@ -55,10 +82,12 @@ void eventloop_run(void) {
 		++frame_num;
 
 		LogicFrameAction lframe_action = LFRAME_WAIT;
+		uint32_t logic_frames = 0;
 
-		if(uncapped_rendering) {
-			attr_unused uint32_t logic_frames = 0;
-
+		if(logic_ahead) {
+			lframe_action = lframe_action_ahead;
+			logic_ahead = false;
+		} else if(uncapped_rendering) {
 			while(lframe_action != LFRAME_STOP && evloop.frame_times.next < evloop.frame_times.start) {
 				lframe_action = handle_logic(&frame, &evloop.frame_times);
 
@@ -93,8 +122,50 @@ void eventloop_run(void) {
 			}
 		}
 
-		if((uncapped_rendering || !(frame_num % get_effective_frameskip())) && !global.is_replay_verification) {
+		if(uncapped_rendering && !global.is_replay_verification) {
+			float interpolation = 1;
+
+			if(interpolate) {
+				hrtime_t last_tick = evloop.frame_times.next - evloop.frame_times.target;
+				shrtime_t since_tick = (shrtime_t)time_get() - (shrtime_t)last_tick;
+				interpolation = clamp((double)since_tick / evloop.frame_times.target, 0, 1);
+			}
+
+			if(
+				logic_frames == 0 &&
+				(interpolation - last_interpolation) * INTERPOLATION_STEPS < 1
+			) {
+				// Nothing new to show; wait for the next logic frame or interpolation step.
+				hrtime_t deadline = evloop.frame_times.next;
+
+				if(interpolation < 1) {
+					deadline = imin(deadline, last_render_time + evloop.frame_times.target / INTERPOLATION_STEPS);
+				}
+
+				pacing_wait_until(deadline, allow_sleep);
+				continue;
+			}
+
+			evloop.interpolation = interpolation;
+			last_interpolation = interpolation;
+			last_render_time = time_get();
 			run_render_frame(frame);
+			pacing_frame_rendered();
+			evloop.interpolation = 1;
+		} else if(!(frame_num % get_effective_frameskip()) && !global.is_replay_verification) {
+			run_render_frame(frame);
+			pacing_frame_rendered();
+
+			if(pipelined) {
+				lframe_action_ahead = handle_logic(&frame, &evloop.frame_times);
+				video_present_pending();
+
+				if(!frame || lframe_action_ahead == LFRAME_STOP) {
+					goto begin_main_loop;
+				}
+
+				logic_ahead = true;
+			}
 		}
 
 		fpscounter_update(&global.fps.busy);
@@ -122,18 +193,9 @@ void eventloop_run(void) {
 			}
 		}
 
-		if(sleep > 0) {
-			// CAUTION: All of these casts are important!
-			while((shrtime_t)evloop.frame_times.next - (shrtime_t)time_get() > (shrtime_t)evloop.frame_times.target / sleep) {
-				uint32_t nap_multiplier = 1;
-				uint32_t nap_divisor = 3;
-				hrtime_t nap_raw = imax(0, (shrtime_t)evloop.frame_times.next - (shrtime_t)time_get());
-				uint32_t nap_sdl = (nap_multiplier * nap_raw * 1000) / (HRTIME_RESOLUTION * nap_divisor);
-				nap_sdl = imax(nap_sdl, 1);
-				SDL_Delay(nap_sdl);
-			}
-		}
-
-		while(time_get() < evloop.frame_times.next);
+		pacing_wait_until(evloop.frame_times.next, allow_sleep);
 	}
+
+	evloop.defer_present = false;
+	pacing_log_stats();
 }
@@ -0,0 +1,138 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "pacing.h"
+#include "util.h"
+
+#ifdef TAISEI_BUILDCONF_HAVE_CLOCK_NANOSLEEP
+	#include <errno.h>
+	#include <time.h>
+#endif
+
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+	#include <sched.h>
+#endif
+
+#define MARGIN_INITIAL (HRTIME_RESOLUTION / 500)    // 2 ms
+#define MARGIN_MIN     (HRTIME_RESOLUTION / 20000)  // 50 us
+#define MARGIN_MAX     (HRTIME_RESOLUTION / 100)    // 10 ms
+#define MARGIN_DECAY   64
+
+// Frame time histogram: 50 us buckets, up to 100 ms.
+#define HIST_BUCKET_SIZE (HRTIME_RESOLUTION / 20000)
+#define HIST_NUM_BUCKETS 2000
+
+static struct {
+	hrtime_t sleep_margin;
+	hrtime_t prev_frame_time;
+	uint64_t num_frames;
+	uint32_t histogram[HIST_NUM_BUCKETS];
+} pacing;
+
+void pacing_reset(void) {
+	memset(&pacing, 0, sizeof(pacing));
+	pacing.sleep_margin = MARGIN_INITIAL;
+}
+
+static void os_sleep(hrtime_t duration) {
+#ifdef TAISEI_BUILDCONF_HAVE_CLOCK_NANOSLEEP
+	hrtime_t nsec = duration / (HRTIME_RESOLUTION / 1000000000);
+	struct timespec ts = {
+		.tv_sec = nsec / 1000000000,
+		.tv_nsec = nsec % 1000000000,
+	};
+	while(clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR);
+#else
+	uint32_t msec = duration / (HRTIME_RESOLUTION / 1000);
+	SDL_Delay(imax(msec, 1));
+#endif
+}
+
+static void os_yield(void) {
+#ifdef TAISEI_BUILDCONF_HAVE_POSIX
+	sched_yield();
+#else
+	SDL_Delay(0);
+#endif
+}
+
+static void calibrate(hrtime_t overshoot) {
+	hrtime_t margin = pacing.sleep_margin;
+
+	if(overshoot > margin) {
+		margin = overshoot;
+	} else {
+		margin -= (margin - overshoot) / MARGIN_DECAY;
+	}
+
+	pacing.sleep_margin = iclamp(margin, MARGIN_MIN, MARGIN_MAX);
+}
+
+void pacing_wait_until(hrtime_t deadline, bool allow_sleep) {
+	hrtime_t now = time_get();
+
+	if(allow_sleep && now < deadline && deadline - now > pacing.sleep_margin) {
+		hrtime_t duration = deadline - now - pacing.sleep_margin;
+		os_sleep(duration);
+
+		hrtime_t woke = time_get();
+		calibrate(woke > now + duration ? woke - (now + duration) : 0);
+	}
+
+	while(time_get() < deadline) {
+		os_yield();
+	}
+}
+
+void pacing_frame_rendered(void) {
+	hrtime_t now = time_get();
+
+	if(pacing.prev_frame_time) {
+		hrtime_t bucket = (now - pacing.prev_frame_time) / HIST_BUCKET_SIZE;
+		pacing.histogram[imin(bucket, HIST_NUM_BUCKETS - 1)]++;
+		pacing.num_frames++;
+	}
+
+	pacing.prev_frame_time = now;
+}
+
+hrtime_t pacing_frametime_percentile(double p) {
+	if(pacing.num_frames == 0) {
+		return 0;
+	}
+
+	uint64_t target = ceil(clamp(p, 0, 1) * pacing.num_frames);
+	uint64_t count = 0;
+
+	for(int i = 0; i < HIST_NUM_BUCKETS; ++i) {
+		count += pacing.histogram[i];
+
+		if(count >= target && count > 0) {
+			// Report the bucket's upper bound
+			return (i + 1) * HIST_BUCKET_SIZE;
+		}
+	}
+
+	return HIST_NUM_BUCKETS * HIST_BUCKET_SIZE;
+}
+
+void pacing_log_stats(void) {
+	if(pacing.num_frames == 0) {
+		return;
+	}
+
+	log_info(
+		"%"PRIu64" frames; frame time p50: %.2f ms, p99: %.2f ms; sleep margin: %.0f us",
+		pacing.num_frames,
+		pacing_frametime_percentile(0.50) / (double)(HRTIME_RESOLUTION / 1000),
+		pacing_frametime_percentile(0.99) / (double)(HRTIME_RESOLUTION / 1000),
+		pacing.sleep_margin / (double)(HRTIME_RESOLUTION / 1000000)
+	);
+}
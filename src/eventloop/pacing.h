@@ -0,0 +1,34 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "hirestime.h"
+
+/*
+ * Frame pacing for the synchronous executor.
+ *
+ * Waiting is done in two phases: an OS sleep that ends a safety margin before the deadline,
+ * followed by a spin on time_get() that yields the CPU on every iteration. The margin is
+ * learned at runtime from the observed sleep overshoot: it grows immediately when a sleep
+ * overshoots by more than the margin, and decays slowly otherwise.
+ */
+
+void pacing_reset(void);
+
+// Waits until the deadline. If allow_sleep is false, only spins.
+void pacing_wait_until(hrtime_t deadline, bool allow_sleep);
+
+// Records the presentation of a new frame, for the statistics below.
+void pacing_frame_rendered(void);
+
+// Percentile (p in [0, 1]) of the intervals between rendered frames since the last reset.
+hrtime_t pacing_frametime_percentile(double p);
+
+void pacing_log_stats(void);
@@ -0,0 +1,259 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "framedump.h"
+#include "global.h"
+#include "renderer/api.h"
+#include "taskmanager.h"
+#include "util.h"
+
+// Maximum number of frames being encoded at once. Capturing stalls when this is exceeded,
+// which bounds memory usage when encoding can't keep up with rendering.
+#define FRAMEDUMP_MAX_PENDING 16
+
+#define FRAMEDUMP_MOUNTPOINT "framedump"
+
+typedef struct FrameDumpTaskData {
+	Pixmap image;
+	char *dest_path;  // PNG mode only
+} FrameDumpTaskData;
+
+static struct {
+	struct {
+		Task *tasks[FRAMEDUMP_MAX_PENDING];
+		uint head;
+		uint count;
+	} queue;
+
+	SDL_RWops *y4m_stream;
+	uint width, height;
+	uint fps_num, fps_den;
+
+	uint num_requested;
+	uint num_written;
+	uint num_dropped;
+	bool active;
+} fdump;
+
+void framedump_init(const char *path, int frameskip) {
+	if(!path) {
+		return;
+	}
+
+	fdump.fps_num = FPS;
+	fdump.fps_den = imax(1, frameskip);
+
+	if(strendswith(path, ".y4m")) {
+		fdump.y4m_stream = SDL_RWFromFile(path, "wb");
+
+		if(!fdump.y4m_stream) {
+			log_fatal("SDL_RWFromFile() failed: %s", SDL_GetError());
+		}
+	} else if(!vfs_mount_syspath(FRAMEDUMP_MOUNTPOINT, path, VFS_SYSPATH_MOUNT_MKDIR)) {
+		log_fatal("Failed to mount '%s': %s", path, vfs_get_error());
+	}
+
+	fdump.active = true;
+	log_info("Dumping frames into %s", path);
+}
+
+static void framedump_free_task_data(void *arg) {
+	FrameDumpTaskData *tdata = arg;
+	mem_free(tdata->image.data.untyped);
+	mem_free(tdata->dest_path);
+	mem_free(tdata);
+}
+
+static void *framedump_png_task(void *arg) {
+	FrameDumpTaskData *tdata = arg;
+
+	pixmap_convert_inplace_realloc(&tdata->image, PIXMAP_FORMAT_RGB8);
+
+	// These are intermediate files; favor throughput over size.
+	PixmapPNGSaveOptions opts = PIXMAP_DEFAULT_PNG_SAVE_OPTIONS;
+	opts.zlib_compression_level = 1;
+
+	// Any non-NULL result means success
+	return pixmap_save_file(tdata->dest_path, &tdata->image, &opts.base) ? tdata : NULL;
+}
+
+static void *framedump_y4m_task(void *arg) {
+	FrameDumpTaskData *tdata = arg;
+	Pixmap *img = &tdata->image;
+
+	// Synchronous fallbacks may return other formats
+	pixmap_convert_inplace_realloc(img, PIXMAP_FORMAT_RGBA8);
+	bool flip = img->origin == PIXMAP_ORIGIN_BOTTOMLEFT;
+
+	size_t plane_size = (size_t)img->width * img->height;
+	uint8_t *planes = mem_alloc(plane_size * 3);
+	uint8_t *py = planes;
+	uint8_t *pu = py + plane_size;
+	uint8_t *pv = pu + plane_size;
+
+	// Y4M is top-down, BT.601 limited range
+	for(uint y = 0; y < img->height; ++y) {
+		uint src_y = flip ? img->height - y - 1 : y;
+		const uint8_t *row = (const uint8_t*)img->data.untyped + (size_t)src_y * img->width * 4;
+
+		for(uint x = 0; x < img->width; ++x) {
+			int r = row[x * 4 + 0];
+			int g = row[x * 4 + 1];
+			int b = row[x * 4 + 2];
+
+			*py++ = (( 66 * r + 129 * g +  25 * b + 128) >> 8) + 16;
+			*pu++ = ((-38 * r -  74 * g + 112 * b + 128) >> 8) + 128;
+			*pv++ = ((112 * r -  94 * g -  18 * b + 128) >> 8) + 128;
+		}
+	}
+
+	return planes;
+}
+
+static void framedump_y4m_write(const uint8_t *planes) {
+	size_t size = (size_t)fdump.width * fdump.height * 3;
+
+	if(
+		SDL_RWwrite(fdump.y4m_stream, "FRAME\n", 6, 1) != 1 ||
+		SDL_RWwrite(fdump.y4m_stream, planes, size, 1) != 1
+	) {
+		log_fatal("SDL_RWwrite() failed: %s", SDL_GetError());
+	}
+}
+
+// Frames are retired in capture order, so the Y4M stream is written sequentially.
+static bool framedump_retire_oldest(bool block) {
+	if(!fdump.queue.count) {
+		return false;
+	}
+
+	Task *task = fdump.queue.tasks[fdump.queue.head];
+
+	if(!block && task_status(task) != TASK_FINISHED) {
+		return false;
+	}
+
+	fdump.queue.head = (fdump.queue.head + 1) % FRAMEDUMP_MAX_PENDING;
+	--fdump.queue.count;
+
+	void *result = NULL;
+
+	if(!task_finish(task, &result) || !result) {
+		log_error("Failed to encode frame");
+		++fdump.num_dropped;
+		return true;
+	}
+
+	if(fdump.y4m_stream) {
+		framedump_y4m_write(result);
+		mem_free(result);
+	}
+
+	++fdump.num_written;
+	return true;
+}
+
+static void framedump_submit(Task *task, uint frame) {
+	if(UNLIKELY(!task)) {
+		// The task manager has already freed the frame data
+		log_warn("Failed to submit frame %u for encoding; dropped", frame);
+		++fdump.num_dropped;
+		return;
+	}
+
+	if(fdump.queue.count == FRAMEDUMP_MAX_PENDING) {
+		framedump_retire_oldest(true);
+	}
+
+	uint idx = (fdump.queue.head + fdump.queue.count) % FRAMEDUMP_MAX_PENDING;
+	fdump.queue.tasks[idx] = task;
+	++fdump.queue.count;
+}
+
+static void framedump_y4m_write_header(uint width, uint height) {
+	fdump.width = width;
+	fdump.height = height;
+
+	char header[128];
+	snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C444\n",
+		width, height, fdump.fps_num, fdump.fps_den);
+
+	if(SDL_RWwrite(fdump.y4m_stream, header, strlen(header), 1) != 1) {
+		log_fatal("SDL_RWwrite() failed: %s", SDL_GetError());
+	}
+}
+
+static void framedump_frame_ready(Pixmap *image, void *userdata) {
+	uint frame = (uintptr_t)userdata;
+
+	if(!image) {
+		log_error("Failed to capture frame %u", frame);
+		++fdump.num_dropped;
+		return;
+	}
+
+	FrameDumpTaskData tdata = { .image = *image };
+	task_func_t callback;
+
+	if(fdump.y4m_stream) {
+		if(!fdump.width) {
+			framedump_y4m_write_header(image->width, image->height);
+		} else if(image->width != fdump.width || image->height != fdump.height) {
+			// Y4M streams can't change resolution midway
+			log_warn(
+				"Frame %u is %ux%u, but the stream is %ux%u; dropped",
+				frame, image->width, image->height, fdump.width, fdump.height
+			);
+			mem_free(image->data.untyped);
+			++fdump.num_dropped;
+			return;
+		}
+
+		callback = framedump_y4m_task;
+	} else {
+		tdata.dest_path = strfmt(FRAMEDUMP_MOUNTPOINT "/%06u.png", frame);
+		callback = framedump_png_task;
+	}
+
+	framedump_submit(taskmgr_global_submit((TaskParams) {
+		.callback = callback,
+		.userdata = memdup(&tdata, sizeof(tdata)),
+		.userdata_free_callback = framedump_free_task_data,
+	}), frame);
+}
+
+void framedump_frame(void) {
+	if(!fdump.active) {
+		return;
+	}
+
+	while(framedump_retire_oldest(false));
+
+	uint frame = fdump.num_requested++;
+	r_screenshot_async(framedump_frame_ready, (void*)(uintptr_t)frame);
+}
+
+void framedump_shutdown(void) {
+	if(!fdump.active) {
+		return;
+	}
+
+	r_screenshot_async_finish();
+	while(framedump_retire_oldest(true));
+
+	if(fdump.y4m_stream) {
+		SDL_RWclose(fdump.y4m_stream);
+	} else {
+		vfs_unmount(FRAMEDUMP_MOUNTPOINT);
+	}
+
+	log_info("Dumped %u frames (%u dropped)", fdump.num_written, fdump.num_dropped);
+	memset(&fdump, 0, sizeof(fdump));
+}
@@ -0,0 +1,29 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+/*
+ * Frame dumping (--dump-frames).
+ *
+ * Every presented frame is captured with r_screenshot_async() and encoded on the global task
+ * manager. If the destination path ends with ".y4m", the frames are written into a single raw
+ * YUV4MPEG2 stream (4:4:4, BT.601); otherwise the path is a directory that receives a numbered
+ * PNG sequence.
+ */
+
+// Does nothing if path is NULL. frameskip is used to derive the Y4M frame rate.
+void framedump_init(const char *path, int frameskip);
+
+// Waits for all pending frames to be written. Must be called before the task manager and the
+// renderer are shut down.
+void framedump_shutdown(void);
+
+// Requests a capture of the frame that is about to be presented.
+void framedump_frame(void);
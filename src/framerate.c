@@ -44,6 +44,20 @@ void fpscounter_update(FPSCounter *fps) {
 	fps->last_update_time = update_time;
 }
 
+static int cmp_hrtime(const void *a, const void *b) {
+	hrtime_t ta = *(const hrtime_t*)a;
+	hrtime_t tb = *(const hrtime_t*)b;
+	return (ta > tb) - (ta < tb);
+}
+
+hrtime_t fpscounter_percentile(const FPSCounter *fps, double p) {
+	const int log_size = ARRAY_SIZE(fps->frametimes);
+	hrtime_t sorted[log_size];
+	memcpy(sorted, fps->frametimes, sizeof(sorted));
+	qsort(sorted, log_size, sizeof(*sorted), cmp_hrtime);
+	return sorted[iclamp(ceil(p * log_size) - 1, 0, log_size - 1)];
+}
+
 uint32_t get_effective_frameskip(void) {
 	uint32_t frameskip;
 
@@ -21,3 +21,6 @@ typedef struct {
 uint32_t get_effective_frameskip(void);
 void fpscounter_reset(FPSCounter *fps);
 void fpscounter_update(FPSCounter *fps);
+
+// Frame time percentile (p in [0, 1]) over the logged frames.
+hrtime_t fpscounter_percentile(const FPSCounter *fps, double p);
@@ -21,9 +21,10 @@ void init_global(CLIAction *cli) {
 
 	global.frameskip = cli->frameskip;
 
-	if(cli->type == CLI_VerifyReplay) {
+	if(cli->type == CLI_VerifyReplay || cli->type == CLI_VerifyReplays) {
 		global.is_headless = true;
 		global.is_replay_verification = true;
+		global.is_replay_batch_verification = (cli->type == CLI_VerifyReplays);
 		global.frameskip = 1;
 	} else if(global.frameskip) {
 		log_warn("FPS limiter disabled. Gotta go fast! (frameskip = %i)", global.frameskip);
@@ -126,6 +126,7 @@ typedef struct {
 	uint is_practice_mode : 1;
 	uint is_headless : 1;
 	uint is_replay_verification : 1;
+	uint is_replay_batch_verification : 1;
 } Global;
 
 extern Global global;
@@ -0,0 +1,419 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "gpuparticles.h"
+
+#include "eventloop/eventloop.h"
+#include "global.h"
+#include "renderer/api.h"
+#include "util/glm.h"
+
+// Hint for how many instances to allocate per batch upfront.
+// The buffers will be dynamically resized on demand.
+#define EXPECTED_MAX_INSTANCES 1024
+
+// Past this, the oldest live particles start getting overwritten.
+#define MAX_INSTANCES 65536
+
+// How many slots to probe for a dead particle before appending a new one.
+#define ALLOC_PROBE_LIMIT 8
+
+#define BATCH_KEY_FLAGS (PFLAG_REQUIREDPARTICLE | PFLAG_NOREFLECT)
+
+// Must match interface/gpu_particle.glslh
+typedef struct GPUParticleInstance {
+	float pos_velocity[4];
+	float motion[4];         // acceleration.xy, retention, opacity
+	float timing[2];         // birth frame, lifetime
+	float rotation[4];       // angle, spin, align to motion (0 or 1), alignment offset
+	float rotation_axis[4];  // axis.xyz, image angle
+	float scale[4];          // scale0.xy, scale1.xy
+	float fade[4];           // opacity0, opacity1, opacity_exp, fadein
+	float rgba[4];
+	float texrect[4];
+	float dimensions[4];     // image size.xy, padding offset.xy (relative to image size)
+} GPUParticleInstance;
+
+typedef struct GPUParticleBatchKey {
+	Texture *texture;
+	ShaderProgram *shader;
+	BlendMode blend;
+	drawlayer_t layer;
+	ProjFlags flags;
+} GPUParticleBatchKey;
+
+typedef struct GPUParticleBatchData {
+	GPUParticleBatchKey key;
+	VertexBuffer *vbuf;
+	VertexArray *varr;
+	SDL_RWops *vbuf_stream;
+	Model quad;
+
+	// First frame on which each slot is free again
+	DYNAMIC_ARRAY(int) death_frames;
+	int max_death_frame;
+	uint cursor;
+} GPUParticleBatchData;
+
+static struct {
+	DYNAMIC_ARRAY(GPUParticleBatch*) batches;
+	GPUParticleBatch *last_batch;
+
+	struct {
+		ShaderProgram *basic;
+		ShaderProgram *bullet;
+	} shaders;
+} gparts;
+
+static void gpuparticles_batch_draw(EntityInterface *ent);
+
+void gpuparticles_preload(ResourceGroup *rg) {
+	res_group_preload(rg, RES_SHADER_PROGRAM, RESF_DEFAULT,
+		"gpu_particle",
+		"gpu_particle_bullet",
+	NULL);
+}
+
+void gpuparticles_init(void) {
+	gparts.shaders.basic = res_shader("gpu_particle");
+	gparts.shaders.bullet = res_shader("gpu_particle_bullet");
+}
+
+static void gpuparticles_batch_destroy(GPUParticleBatch *batch) {
+	GPUParticleBatchData *d = batch->data;
+	ent_unregister(&batch->ent);
+	r_vertex_array_destroy(d->varr);
+	r_vertex_buffer_destroy(d->vbuf);
+	dynarray_free_data(&d->death_frames);
+	mem_free(d);
+	mem_free(batch);
+}
+
+void gpuparticles_shutdown(void) {
+	dynarray_foreach_elem(&gparts.batches, GPUParticleBatch **batch, {
+		gpuparticles_batch_destroy(*batch);
+	});
+
+	dynarray_free_data(&gparts.batches);
+	gparts.last_batch = NULL;
+}
+
+static GPUParticleBatch *gpuparticles_batch_create(const GPUParticleBatchKey *key) {
+	size_t sz_vert = sizeof(GenericModelVertex);
+	size_t sz_attr = sizeof(GPUParticleInstance);
+
+	#define VERTEX_OFS(attr)   offsetof(GenericModelVertex,  attr)
+	#define INSTANCE_OFS(attr) offsetof(GPUParticleInstance, attr)
+
+	VertexAttribFormat fmt[] = {
+		// Per-vertex attributes (for the static models buffer, bound at 0)
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert, VERTEX_OFS(position),        0 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert, VERTEX_OFS(uv),              0 },
+
+		// Per-instance attributes (for our own buffer, bound at 1)
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(pos_velocity),  1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(motion),        1 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(timing),        1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(rotation),      1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(rotation_axis), 1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(scale),         1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(fade),          1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(rgba),          1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(texrect),       1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(dimensions),    1 },
+	};
+
+	#undef VERTEX_OFS
+	#undef INSTANCE_OFS
+
+	auto d = ALLOC(GPUParticleBatchData, {
+		.key = *key,
+	});
+
+	d->vbuf = r_vertex_buffer_create(sz_attr * EXPECTED_MAX_INSTANCES, NULL);
+	r_vertex_buffer_set_debug_label(d->vbuf, "GPU particles VB");
+	d->vbuf_stream = r_vertex_buffer_get_stream(d->vbuf);
+
+	d->varr = r_vertex_array_create();
+	r_vertex_array_set_debug_label(d->varr, "GPU particles VA");
+	r_vertex_array_attach_vertex_buffer(d->varr, r_vertex_buffer_static_models(), 0);
+	r_vertex_array_attach_vertex_buffer(d->varr, d->vbuf, 1);
+	r_vertex_array_layout(d->varr, ARRAY_SIZE(fmt), fmt);
+
+	d->quad = *r_model_get_quad();
+	d->quad.vertex_array = d->varr;
+
+	dynarray_ensure_capacity(&d->death_frames, EXPECTED_MAX_INSTANCES);
+
+	auto batch = ALLOC(GPUParticleBatch);
+	batch->data = d;
+	batch->flags = key->flags;
+	batch->ent.draw_layer = key->layer;
+	batch->ent.draw_func = gpuparticles_batch_draw;
+	batch->ent.draw_state = r_state_block(&(RenderStateBlockParams) {
+		.fields = RSB_SHADER | RSB_BLEND,
+		.shader = key->shader,
+		.blend = key->blend,
+	});
+	ent_register(&batch->ent, ENT_TYPE_ID(GPUParticleBatch));
+
+	*dynarray_append(&gparts.batches) = batch;
+	return batch;
+}
+
+static inline bool gpuparticles_batch_key_equal(const GPUParticleBatchKey *a, const GPUParticleBatchKey *b) {
+	// Not memcmp: the struct has padding, which isn't necessarily zeroed.
+	return
+		a->texture == b->texture &&
+		a->shader == b->shader &&
+		a->blend == b->blend &&
+		a->layer == b->layer &&
+		a->flags == b->flags;
+}
+
+static GPUParticleBatch *gpuparticles_get_batch(const GPUParticleBatchKey *key) {
+	if(gparts.last_batch && gpuparticles_batch_key_equal(&gparts.last_batch->data->key, key)) {
+		return gparts.last_batch;
+	}
+
+	GPUParticleBatch *batch = NULL;
+
+	dynarray_foreach_elem(&gparts.batches, GPUParticleBatch **pbatch, {
+		if(gpuparticles_batch_key_equal(&(*pbatch)->data->key, key)) {
+			batch = *pbatch;
+			break;
+		}
+	});
+
+	if(!batch) {
+		batch = gpuparticles_batch_create(key);
+	}
+
+	return (gparts.last_batch = batch);
+}
+
+// Trims dead particles off the end, so that we don't keep drawing them.
+static void gpuparticles_batch_trim(GPUParticleBatchData *d, int now) {
+	if(d->max_death_frame <= now) {
+		// Everything is dead; start over from the beginning of the buffer.
+		d->death_frames.num_elements = 0;
+	}
+
+	while(
+		d->death_frames.num_elements > 0 &&
+		dynarray_get(&d->death_frames, d->death_frames.num_elements - 1) <= now
+	) {
+		--d->death_frames.num_elements;
+	}
+
+	if(d->death_frames.num_elements == 0) {
+		d->cursor = 0;
+	} else {
+		d->cursor %= d->death_frames.num_elements;
+	}
+}
+
+// Finds a free slot, reusing dead particles where it's cheap to do so.
+static uint gpuparticles_batch_alloc_slot(GPUParticleBatchData *d, int death_frame) {
+	int now = global.frames;
+
+	// Also done when drawing, but a batch may go undrawn for a long time, e.g. while a
+	// replay is being fast-forwarded. Don't let it grow in the meantime.
+	gpuparticles_batch_trim(d, now);
+
+	uint num_slots = d->death_frames.num_elements;
+	uint slot;
+
+	for(uint i = 0; i < umin(num_slots, ALLOC_PROBE_LIMIT); ++i) {
+		slot = d->cursor;
+		d->cursor = (d->cursor + 1) % num_slots;
+
+		if(dynarray_get(&d->death_frames, slot) <= now) {
+			goto found;
+		}
+	}
+
+	if(num_slots < MAX_INSTANCES) {
+		slot = num_slots;
+		*dynarray_append(&d->death_frames) = death_frame;
+	} else {
+		slot = d->cursor;
+		d->cursor = (d->cursor + 1) % num_slots;
+	}
+
+found:
+	dynarray_set(&d->death_frames, slot, death_frame);
+	d->max_death_frame = imax(d->max_death_frame, death_frame);
+	return slot;
+}
+
+static void gpuparticles_process_args(GPUParticleArgs *args) {
+	if(args->sprite) {
+		args->sprite_ptr = prefix_get_sprite(args->sprite, "part/");
+	}
+
+	if(!args->shader_ptr) {
+		if(args->shader) {
+			args->shader_ptr = res_shader(args->shader);
+		} else {
+			args->shader_ptr = gparts.shaders.basic;
+		}
+	}
+
+	if(!args->color) {
+		args->color = RGB(1, 1, 1);
+	}
+
+	if(!args->blend) {
+		args->blend = BLEND_PREMUL_ALPHA;
+	}
+
+	if(!args->layer) {
+		args->layer = LAYER_PARTICLE_MID | 0x100;
+	}
+
+	if(args->anim.opacity_exp == 0) {
+		// zero-initialized; constant scale and opacity
+		args->anim = gpart_anim_scalefade(1+I, 1+I, 1, 1);
+	}
+
+	if(args->opacity == 0) {
+		args->opacity = 1;
+	}
+
+	assert(args->sprite_ptr != NULL);
+	assert(args->timeout > 0);
+	assert(args->move.attraction == 0);
+	assert(cimag(args->move.retention) == 0);
+	assert(!(args->flags & PFLAG_PLRSPECIALPARTICLE));
+
+	// The shader computes retention^age, which is undefined for negative retention.
+	args->move.retention = clamp(creal(args->move.retention), 0, 1);
+}
+
+void gpuparticles_spawn(GPUParticleArgs *args) {
+	if(IN_DRAW_CODE) {
+		log_fatal("Tried to spawn a particle while in drawing code");
+	}
+
+	if(!(args->flags & PFLAG_REQUIREDPARTICLE) && !config_get_int(CONFIG_PARTICLES)) {
+		// This batch wouldn't be drawn (see stage_should_draw_gpu_particles).
+		return;
+	}
+
+	gpuparticles_process_args(args);
+
+	Sprite *spr = args->sprite_ptr;
+	FloatExtent imgdims = spr->extent;
+	imgdims.as_cmplx -= spr->padding.extent.as_cmplx;
+
+	GPUParticleInstance inst = {
+		.pos_velocity = {
+			creal(args->pos), cimag(args->pos),
+			creal(args->move.velocity), cimag(args->move.velocity),
+		},
+		.motion = {
+			creal(args->move.acceleration), cimag(args->move.acceleration),
+			creal(args->move.retention),
+			args->opacity,
+		},
+		.timing = { global.frames, args->timeout },
+		.scale = {
+			crealf(args->anim.scale0), cimagf(args->anim.scale0),
+			crealf(args->anim.scale1), cimagf(args->anim.scale1),
+		},
+		.fade = {
+			args->anim.opacity0, args->anim.opacity1,
+			args->anim.opacity_exp,
+			args->anim.fadein,
+		},
+		.rgba = { args->color->r, args->color->g, args->color->b, args->color->a },
+		.texrect = { spr->tex_area.x, spr->tex_area.y, spr->tex_area.w, spr->tex_area.h },
+		.dimensions = {
+			imgdims.w, imgdims.h,
+			spr->padding.offset.x / imgdims.w, spr->padding.offset.y / imgdims.h,
+		},
+	};
+
+	float *axis = args->rotation_axis;
+
+	if(axis[0] == 0 && axis[1] == 0 && axis[2] == 0) {
+		bool manual = args->flags & PFLAG_MANUALANGLE;
+		inst.rotation[0] = args->angle + M_PI/2;
+		inst.rotation[1] = manual ? args->angle_delta : 0;
+		inst.rotation[2] = !manual;
+		inst.rotation[3] = args->angle_delta + M_PI/2;
+		glm_vec3_copy((vec3) { 0, 0, 1 }, inst.rotation_axis);
+	} else {
+		inst.rotation[0] = args->angle;
+		inst.rotation[1] = args->angle_delta;
+		glm_vec3_normalize_to(axis, inst.rotation_axis);
+	}
+
+	inst.rotation_axis[3] = args->image_angle;
+
+	GPUParticleBatchKey key = {
+		.texture = spr->tex,
+		.shader = args->shader_ptr,
+		.blend = args->blend,
+		.layer = args->layer,
+		.flags = args->flags & BATCH_KEY_FLAGS,
+	};
+
+	GPUParticleBatchData *d = gpuparticles_get_batch(&key)->data;
+
+	// The CPU version is drawn while frames - birthtime <= timeout, see proj_update().
+	int death_frame = global.frames + (int)ceilf(args->timeout + 1);
+	uint slot = gpuparticles_batch_alloc_slot(d, death_frame);
+
+	SDL_RWseek(d->vbuf_stream, slot * sizeof(inst), RW_SEEK_SET);
+	SDL_RWwrite(d->vbuf_stream, &inst, sizeof(inst), 1);
+}
+
+static void gpuparticles_batch_draw(EntityInterface *ent) {
+	GPUParticleBatchData *d = ENT_CAST(ent, GPUParticleBatch)->data;
+	int now = global.frames;
+
+	gpuparticles_batch_trim(d, now);
+
+	if(d->death_frames.num_elements == 0) {
+		return;
+	}
+
+	// NOTE: shader and blend mode are set through ent.draw_state by ent_draw()
+	r_disable(RCAP_CULL_FACE);
+	r_uniform_sampler("tex", d->key.texture);
+	r_uniform_float("time", now - 1 + eventloop_get_interpolation());
+	r_draw_model_ptr(&d->quad, d->death_frames.num_elements, 0);
+}
+
+GPUParticleAnim gpart_anim_scalefade_exp(
+	cmplxf scale0, cmplxf scale1, float opacity0, float opacity1, float opacity_exp
+) {
+	if(cimagf(scale0) == 0) {
+		scale0 = CMPLXF(crealf(scale0), crealf(scale0));
+	}
+
+	if(cimagf(scale1) == 0) {
+		scale1 = CMPLXF(crealf(scale1), crealf(scale1));
+	}
+
+	return (GPUParticleAnim) {
+		.scale0 = scale0,
+		.scale1 = scale1,
+		.opacity0 = opacity0,
+		.opacity1 = opacity1,
+		.opacity_exp = opacity_exp,
+	};
+}
+
+GPUParticleAnim gpart_anim_scalefade(cmplxf scale0, cmplxf scale1, float opacity0, float opacity1) {
+	return gpart_anim_scalefade_exp(scale0, scale1, opacity0, opacity1, 1.0f);
+}
@@ -0,0 +1,92 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "projectile.h"
+
+/*
+ * GPU-simulated cosmetic particles.
+ *
+ * These are fire-and-forget particles whose motion, rotation, scale and opacity are
+ * analytic functions of their age. Spawning one writes a single instance record into a
+ * vertex buffer; everything else is evaluated by the vertex shader (gpu_particle.vert)
+ * from the current frame number. There is no Projectile object, no per-frame update and
+ * no way to modify or kill a particle after it has been spawned.
+ *
+ * Particles are batched by sprite texture, shader, blend mode, draw layer, and the flags
+ * that affect visibility. Each batch is an entity drawn with a single instanced draw
+ * call, so draw layer ordering works as usual.
+ */
+
+DEFINE_ENTITY_TYPE(GPUParticleBatch, {
+	ProjFlags flags;
+	struct GPUParticleBatchData *data;
+});
+
+typedef struct GPUParticleAnim {
+	// Scale and opacity are interpolated linearly over the particle's lifetime.
+	// Opacity is then raised to opacity_exp and clamped to [0, 1].
+	cmplxf scale0, scale1;
+	float opacity0, opacity1;
+	float opacity_exp;
+
+	// Fraction of the lifetime over which the particle fades in; 0 for no fade-in.
+	float fadein;
+} GPUParticleAnim;
+
+typedef struct GPUParticleArgs {
+	const char *sprite;
+	Sprite *sprite_ptr;
+	const char *shader;  // gpu_particle (default) or gpu_particle_bullet
+	ShaderProgram *shader_ptr;
+	const Color *color;
+	cmplx pos;
+
+	// Only velocity, acceleration and a real retention are supported. Retention is clamped to [0, 1].
+	MoveParams move;
+
+	// Rotation follows the projectile convention (see projectile_sprite_params): the sprite
+	// is rotated by angle + π/2 around the Z axis, and unless PFLAG_MANUALANGLE is set, the
+	// angle follows the direction of motion.
+	// If rotation_axis is non-zero, the sprite is instead rotated by angle around that axis,
+	// and angle_delta is always added every frame.
+	float angle;
+	float angle_delta;
+	vec3 rotation_axis;
+
+	// Rotation of the sprite image in its own plane, applied before scaling.
+	float image_angle;
+
+	// Defaults to a constant scale and opacity of 1.
+	GPUParticleAnim anim;
+
+	// Base opacity; multiplies the animated one. Defaults to 1.
+	float opacity;
+
+	// Lifetime in frames. Required; GPU particles are never culled when off-screen.
+	float timeout;
+
+	// Only PFLAG_MANUALANGLE, PFLAG_NOREFLECT and PFLAG_REQUIREDPARTICLE are meaningful.
+	// Without PFLAG_REQUIREDPARTICLE, nothing is spawned while particles are disabled.
+	ProjFlags flags;
+	BlendMode blend;
+	drawlayer_t layer;
+} attr_designated_init GPUParticleArgs;
+
+void gpuparticles_preload(ResourceGroup *rg);
+void gpuparticles_init(void);
+void gpuparticles_shutdown(void);
+
+void gpuparticles_spawn(GPUParticleArgs *args) attr_nonnull_all;
+
+#define GPU_PARTICLE(...) gpuparticles_spawn(&(GPUParticleArgs) { __VA_ARGS__ })
+
+GPUParticleAnim gpart_anim_scalefade_exp(cmplxf scale0, cmplxf scale1, float opacity0, float opacity1, float opacity_exp);
+GPUParticleAnim gpart_anim_scalefade(cmplxf scale0, cmplxf scale1, float opacity0, float opacity1);
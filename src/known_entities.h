@@ -14,6 +14,7 @@
 #define ENTITIES_CORE(X, ...) \
 	X(Boss, __VA_ARGS__) \
 	X(Enemy, __VA_ARGS__) \
+	X(GPUParticleBatch, __VA_ARGS__) \
 	X(Item, __VA_ARGS__) \
 	X(Laser, __VA_ARGS__) \
 	X(Player, __VA_ARGS__) \
@@ -33,8 +33,12 @@
 #include "filewatch/filewatch.h"
 #include "dynstage.h"
 #include "eventloop/eventloop.h"
+#include "framedump.h"
+#include "pixmap/benchmark.h"
 #include "replay/demoplayer.h"
 #include "replay/tsrtool.h"
+#include "replay/verify.h"
+#include "resource/font_benchmark.h"
 
 attr_unused
 static void taisei_shutdown(void) {
@@ -45,6 +49,8 @@ static void taisei_shutdown(void) {
 		progress_save();
 	}
 
+	r_screenshot_async_finish();
+	framedump_shutdown();
 	r_release_resources();
 	res_shutdown();
 
@@ -222,6 +228,7 @@ typedef struct MainContext {
 	Replay *replay_in;
 	Replay *replay_out;
 	SDL_RWops *replay_out_stream;
+	char *verify_dir;
 	ResourceGroup rg;
 	int replay_idx;
 	uchar headless : 1;
@@ -231,7 +238,9 @@ static void main_post_vfsinit(CallChainResult ccr);
 static void main_mainmenu(CallChainResult ccr);
 static void main_singlestg(MainContext *mctx) attr_unused;
 static void main_replay(MainContext *mctx);
+static void main_verify_replays(MainContext *mctx);
 static noreturn void main_vfstree(CallChainResult ccr);
+static noreturn void main_bench_pixmaps(CallChainResult ccr);
 
 static void cleanup_replay(Replay **rpy) {
 	if(*rpy) {
@@ -248,6 +257,7 @@ static Replay *alloc_replay(void) {
 static noreturn void main_quit(MainContext *ctx, int status) {
 	res_group_release(&ctx->rg);
 	free_cli_action(&ctx->cli);
+	mem_free(ctx->verify_dir);
 
 	cleanup_replay(&ctx->replay_in);
 
@@ -342,9 +352,15 @@ int main(int argc, char **argv) {
 
 			ctx->replay_out = alloc_replay();
 		}
+	} else if(ctx->cli.type == CLI_VerifyReplays) {
+		stralloc(&ctx->verify_dir, ctx->cli.filename);
+		ctx->headless = true;
 	} else if(ctx->cli.type == CLI_DumpVFSTree) {
 		vfs_setup(CALLCHAIN(main_vfstree, ctx));
 		return 0; // NO main_quit here! vfs_setup may be asynchronous.
+	} else if(ctx->cli.type == CLI_BenchPixmaps) {
+		vfs_setup(CALLCHAIN(main_bench_pixmaps, ctx));
+		return 0;
 	}
 
 	log_info("Girls are now preparing, please wait warmly...");
@@ -386,6 +402,7 @@ static void main_post_vfsinit(CallChainResult ccr) {
 	filewatch_init();
 	res_init();
 	r_post_init();
+	framedump_init(ctx->cli.dump_frames, ctx->cli.frameskip);
 
 	res_group_init(&ctx->rg);
 
@@ -421,11 +438,20 @@ static void main_post_vfsinit(CallChainResult ccr) {
 		return;
 	}
 
+	if(ctx->cli.type == CLI_BenchText) {
+		main_quit(ctx, text_benchmark(2000) ? 0 : 1);
+	}
+
 	if(ctx->cli.type == CLI_PlayReplay || ctx->cli.type == CLI_VerifyReplay) {
 		main_replay(ctx);
 		return;
 	}
 
+	if(ctx->cli.type == CLI_VerifyReplays) {
+		main_verify_replays(ctx);
+		return;
+	}
+
 	if(ctx->cli.type == CLI_Credits) {
 		credits_enter(cc_cleanup);
 		eventloop_run();
@@ -550,6 +576,17 @@ static void main_replay(MainContext *mctx) {
 	eventloop_run();
 }
 
+static void main_verify_replays_done(CallChainResult ccr) {
+	MainContext *mctx = ccr.ctx;
+	int num_failed = (intptr_t)ccr.result;
+	main_quit(mctx, num_failed ? 1 : 0);
+}
+
+static void main_verify_replays(MainContext *mctx) {
+	replay_verify_dir(mctx->verify_dir, CALLCHAIN(main_verify_replays_done, mctx));
+	eventloop_run();
+}
+
 static void main_vfstree(CallChainResult ccr) {
 	MainContext *mctx = ccr.ctx;
 	SDL_RWops *rwops = SDL_RWFromFP(stdout, false);
@@ -568,3 +605,10 @@ static void main_vfstree(CallChainResult ccr) {
 	vfs_shutdown();
 	main_quit(mctx, status);
 }
+
+static void main_bench_pixmaps(CallChainResult ccr) {
+	MainContext *mctx = ccr.ctx;
+	int status = pixmap_benchmark(mctx->cli.filename, 5) ? 0 : 1;
+	vfs_shutdown();
+	main_quit(mctx, status);
+}
@@ -264,7 +264,7 @@ void draw_menu_list(MenuData *m, float x, float y, void (*draw)(MenuEntry*, int,
 		if(draw && i < m->entries.num_elements-1) {
 			draw(e, i, m->entries.num_elements, userdata);
 		} else if(e->name) {
-			text_draw(e->name, &(TextParams) {
+			text_layout_draw(e->layout, e->name, &(TextParams) {
 				.pos = { 20 - e->drawdata, 20*i },
 				.shader_ptr = text_shader,
 			});
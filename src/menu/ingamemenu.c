@@ -13,6 +13,7 @@
 #include "ingamemenu.h"
 #include "submenus.h"
 #include "global.h"
+#include "stage.h"
 #include "stagedraw.h"
 #include "video.h"
 #include "options.h"
@@ -137,6 +138,18 @@ static void skip_stage(MenuData *m, void *arg) {
 	menu_action_close(m, arg);
 }
 
+#define REPLAY_SEEK_STEP (FPS * 10)
+
+static void rewind_replay(MenuData *m, void *arg) {
+	stage_replay_seek(global.frames - REPLAY_SEEK_STEP);
+	menu_action_close(m, arg);
+}
+
+static void fast_forward_replay(MenuData *m, void *arg) {
+	stage_replay_seek(global.frames + REPLAY_SEEK_STEP);
+	menu_action_close(m, arg);
+}
+
 MenuData *create_ingame_menu_replay(void) {
 	MenuData *m = alloc_menu();
 
@@ -148,6 +161,8 @@ MenuData *create_ingame_menu_replay(void) {
 	m->context = "Replay Paused";
 	add_menu_entry(m, "Options", menu_action_enter_options, NULL)->transition = TransFadeBlack;
 	add_menu_entry(m, "Continue Watching", menu_action_close, NULL);
+	add_menu_entry(m, "Rewind 10 Seconds (Restarts Stage)", rewind_replay, NULL)->transition = TransFadeBlack;
+	add_menu_entry(m, "Skip 10 Seconds", fast_forward_replay, NULL);
 	add_menu_entry(m, "Restart the Stage", restart_game, NULL)->transition = TransFadeBlack;
 	add_menu_entry(m, "Skip the Stage", skip_stage, NULL)->transition = TransFadeBlack;
 	add_menu_entry(m, "Stop Watching", return_to_title, NULL)->transition = TransFadeBlack;
@@ -208,7 +223,7 @@ void draw_ingame_menu(MenuData *menu) {
 			r_color(RGBA_MUL_ALPHA(0.5, 0.5, 0.5, 0.5 * (1-menu_fade(menu))));
 		}
 
-		text_draw(e->name, &(TextParams) {
+		text_layout_draw(e->layout, e->name, &(TextParams) {
 			.align = ALIGN_CENTER,
 			.pos = { 0, i * 35 },
 		});
@@ -182,7 +182,7 @@ void draw_main_menu(MenuData *menu) {
 			r_color4(o, fmin(1, 0.7 + a) * o, fmin(1, 0.4 + a) * o, o);
 		}
 
-		text_draw(e->name, &(TextParams) {
+		text_layout_draw(e->layout, e->name, &(TextParams) {
 			.pos = { 50 - 15 * e->drawdata, 20 * (i - menu->drawdata[1]) },
 			.font = "standard",
 		});
@@ -18,6 +18,7 @@ MenuEntry *add_menu_entry(MenuData *menu, const char *name, MenuAction action, v
 	MenuEntry *e = dynarray_append(&menu->entries);
 
 	stralloc(&e->name, name);
+	e->layout = text_layout_new();
 	e->action = action;
 	e->arg = arg;
 	e->transition = menu->transition;
@@ -36,6 +37,7 @@ void free_menu(MenuData *menu) {
 
 	dynarray_foreach_elem(&menu->entries, MenuEntry *e, {
 		mem_free(e->name);
+		text_layout_free(e->layout);
 	});
 
 	dynarray_free_data(&menu->entries);
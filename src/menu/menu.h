@@ -13,6 +13,7 @@
 #include "events.h"
 #include "util/callchain.h"
 #include "dynarray.h"
+#include "resource/font.h"
 
 #define IMENU_BLUR 0.05
 
@@ -28,6 +29,7 @@ typedef void (*MenuProc)(MenuData*);
 
 typedef struct MenuEntry {
 	char *name;
+	TextLayout *layout;
 	MenuAction action;
 	void *arg;
 	float drawdata;
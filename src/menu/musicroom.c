@@ -83,7 +83,7 @@ static void musicroom_draw_item(MenuEntry *e, int i, int cnt, void *ctx) {
 	MusicEntryParam *p = e->arg;
 
 	if(!p) {
-		text_draw(e->name, &(TextParams) {
+		text_layout_draw(e->layout, e->name, &(TextParams) {
 			.pos = { 20 - e->drawdata, 20 * i },
 			.shader = "text_default",
 		});
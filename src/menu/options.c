@@ -986,7 +986,7 @@ static void options_draw_item(MenuEntry *e, int i, int cnt, void *ctx) {
 		color_mul_scalar(&clr, 0.5f);
 	}
 
-	text_draw(e->name, &(TextParams) {
+	text_layout_draw(e->layout, e->name, &(TextParams) {
 		.pos = { (1 + (bind ? bind->pad : 0)) * 20 - e->drawdata, 20*i },
 		.color = &clr,
 	});
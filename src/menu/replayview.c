@@ -16,6 +16,7 @@
 #include "plrmodes.h"
 #include "video.h"
 #include "common.h"
+#include "replay/index.h"
 #include "replay/state.h"
 #include "replay/struct.h"
 
@@ -81,12 +82,25 @@ static void start_replay(MenuData *menu, void *arg) {
 	}
 
 	Replay *rpy = ictx->replay;
+	Replay loaded = { };
 
-	if(!replay_load(rpy, ictx->replayname, REPLAY_READ_EVENTS)) {
+	// The menu entries may have been filled from the replay index, which doesn't cache
+	// everything needed for playback, so always reload the whole file.
+	if(!replay_load(&loaded, ictx->replayname, REPLAY_READ_ALL)) {
+		replay_reset(&loaded);
 		replayview_set_submenu(menu, replayview_sub_messagebox(menu, "Failed to load replay events"));
 		return;
 	}
 
+	replay_reset(rpy);
+	*rpy = loaded;
+
+	if(stagenum >= rpy->stages.num_elements) {
+		replay_destroy_events(rpy);
+		replayview_set_submenu(menu, replayview_sub_messagebox(menu, "The replay file has changed, please reopen the menu"));
+		return;
+	}
+
 	ReplayStage *stg = dynarray_get_ptr(&rpy->stages, stagenum);
 	char buf[64];
 
@@ -191,7 +205,7 @@ static void replayview_draw_messagebox(MenuData* m) {
 	float width  = text_width(res_font("standard"), e->name, 0) + 64;
 	replayview_draw_submenu_bg(width, height, alpha);
 
-	text_draw(e->name, &(TextParams) {
+	text_layout_draw(e->layout, e->name, &(TextParams) {
 		.align = ALIGN_CENTER,
 		.color = RGBA_MUL_ALPHA(0.9, 0.6, 0.2, alpha),
 		.pos = { SCREEN_W*0.5, SCREEN_H*0.5 },
@@ -222,7 +236,7 @@ static void replayview_draw_stagemenu(MenuData *m) {
 			clr = *RGBA_MUL_ALPHA(0.9 + ia * 0.1, 0.6 + ia * 0.4, 0.2 + ia * 0.8, (0.7 + 0.3 * a) * alpha);
 		}
 
-		text_draw(e->name, &(TextParams) {
+		text_layout_draw(e->layout, e->name, &(TextParams) {
 			.align = ALIGN_CENTER,
 			.pos = { 0, 20*i },
 			.color = &clr,
@@ -388,14 +402,24 @@ static int fill_replayview_menu(MenuData *m) {
 	char ext[5];
 	snprintf(ext, 5, ".%s", REPLAY_EXTENSION);
 
+	ReplayIndex index;
+	replay_index_load(&index);
+
 	while((filename = vfs_dir_read(dir))) {
 		if(!strendswith(filename, ext))
 			continue;
 
 		auto rpy = ALLOC(Replay);
-		if(!replay_load(rpy, filename, REPLAY_READ_META)) {
-			mem_free(rpy);
-			continue;
+		int64_t filesize = replay_index_query_filesize(filename);
+
+		if(!replay_index_lookup(&index, filename, filesize, rpy)) {
+			if(!replay_load(rpy, filename, REPLAY_READ_META)) {
+				replay_reset(rpy);
+				mem_free(rpy);
+				continue;
+			}
+
+			replay_index_update(&index, filename, filesize, rpy);
 		}
 
 		auto ictx = ALLOC(ReplayviewItemContext, {
@@ -409,6 +433,10 @@ static int fill_replayview_menu(MenuData *m) {
 
 	vfs_dir_close(dir);
 
+	replay_index_prune(&index);
+	replay_index_save(&index);
+	replay_index_unload(&index);
+
 	dynarray_qsort(&m->entries, replayview_cmp);
 
 	return rpys;
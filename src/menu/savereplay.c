@@ -80,7 +80,7 @@ static void draw_saverpy_menu(MenuData *m) {
 			clr = *RGBA_MUL_ALPHA(0.9 + ia * 0.1, 0.6 + ia * 0.4, 0.2 + ia * 0.8, 0.7 + 0.3 * a);
 		}
 
-		text_draw(e->name, &(TextParams) {
+		text_layout_draw(e->layout, e->name, &(TextParams) {
 			.font = "big",
 			.align = ALIGN_CENTER,
 			.pos = { -50 + 100 * i, 0 },
@@ -0,0 +1,177 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#include "taisei.h"
+
+#include "benchmark.h"
+#include "conversion_fast.h"
+#include "pixmap.h"
+
+#include "util.h"
+#include "vfs/public.h"
+
+typedef struct BenchOp {
+	const char *name;
+	PixmapFormat in_format;   // 0 = format of the image file
+	PixmapFormat out_format;  // 0 = in-place operation
+	void (*inplace)(Pixmap *px);
+	bool on_load_path;        // part of texture_loader_prepare_pixmaps for uncompressed images
+} BenchOp;
+
+static void bench_flip(Pixmap *px) {
+	pixmap_flip_y_inplace(px);
+}
+
+static void bench_swizzle(Pixmap *px) {
+	pixmap_swizzle_inplace(px, (SwizzleMask) { "bgra" });
+}
+
+static const BenchOp bench_ops[] = {
+	{ "native -> RGBA8",   0,                       PIXMAP_FORMAT_RGBA8,   .on_load_path = true },
+	{ "flip y",            0,                       0, bench_flip,         .on_load_path = true },
+	{ "swizzle RGBA8",     PIXMAP_FORMAT_RGBA8,     0, bench_swizzle },
+	{ "RGBA8 -> RGBA32F",  PIXMAP_FORMAT_RGBA8,     PIXMAP_FORMAT_RGBA32F },
+	{ "RGBA32F -> RGBA8",  PIXMAP_FORMAT_RGBA32F,   PIXMAP_FORMAT_RGBA8 },
+	{ "RGBA8 -> RGBA16F",  PIXMAP_FORMAT_RGBA8,     PIXMAP_FORMAT_RGBA16F },
+	{ "RGBA16F -> RGBA8",  PIXMAP_FORMAT_RGBA16F,   PIXMAP_FORMAT_RGBA8 },
+};
+
+typedef struct PixmapBenchmark {
+	int iterations;
+	uint num_images;
+	uint64_t num_pixels;
+	uint64_t decode_time;
+	// [0] = generic code, [1] = fast paths
+	uint64_t op_time[ARRAY_SIZE(bench_ops)][2];
+	uint op_mismatches[ARRAY_SIZE(bench_ops)];
+} PixmapBenchmark;
+
+static void bench_run_op(PixmapBenchmark *b, int op_idx, const Pixmap *image) {
+	const BenchOp *op = bench_ops + op_idx;
+	const Pixmap *in = image;
+	Pixmap tmp = { };
+	Pixmap results[2] = { };
+
+	if(op->in_format && op->in_format != image->format) {
+		pixmap_convert_alloc(image, &tmp, op->in_format);
+		in = &tmp;
+	}
+
+	for(int fast = 0; fast < 2; ++fast) {
+		Pixmap *res = results + fast;
+		pixmap_fastconv_set_enabled(fast);
+
+		if(op->out_format) {
+			res->data.untyped = pixmap_alloc_buffer_for_conversion(in, op->out_format, &res->data_size);
+		} else {
+			pixmap_copy_alloc(in, res);
+		}
+
+		for(int i = 0; i < b->iterations; ++i) {
+			uint64_t t = SDL_GetPerformanceCounter();
+
+			if(op->out_format) {
+				pixmap_convert(in, res, op->out_format);
+			} else {
+				op->inplace(res);
+			}
+
+			b->op_time[op_idx][fast] += SDL_GetPerformanceCounter() - t;
+		}
+	}
+
+	if(
+		results[0].data_size != results[1].data_size ||
+		memcmp(results[0].data.untyped, results[1].data.untyped, results[0].data_size)
+	) {
+		++b->op_mismatches[op_idx];
+	}
+
+	mem_free(results[0].data.untyped);
+	mem_free(results[1].data.untyped);
+	mem_free(tmp.data.untyped);
+}
+
+static void *bench_visit(const char *path, void *arg) {
+	PixmapBenchmark *b = arg;
+
+	if(!strendswith(path, ".png") && !strendswith(path, ".webp")) {
+		return NULL;
+	}
+
+	Pixmap image;
+	uint64_t t = SDL_GetPerformanceCounter();
+
+	if(!pixmap_load_file(path, &image, 0)) {
+		log_warn("%s: failed to load image, skipping", path);
+		return NULL;
+	}
+
+	b->decode_time += SDL_GetPerformanceCounter() - t;
+	b->num_pixels += image.width * image.height;
+	++b->num_images;
+
+	for(int i = 0; i < ARRAY_SIZE(bench_ops); ++i) {
+		bench_run_op(b, i, &image);
+	}
+
+	mem_free(image.data.untyped);
+	return NULL;
+}
+
+bool pixmap_benchmark(const char *path, int iterations) {
+	PixmapBenchmark b = { .iterations = imax(1, iterations) };
+	bool was_enabled = pixmap_fastconv_is_enabled();
+
+	vfs_dir_walk(path, bench_visit, &b);
+	pixmap_fastconv_set_enabled(was_enabled);
+
+	if(!b.num_images) {
+		log_error("No images found in %s", path);
+		return false;
+	}
+
+	double ms = 1e3 / SDL_GetPerformanceFrequency() / b.iterations;
+	double load_path[2] = { 0 };
+	bool ok = true;
+
+	tsfprintf(stdout, "%u images, %.1f megapixels, %d iteration(s); fast path implementation: %s\n\n",
+		b.num_images, b.num_pixels * 1e-6, b.iterations, pixmap_fastconv_impl_name());
+	tsfprintf(stdout, "%-18s %12s %12s %8s\n", "Operation", "Generic (ms)", "Fast (ms)", "Speedup");
+
+	for(int i = 0; i < ARRAY_SIZE(bench_ops); ++i) {
+		double generic = b.op_time[i][0] * ms;
+		double fast = b.op_time[i][1] * ms;
+
+		tsfprintf(stdout, "%-18s %12.2f %12.2f %7.2fx%s\n",
+			bench_ops[i].name, generic, fast, generic / fast,
+			b.op_mismatches[i] ? "  MISMATCH" : "");
+
+		if(bench_ops[i].on_load_path) {
+			load_path[0] += generic;
+			load_path[1] += fast;
+		}
+
+		ok = ok && !b.op_mismatches[i];
+	}
+
+	uint64_t f32_mismatches = pixmap_fastconv_verify_f32_to_u8();
+	tsfprintf(stdout, "\nf32 -> u8, all 2^32 inputs: %s (%"PRIu64" mismatches)\n",
+		f32_mismatches ? "MISMATCH" : "ok", f32_mismatches);
+	ok = ok && !f32_mismatches;
+
+	double decode = b.decode_time * 1e3 / SDL_GetPerformanceFrequency();
+
+	tsfprintf(stdout, "\nUncompressed texture load path (decode %.2f ms + convert + flip):\n", decode);
+	tsfprintf(stdout, "  generic: %.2f ms\n", decode + load_path[0]);
+	tsfprintf(stdout, "  fast:    %.2f ms (%.2f ms saved, %.1f%%)\n",
+		decode + load_path[1], load_path[0] - load_path[1],
+		100.0 * (load_path[0] - load_path[1]) / (decode + load_path[0]));
+
+	return ok;
+}
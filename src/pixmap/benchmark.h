@@ -0,0 +1,18 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#pragma once
+#include "taisei.h"
+
+// Loads every PNG and WebP image under the VFS directory `path` and measures the
+// pixmap conversions of the uncompressed texture loading path, with and without
+// the optimized kernels, then checks the f32 -> u8 kernel against the generic
+// code for every possible input. Prints a report to stdout. Returns false if no
+// images were found, or if the two implementations produced different results.
+bool pixmap_benchmark(const char *path, int iterations)
+	attr_nonnull_all;
@@ -9,9 +9,10 @@
 #include "taisei.h"
 
 #include "pixmap.h"
+#include "conversion_fast.h"
 #include "util.h"
 
-// NOTE: this is pretty stupid and not at all optimized, patches welcome
+// NOTE: this is the generic fallback; see conversion_fast.c for the optimized special cases
 
 #define _CONV_FUNCNAME	convert_u8_to_u8
 #define _CONV_IN_MAX	UINT8_MAX
@@ -178,6 +179,75 @@ static struct conversion_def* find_conversion(uint depth_in, uint depth_out) {
 	log_fatal("Pixmap conversion for %upbc -> %upbc undefined, please add", depth_in, depth_out);
 }
 
+static bool pixmap_format_is_half(PixmapFormat fmt) {
+	return PIXMAP_FORMAT_IS_FLOAT(fmt) && PIXMAP_FORMAT_DEPTH(fmt) == 16;
+}
+
+static void convert_pixels(
+	void *in, PixmapFormat in_format,
+	void *out, PixmapFormat out_format,
+	size_t num_pixels, int swizzle[4]
+);
+
+static void convert_pixels_half(
+	void *in, PixmapFormat in_format,
+	void *out, PixmapFormat out_format,
+	size_t num_pixels, int swizzle[4]
+) {
+	// 16-bit floats are converted through a temporary 32-bit float buffer
+	uint in_layout = PIXMAP_FORMAT_LAYOUT(in_format);
+	uint out_layout = PIXMAP_FORMAT_LAYOUT(out_format);
+	float *tmp_in = NULL;
+	float *tmp_out = NULL;
+
+	if(pixmap_format_is_half(in_format)) {
+		tmp_in = ALLOC_ARRAY(num_pixels * in_layout, float);
+		pixmap_fastconv_f16_to_f32(in, tmp_in, num_pixels * in_layout);
+		in = tmp_in;
+		in_format = PIXMAP_MAKE_FLOAT_FORMAT(in_layout, 32);
+	}
+
+	if(pixmap_format_is_half(out_format)) {
+		tmp_out = ALLOC_ARRAY(num_pixels * out_layout, float);
+		convert_pixels(in, in_format, tmp_out, PIXMAP_MAKE_FLOAT_FORMAT(out_layout, 32), num_pixels, swizzle);
+		pixmap_fastconv_f32_to_f16(tmp_out, out, num_pixels * out_layout);
+	} else {
+		convert_pixels(in, in_format, out, out_format, num_pixels, swizzle);
+	}
+
+	mem_free(tmp_in);
+	mem_free(tmp_out);
+}
+
+static void convert_pixels(
+	void *in, PixmapFormat in_format,
+	void *out, PixmapFormat out_format,
+	size_t num_pixels, int swizzle[4]
+) {
+	if(!swizzle && pixmap_fastconv_convert(in, out, num_pixels, in_format, out_format)) {
+		return;
+	}
+
+	if(pixmap_format_is_half(in_format) || pixmap_format_is_half(out_format)) {
+		convert_pixels_half(in, in_format, out, out_format, num_pixels, swizzle);
+		return;
+	}
+
+	struct conversion_def *cv = find_conversion(
+		PIXMAP_FORMAT_DEPTH(in_format) | (PIXMAP_FORMAT_IS_FLOAT(in_format) * DEPTH_FLOAT_BIT),
+		PIXMAP_FORMAT_DEPTH(out_format) | (PIXMAP_FORMAT_IS_FLOAT(out_format) * DEPTH_FLOAT_BIT)
+	);
+
+	cv->func(
+		PIXMAP_FORMAT_LAYOUT(in_format),
+		PIXMAP_FORMAT_LAYOUT(out_format),
+		num_pixels,
+		in,
+		out,
+		swizzle
+	);
+}
+
 static void pixmap_copy_meta(const Pixmap *src, Pixmap *dst) {
 	dst->format = src->format;
 	dst->width = src->width;
@@ -216,20 +286,7 @@ void pixmap_convert(const Pixmap *src, Pixmap *dst, PixmapFormat format) {
 	}
 
 	dst->format = format;
-
-	struct conversion_def *cv = find_conversion(
-		PIXMAP_FORMAT_DEPTH(src->format) | (PIXMAP_FORMAT_IS_FLOAT(src->format) * DEPTH_FLOAT_BIT),
-		PIXMAP_FORMAT_DEPTH(dst->format) | (PIXMAP_FORMAT_IS_FLOAT(dst->format) * DEPTH_FLOAT_BIT)
-	);
-
-	cv->func(
-		PIXMAP_FORMAT_LAYOUT(src->format),
-		PIXMAP_FORMAT_LAYOUT(dst->format),
-		num_pixels,
-		src->data.untyped,
-		dst->data.untyped,
-		NULL
-	);
+	convert_pixels(src->data.untyped, src->format, dst->data.untyped, format, num_pixels, NULL);
 }
 
 static int swizzle_idx(char s) {
@@ -252,22 +309,20 @@ void pixmap_swizzle_inplace(Pixmap *px, SwizzleMask swizzle) {
 		return;
 	}
 
-	uint cvt_id = pixmap_format_depth(px->format) | (pixmap_format_is_float(px->format) * DEPTH_FLOAT_BIT);
-	struct conversion_def *cv = find_conversion(cvt_id, cvt_id);
+	int swizzle_indices[] = {
+		swizzle_idx(swizzle.r),
+		swizzle_idx(swizzle.g),
+		swizzle_idx(swizzle.b),
+		swizzle_idx(swizzle.a),
+	};
 
-	cv->func(
-		channels,
-		channels,
-		px->width * px->height,
-		px->data.untyped,
-		px->data.untyped,
-		(int[]) {
-			swizzle_idx(swizzle.r),
-			swizzle_idx(swizzle.g),
-			swizzle_idx(swizzle.b),
-			swizzle_idx(swizzle.a),
-		}
-	);
+	size_t num_pixels = px->width * px->height;
+
+	if(pixmap_fastconv_swizzle_inplace(px->data.untyped, num_pixels, px->format, swizzle_indices)) {
+		return;
+	}
+
+	convert_pixels(px->data.untyped, px->format, px->data.untyped, px->format, num_pixels, swizzle_indices);
 }
 
 void pixmap_convert_alloc(const Pixmap *src, Pixmap *dst, PixmapFormat format) {
@@ -323,12 +378,9 @@ void pixmap_flip_y_inplace(Pixmap *src) {
 	}
 
 	char *data = src->data.untyped;
-	char swap_buffer[row_length];
 
 	for(size_t row = 0; row < rows / 2; ++row) {
-		memcpy(swap_buffer, data + row * row_length, row_length);
-		memcpy(data + row * row_length, data + (rows - row - 1) * row_length, row_length);
-		memcpy(data + (rows - row - 1) * row_length, swap_buffer, row_length);
+		pixmap_fastconv_swap(data + row * row_length, data + (rows - row - 1) * row_length, row_length);
 	}
 }
 
@@ -0,0 +1,564 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#include "taisei.h"
+
+#include "conversion_fast.h"
+#include "util.h"
+
+#include <SDL.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define FASTCONV_X86 1
+	#include <cpuid.h>
+	#include <immintrin.h>
+#else
+	#define FASTCONV_X86 0
+#endif
+
+typedef struct FastConvKernels {
+	const char *name;
+	void (*rgb8_to_rgba8)(const uint8_t *restrict in, uint8_t *restrict out, size_t num_pixels);
+	void (*swizzle_rgba8)(uint8_t *data, size_t num_pixels, const int swizzle[4]);
+	void (*u8_to_f32)(const uint8_t *restrict in, float *restrict out, size_t num_elements);
+	void (*f32_to_u8)(const float *restrict in, uint8_t *restrict out, size_t num_elements);
+	void (*f32_to_f16)(const float *restrict in, uint16_t *restrict out, size_t num_elements);
+	void (*f16_to_f32)(const uint16_t *restrict in, float *restrict out, size_t num_elements);
+	void (*swap)(void *restrict a, void *restrict b, size_t size);
+} FastConvKernels;
+
+enum {
+	FASTCONV_UNINITIALIZED,
+	FASTCONV_INITIALIZING,
+	FASTCONV_READY,
+};
+
+static struct {
+	FastConvKernels kernels;
+	uint16_t u8_to_f16_table[256];
+	SDL_atomic_t state;
+	SDL_atomic_t enabled;
+} fastconv;
+
+/*
+ * Portable implementations
+ */
+
+static inline uint8_t f32_to_u8_scalar(float v) {
+	// must match the generic conversion code, including NaN -> 0
+	return LIKELY(v == v) ? (uint8_t)roundf(clampf(v, 0.0f, 1.0f) * (float)UINT8_MAX) : 0;
+}
+
+// Based on public domain code by Fabian Giesen
+static inline uint16_t f32_to_f16_scalar(float f) {
+	const uint32_t f16_max = (127 + 16) << 23;
+	const uint32_t f32_inf = 255 << 23;
+	const uint32_t denorm_magic = ((127 - 15) + (23 - 10) + 1) << 23;
+
+	uint32_t x = UNION_CAST(float, uint32_t, f);
+	uint32_t sign = x & 0x80000000u;
+	uint16_t o;
+	x ^= sign;
+
+	if(x >= f16_max) {
+		// overflow to infinity, or NaN
+		o = (x > f32_inf) ? 0x7e00 : 0x7c00;
+	} else if(x < (113 << 23)) {
+		// zero or subnormal; let the FPU do the rounding
+		float d = UNION_CAST(uint32_t, float, x) + UNION_CAST(uint32_t, float, denorm_magic);
+		o = UNION_CAST(float, uint32_t, d) - denorm_magic;
+	} else {
+		uint32_t mant_odd = (x >> 13) & 1;
+		x += ((uint32_t)(15 - 127) << 23) + 0xfff;
+		x += mant_odd;
+		o = x >> 13;
+	}
+
+	return o | (sign >> 16);
+}
+
+static inline float f16_to_f32_scalar(uint16_t h) {
+	const uint32_t shifted_exp = 0x7c00u << 13;
+	const float magic = UNION_CAST(uint32_t, float, 113u << 23);
+
+	uint32_t o = (h & 0x7fffu) << 13;
+	uint32_t exp = shifted_exp & o;
+	o += (127u - 15u) << 23;
+
+	if(exp == shifted_exp) {
+		// infinity or NaN
+		o += (128u - 16u) << 23;
+	} else if(exp == 0) {
+		// zero or subnormal
+		o += 1u << 23;
+		o = UNION_CAST(float, uint32_t, UNION_CAST(uint32_t, float, o) - magic);
+	}
+
+	o |= (uint32_t)(h & 0x8000u) << 16;
+	return UNION_CAST(uint32_t, float, o);
+}
+
+static void rgb8_to_rgba8_generic(const uint8_t *restrict in, uint8_t *restrict out, size_t num_pixels) {
+	for(const uint8_t *end = in + num_pixels * 3; in < end; in += 3, out += 4) {
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		out[3] = UINT8_MAX;
+	}
+}
+
+static void swizzle_rgba8_generic(uint8_t *data, size_t num_pixels, const int swizzle[4]) {
+	// R  G  B  A  const-0  const-1
+	uint8_t px[6] = { 0, 0, 0, 0, 0, UINT8_MAX };
+	int s0 = swizzle[0], s1 = swizzle[1], s2 = swizzle[2], s3 = swizzle[3];
+
+	for(uint8_t *end = data + num_pixels * 4; data < end; data += 4) {
+		memcpy(px, data, 4);
+		data[0] = px[s0];
+		data[1] = px[s1];
+		data[2] = px[s2];
+		data[3] = px[s3];
+	}
+}
+
+static void u8_to_f32_generic(const uint8_t *restrict in, float *restrict out, size_t num_elements) {
+	for(size_t i = 0; i < num_elements; ++i) {
+		out[i] = in[i] * (1.0f / (float)UINT8_MAX);
+	}
+}
+
+static void f32_to_u8_generic(const float *restrict in, uint8_t *restrict out, size_t num_elements) {
+	for(size_t i = 0; i < num_elements; ++i) {
+		out[i] = f32_to_u8_scalar(in[i]);
+	}
+}
+
+static void f32_to_f16_generic(const float *restrict in, uint16_t *restrict out, size_t num_elements) {
+	for(size_t i = 0; i < num_elements; ++i) {
+		out[i] = f32_to_f16_scalar(in[i]);
+	}
+}
+
+static void f16_to_f32_generic(const uint16_t *restrict in, float *restrict out, size_t num_elements) {
+	for(size_t i = 0; i < num_elements; ++i) {
+		out[i] = f16_to_f32_scalar(in[i]);
+	}
+}
+
+static void swap_generic(void *restrict a, void *restrict b, size_t size) {
+	char buf[256];
+	char *ca = a, *cb = b;
+
+	while(size > 0) {
+		size_t chunk = umin(size, sizeof(buf));
+		memcpy(buf, ca, chunk);
+		memcpy(ca, cb, chunk);
+		memcpy(cb, buf, chunk);
+		ca += chunk;
+		cb += chunk;
+		size -= chunk;
+	}
+}
+
+/*
+ * x86 implementations
+ */
+
+#if FASTCONV_X86
+
+attr_target("sse2")
+static void u8_to_f32_sse2(const uint8_t *restrict in, float *restrict out, size_t num_elements) {
+	const __m128 scale = _mm_set1_ps(1.0f / (float)UINT8_MAX);
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+
+	for(; i + 16 <= num_elements; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+
+		_mm_storeu_ps(out + i +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+		_mm_storeu_ps(out + i +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+		_mm_storeu_ps(out + i +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+		_mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+	}
+
+	u8_to_f32_generic(in + i, out + i, num_elements - i);
+}
+
+attr_target("sse2")
+static inline __m128i f32x4_to_i32x4_unorm8_sse2(const float *in) {
+	// NOTE: max_ps returns the second operand if the first is NaN, so NaNs become 0
+	__m128 v = _mm_max_ps(_mm_loadu_ps(in), _mm_setzero_ps());
+	v = _mm_min_ps(v, _mm_set1_ps(1.0f));
+	v = _mm_mul_ps(v, _mm_set1_ps((float)UINT8_MAX));
+
+	// Round half away from zero, like roundf(). Adding 0.5 before truncating is not
+	// equivalent: the sum itself is rounded, e.g. 0.49999997f + 0.5f == 1.0f.
+	// For 0 <= v < 2^23, v - trunc(v) is exact.
+	__m128i i = _mm_cvttps_epi32(v);
+	__m128 frac = _mm_sub_ps(v, _mm_cvtepi32_ps(i));
+	__m128 round_up = _mm_cmpge_ps(frac, _mm_set1_ps(0.5f));
+	return _mm_sub_epi32(i, _mm_castps_si128(round_up));
+}
+
+attr_target("sse2")
+static void f32_to_u8_sse2(const float *restrict in, uint8_t *restrict out, size_t num_elements) {
+	size_t i = 0;
+
+	for(; i + 16 <= num_elements; i += 16) {
+		__m128i a = f32x4_to_i32x4_unorm8_sse2(in + i +  0);
+		__m128i b = f32x4_to_i32x4_unorm8_sse2(in + i +  4);
+		__m128i c = f32x4_to_i32x4_unorm8_sse2(in + i +  8);
+		__m128i d = f32x4_to_i32x4_unorm8_sse2(in + i + 12);
+		__m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+		_mm_storeu_si128((__m128i*)(out + i), v);
+	}
+
+	f32_to_u8_generic(in + i, out + i, num_elements - i);
+}
+
+attr_target("sse2")
+static void swap_sse2(void *restrict a, void *restrict b, size_t size) {
+	uint8_t *ca = a, *cb = b;
+
+	for(; size >= 32; size -= 32, ca += 32, cb += 32) {
+		__m128i a0 = _mm_loadu_si128((const __m128i*)(ca +  0));
+		__m128i a1 = _mm_loadu_si128((const __m128i*)(ca + 16));
+		__m128i b0 = _mm_loadu_si128((const __m128i*)(cb +  0));
+		__m128i b1 = _mm_loadu_si128((const __m128i*)(cb + 16));
+		_mm_storeu_si128((__m128i*)(ca +  0), b0);
+		_mm_storeu_si128((__m128i*)(ca + 16), b1);
+		_mm_storeu_si128((__m128i*)(cb +  0), a0);
+		_mm_storeu_si128((__m128i*)(cb + 16), a1);
+	}
+
+	swap_generic(ca, cb, size);
+}
+
+attr_target("ssse3")
+static void rgb8_to_rgba8_ssse3(const uint8_t *restrict in, uint8_t *restrict out, size_t num_pixels) {
+	const __m128i shuf = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+	size_t i = 0;
+
+	// 16 pixels per iteration: 48 bytes in, 64 bytes out
+	for(; i + 16 <= num_pixels; i += 16, in += 48, out += 64) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(in +  0));
+		__m128i b = _mm_loadu_si128((const __m128i*)(in + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*)(in + 32));
+
+		__m128i p0 = a;                          // bytes  0..11
+		__m128i p1 = _mm_alignr_epi8(b, a, 12);  // bytes 12..23
+		__m128i p2 = _mm_alignr_epi8(c, b, 8);   // bytes 24..35
+		__m128i p3 = _mm_srli_si128(c, 4);       // bytes 36..47
+
+		_mm_storeu_si128((__m128i*)(out +  0), _mm_or_si128(_mm_shuffle_epi8(p0, shuf), alpha));
+		_mm_storeu_si128((__m128i*)(out + 16), _mm_or_si128(_mm_shuffle_epi8(p1, shuf), alpha));
+		_mm_storeu_si128((__m128i*)(out + 32), _mm_or_si128(_mm_shuffle_epi8(p2, shuf), alpha));
+		_mm_storeu_si128((__m128i*)(out + 48), _mm_or_si128(_mm_shuffle_epi8(p3, shuf), alpha));
+	}
+
+	rgb8_to_rgba8_generic(in, out, num_pixels - i);
+}
+
+attr_target("ssse3")
+static void swizzle_rgba8_ssse3(uint8_t *data, size_t num_pixels, const int swizzle[4]) {
+	int8_t shuf[16];
+	uint8_t ones[16];
+
+	for(int p = 0; p < 4; ++p) {
+		for(int c = 0; c < 4; ++c) {
+			int s = swizzle[c];
+			shuf[p * 4 + c] = s < 4 ? p * 4 + s : -1;
+			ones[p * 4 + c] = s == 5 ? UINT8_MAX : 0;
+		}
+	}
+
+	const __m128i vshuf = _mm_loadu_si128((const __m128i*)shuf);
+	const __m128i vones = _mm_loadu_si128((const __m128i*)ones);
+	size_t i = 0;
+
+	for(; i + 4 <= num_pixels; i += 4, data += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)data);
+		v = _mm_or_si128(_mm_shuffle_epi8(v, vshuf), vones);
+		_mm_storeu_si128((__m128i*)data, v);
+	}
+
+	swizzle_rgba8_generic(data, num_pixels - i, swizzle);
+}
+
+attr_target("f16c")
+static void f32_to_f16_f16c(const float *restrict in, uint16_t *restrict out, size_t num_elements) {
+	size_t i = 0;
+
+	for(; i + 4 <= num_elements; i += 4) {
+		__m128i h = _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storel_epi64((__m128i*)(out + i), h);
+	}
+
+	f32_to_f16_generic(in + i, out + i, num_elements - i);
+}
+
+attr_target("f16c")
+static void f16_to_f32_f16c(const uint16_t *restrict in, float *restrict out, size_t num_elements) {
+	size_t i = 0;
+
+	for(; i + 4 <= num_elements; i += 4) {
+		__m128 f = _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(in + i)));
+		_mm_storeu_ps(out + i, f);
+	}
+
+	f16_to_f32_generic(in + i, out + i, num_elements - i);
+}
+
+static uint cpuid_features_ecx(void) {
+	uint eax, ebx, ecx, edx;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return 0;
+	}
+
+	return ecx;
+}
+
+#endif  // FASTCONV_X86
+
+static void select_kernels(FastConvKernels *k) {
+	*k = (FastConvKernels) {
+		.name = "generic",
+		.rgb8_to_rgba8 = rgb8_to_rgba8_generic,
+		.swizzle_rgba8 = swizzle_rgba8_generic,
+		.u8_to_f32 = u8_to_f32_generic,
+		.f32_to_u8 = f32_to_u8_generic,
+		.f32_to_f16 = f32_to_f16_generic,
+		.f16_to_f32 = f16_to_f32_generic,
+		.swap = swap_generic,
+	};
+
+#if FASTCONV_X86
+	// NOTE: SDL doesn't report SSSE3 and F16C, so query those ourselves
+	uint ecx = cpuid_features_ecx();
+
+	if(SDL_HasSSE2()) {
+		k->name = "sse2";
+		k->u8_to_f32 = u8_to_f32_sse2;
+		k->f32_to_u8 = f32_to_u8_sse2;
+		k->swap = swap_sse2;
+	}
+
+	if(ecx & bit_SSSE3) {
+		k->name = "ssse3";
+		k->rgb8_to_rgba8 = rgb8_to_rgba8_ssse3;
+		k->swizzle_rgba8 = swizzle_rgba8_ssse3;
+	}
+
+	// F16C instructions are VEX-encoded, so they also need OS support for AVX
+	if((ecx & bit_F16C) && SDL_HasAVX()) {
+		k->f32_to_f16 = f32_to_f16_f16c;
+		k->f16_to_f32 = f16_to_f32_f16c;
+	}
+#endif
+}
+
+static const FastConvKernels *get_kernels(void) {
+	if(LIKELY(SDL_AtomicGet(&fastconv.state) == FASTCONV_READY)) {
+		return &fastconv.kernels;
+	}
+
+	if(SDL_AtomicCAS(&fastconv.state, FASTCONV_UNINITIALIZED, FASTCONV_INITIALIZING)) {
+		select_kernels(&fastconv.kernels);
+
+		for(uint i = 0; i < ARRAY_SIZE(fastconv.u8_to_f16_table); ++i) {
+			fastconv.u8_to_f16_table[i] = f32_to_f16_scalar(i * (1.0f / (float)UINT8_MAX));
+		}
+
+		SDL_AtomicSet(&fastconv.enabled, env_get("TAISEI_PIXMAP_FASTPATHS", true));
+		SDL_AtomicSet(&fastconv.state, FASTCONV_READY);
+		log_debug("Using %s pixmap conversion kernels", fastconv.kernels.name);
+	} else {
+		// another thread got here first; it won't take long
+		while(SDL_AtomicGet(&fastconv.state) != FASTCONV_READY);
+	}
+
+	return &fastconv.kernels;
+}
+
+static const FastConvKernels *get_enabled_kernels(void) {
+	const FastConvKernels *k = get_kernels();
+	return SDL_AtomicGet(&fastconv.enabled) ? k : NULL;
+}
+
+void pixmap_fastconv_set_enabled(bool enabled) {
+	get_kernels();
+	SDL_AtomicSet(&fastconv.enabled, enabled);
+}
+
+bool pixmap_fastconv_is_enabled(void) {
+	return get_enabled_kernels();
+}
+
+const char *pixmap_fastconv_impl_name(void) {
+	return get_kernels()->name;
+}
+
+uint64_t pixmap_fastconv_verify_f32_to_u8(void) {
+	const FastConvKernels *k = get_kernels();
+	float in[4096];
+	uint8_t out_fast[ARRAY_SIZE(in)];
+	uint8_t out_generic[ARRAY_SIZE(in)];
+	uint64_t mismatches = 0;
+	uint64_t bits = 0;
+
+	do {
+		for(uint i = 0; i < ARRAY_SIZE(in); ++i) {
+			in[i] = UNION_CAST(uint32_t, float, (uint32_t)(bits + i));
+		}
+
+		k->f32_to_u8(in, out_fast, ARRAY_SIZE(in));
+		f32_to_u8_generic(in, out_generic, ARRAY_SIZE(in));
+
+		for(uint i = 0; i < ARRAY_SIZE(in); ++i) {
+			if(UNLIKELY(out_fast[i] != out_generic[i])) {
+				if(!mismatches) {
+					log_warn("f32 -> u8 mismatch for %08x: %s kernel gives %u, generic code gives %u",
+						(uint32_t)(bits + i), k->name, out_fast[i], out_generic[i]);
+				}
+
+				++mismatches;
+			}
+		}
+
+		bits += ARRAY_SIZE(in);
+	} while(bits <= UINT32_MAX);
+
+	return mismatches;
+}
+
+typedef enum ElementType {
+	ELEM_OTHER,
+	ELEM_U8,
+	ELEM_F16,
+	ELEM_F32,
+} ElementType;
+
+static ElementType element_type(PixmapFormat fmt) {
+	if(pixmap_format_is_compressed(fmt)) {
+		return ELEM_OTHER;
+	}
+
+	switch(PIXMAP_FORMAT_DEPTH(fmt) | (PIXMAP_FORMAT_IS_FLOAT(fmt) << 8)) {
+		case 8:          return ELEM_U8;
+		case 16 | 0x100: return ELEM_F16;
+		case 32 | 0x100: return ELEM_F32;
+		default:         return ELEM_OTHER;
+	}
+}
+
+static void f16_to_u8(const FastConvKernels *k, const uint16_t *in, uint8_t *out, size_t num_elements) {
+	float buf[256];
+
+	while(num_elements > 0) {
+		size_t chunk = umin(num_elements, ARRAY_SIZE(buf));
+		k->f16_to_f32(in, buf, chunk);
+		k->f32_to_u8(buf, out, chunk);
+		in += chunk;
+		out += chunk;
+		num_elements -= chunk;
+	}
+}
+
+bool pixmap_fastconv_convert(
+	const void *in, void *out, size_t num_pixels, PixmapFormat in_format, PixmapFormat out_format
+) {
+	const FastConvKernels *k = get_enabled_kernels();
+
+	if(!k) {
+		return false;
+	}
+
+	if(in_format == PIXMAP_FORMAT_RGB8 && out_format == PIXMAP_FORMAT_RGBA8) {
+		k->rgb8_to_rgba8(in, out, num_pixels);
+		return true;
+	}
+
+	uint layout = PIXMAP_FORMAT_LAYOUT(in_format);
+
+	if(layout != PIXMAP_FORMAT_LAYOUT(out_format)) {
+		return false;
+	}
+
+	// With identical layouts, everything else is a flat array conversion
+	size_t num_elements = num_pixels * layout;
+	ElementType in_type = element_type(in_format);
+	ElementType out_type = element_type(out_format);
+
+	if(in_type == ELEM_U8 && out_type == ELEM_F32) {
+		k->u8_to_f32(in, out, num_elements);
+	} else if(in_type == ELEM_F32 && out_type == ELEM_U8) {
+		k->f32_to_u8(in, out, num_elements);
+	} else if(in_type == ELEM_F32 && out_type == ELEM_F16) {
+		k->f32_to_f16(in, out, num_elements);
+	} else if(in_type == ELEM_F16 && out_type == ELEM_F32) {
+		k->f16_to_f32(in, out, num_elements);
+	} else if(in_type == ELEM_F16 && out_type == ELEM_U8) {
+		f16_to_u8(k, in, out, num_elements);
+	} else if(in_type == ELEM_U8 && out_type == ELEM_F16) {
+		const uint8_t *bin = in;
+		uint16_t *bout = out;
+
+		for(size_t i = 0; i < num_elements; ++i) {
+			bout[i] = fastconv.u8_to_f16_table[bin[i]];
+		}
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+bool pixmap_fastconv_swizzle_inplace(void *data, size_t num_pixels, PixmapFormat format, const int swizzle[4]) {
+	const FastConvKernels *k = get_enabled_kernels();
+
+	if(!k || format != PIXMAP_FORMAT_RGBA8) {
+		return false;
+	}
+
+	k->swizzle_rgba8(data, num_pixels, swizzle);
+	return true;
+}
+
+void pixmap_fastconv_swap(void *a, void *b, size_t size) {
+	const FastConvKernels *k = get_enabled_kernels();
+
+	if(k) {
+		k->swap(a, b, size);
+	} else {
+		swap_generic(a, b, size);
+	}
+}
+
+void pixmap_fastconv_f32_to_f16(const float *in, uint16_t *out, size_t num_elements) {
+	const FastConvKernels *k = get_enabled_kernels();
+
+	if(k) {
+		k->f32_to_f16(in, out, num_elements);
+	} else {
+		f32_to_f16_generic(in, out, num_elements);
+	}
+}
+
+void pixmap_fastconv_f16_to_f32(const uint16_t *in, float *out, size_t num_elements) {
+	const FastConvKernels *k = get_enabled_kernels();
+
+	if(k) {
+		k->f16_to_f32(in, out, num_elements);
+	} else {
+		f16_to_f32_generic(in, out, num_elements);
+	}
+}
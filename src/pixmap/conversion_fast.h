@@ -0,0 +1,53 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#pragma once
+#include "taisei.h"
+
+#include "pixmap.h"
+
+/*
+ * Optimized kernels for the pixmap conversions that are common on the texture
+ * loading path. The best implementation for the host CPU (SSSE3, SSE2, or
+ * portable C) is selected at runtime, on first use.
+ *
+ * The functions returning bool return false if there's no fast path for the
+ * given parameters, or if fast paths are disabled. The caller must then fall
+ * back to the generic conversion code.
+ */
+
+bool pixmap_fastconv_convert(
+	const void *in, void *out, size_t num_pixels, PixmapFormat in_format, PixmapFormat out_format
+) attr_nonnull_all;
+
+// swizzle[i] is the source channel of the ith output channel: 0-3 for RGBA, 4 for 0, 5 for 1.
+bool pixmap_fastconv_swizzle_inplace(void *data, size_t num_pixels, PixmapFormat format, const int swizzle[4])
+	attr_nonnull_all;
+
+// Exchanges the contents of two non-overlapping memory regions.
+void pixmap_fastconv_swap(void *a, void *b, size_t size)
+	attr_nonnull_all;
+
+// Elementwise conversions between float and IEEE 754 binary16 (round to nearest even).
+// Always available, regardless of whether fast paths are enabled.
+void pixmap_fastconv_f32_to_f16(const float *in, uint16_t *out, size_t num_elements)
+	attr_nonnull_all;
+void pixmap_fastconv_f16_to_f32(const uint16_t *in, float *out, size_t num_elements)
+	attr_nonnull_all;
+
+// Fast paths are enabled by default, unless TAISEI_PIXMAP_FASTPATHS=0 is set.
+void pixmap_fastconv_set_enabled(bool enabled);
+bool pixmap_fastconv_is_enabled(void);
+
+// Runs the selected f32 -> u8 kernel on every 32-bit float pattern and compares the
+// results against the portable code. Returns the number of mismatches. Slow.
+uint64_t pixmap_fastconv_verify_f32_to_u8(void);
+
+// Name of the selected implementation, e.g. "ssse3".
+const char *pixmap_fastconv_impl_name(void)
+	attr_returns_nonnull;
@@ -0,0 +1,40 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "chunkreader.h"
+#include "util.h"
+
+void chunkreader_begin(StreamChunkReader *cr, SDL_RWops *stream) {
+	*cr = (StreamChunkReader) {
+		.stream = stream,
+		.buffer = mem_alloc(CHUNKREADER_CHUNK_SIZE),
+	};
+}
+
+size_t chunkreader_next(StreamChunkReader *cr, const uint8_t **data) {
+	if(cr->eof) {
+		return 0;
+	}
+
+	size_t size = SDL_RWread(cr->stream, cr->buffer, 1, CHUNKREADER_CHUNK_SIZE);
+
+	if(size < CHUNKREADER_CHUNK_SIZE) {
+		// Short read: either the end of the stream, or an error. Either way, stop here.
+		cr->eof = true;
+	}
+
+	*data = cr->buffer;
+	return size;
+}
+
+void chunkreader_end(StreamChunkReader *cr) {
+	mem_free(cr->buffer);
+	*cr = (StreamChunkReader) { };
+}
@@ -0,0 +1,42 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include <SDL.h>
+
+/*
+ * Reads a stream in fixed-size chunks, for feeding progressive decoders.
+ *
+ * All reads happen on the calling thread. Streams must not be read on a thread
+ * other than the one that opened them: the zip VFS backend keeps its libzip
+ * handles in thread-local storage.
+ *
+ * The stream must not be accessed by anything else until chunkreader_end is called.
+ */
+
+#define CHUNKREADER_CHUNK_SIZE (64 << 10)
+
+typedef struct StreamChunkReader {
+	SDL_RWops *stream;
+	uint8_t *buffer;
+	bool eof;
+} StreamChunkReader;
+
+void chunkreader_begin(StreamChunkReader *cr, SDL_RWops *stream)
+	attr_nonnull_all;
+
+// Returns the size of the next chunk and stores a pointer to its data in *data.
+// The data is valid until the next call. Returns 0 at the end of the stream.
+size_t chunkreader_next(StreamChunkReader *cr, const uint8_t **data)
+	attr_nonnull_all;
+
+// Frees the buffer.
+void chunkreader_end(StreamChunkReader *cr)
+	attr_nonnull_all;
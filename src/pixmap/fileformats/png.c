@@ -9,6 +9,7 @@
 #include "taisei.h"
 
 #include "fileformats.h"
+#include "chunkreader.h"
 #include "util.h"
 #include "util/pngcruft.h"
 
@@ -30,30 +31,16 @@ static inline PixmapLayout clrtype_to_layout(png_byte color_type) {
 	UNREACHABLE;
 }
 
-static bool px_png_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferred_format) {
-	png_structp png = NULL;
-	png_infop png_info = NULL;
-	const char *volatile error = NULL;
+typedef struct PNGLoadState {
+	Pixmap *pixmap;
+	PixmapFormat preferred_format;
+	size_t row_size;
+	bool finished;
+} PNGLoadState;
 
-	pixmap->data.untyped = NULL;
-
-	if(!(png = pngutil_create_read_struct())) {
-		error = "png_create_read_struct() failed";
-		goto done;
-	}
-
-	if(!(png_info = png_create_info_struct(png))) {
-		error = "png_create_info_struct() failed";
-		goto done;
-	}
-
-	if(setjmp(png_jmpbuf(png))) {
-		error = "PNG error";
-		goto done;
-	}
-
-	pngutil_init_rwops_read(png, stream);
-	png_read_info(png, png_info);
+static void px_png_info_callback(png_structp png, png_infop png_info) {
+	PNGLoadState *ls = png_get_progressive_ptr(png);
+	Pixmap *pixmap = ls->pixmap;
 
 	png_byte color_type = png_get_color_type(png, png_info);
 
@@ -69,14 +56,14 @@ static bool px_png_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferre
 	// avoid unnecessary back-and-forth conversion
 	bool keep_gray = (
 		color_type == PNG_COLOR_TYPE_GRAY &&
-		PIXMAP_FORMAT_LAYOUT(preferred_format) == PIXMAP_LAYOUT_R
+		PIXMAP_FORMAT_LAYOUT(ls->preferred_format) == PIXMAP_LAYOUT_R
 	);
 
 	if(!keep_gray) {
 		png_set_gray_to_rgb(png);
 	}
 
-	if(PIXMAP_FORMAT_DEPTH(preferred_format) == 16) {
+	if(PIXMAP_FORMAT_DEPTH(ls->preferred_format) == 16) {
 		png_set_expand_16(png);
 	}
 
@@ -84,7 +71,7 @@ static bool px_png_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferre
 	png_set_swap(png);
 #endif
 
-	int num_passes = png_set_interlace_handling(png);
+	png_set_interlace_handling(png);
 	png_read_update_info(png, png_info);
 
 	attr_unused png_byte channels = png_get_channels(png, png_info);
@@ -112,19 +99,78 @@ static bool px_png_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferre
 	size_t pixel_size = pixmap_format_pixel_size(pixmap->format);
 
 	if(pixmap->height > PIXMAP_BUFFER_MAX_SIZE / (pixmap->width * pixel_size)) {
-		error = "The image is too large";
+		png_error(png, "The image is too large");
+	}
+
+	ls->row_size = pixmap->width * pixel_size;
+	pixmap->data.untyped = pixmap_alloc_buffer_for_copy(pixmap, &pixmap->data_size);
+}
+
+static void px_png_row_callback(png_structp png, png_bytep new_row, png_uint_32 row_num, int pass) {
+	PNGLoadState *ls = png_get_progressive_ptr(png);
+	Pixmap *pixmap = ls->pixmap;
+
+	if(new_row == NULL || row_num >= pixmap->height) {
+		return;
+	}
+
+	// Takes care of combining interlaced passes
+	png_bytep row = (png_bytep)pixmap->data.untyped + (pixmap->height - row_num - 1) * ls->row_size;
+	png_progressive_combine_row(png, row, new_row);
+}
+
+static void px_png_end_callback(png_structp png, png_infop png_info) {
+	PNGLoadState *ls = png_get_progressive_ptr(png);
+	ls->finished = true;
+}
+
+static bool px_png_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferred_format) {
+	png_structp png = NULL;
+	png_infop png_info = NULL;
+	const char *volatile error = NULL;
+	PNGLoadState ls = {
+		.pixmap = pixmap,
+		.preferred_format = preferred_format,
+	};
+
+	// Decode progressively, feeding the file in large chunks rather than through many small
+	// reads (each of which may go through the zip VFS).
+	StreamChunkReader cr;
+	chunkreader_begin(&cr, stream);
+
+	pixmap->data.untyped = NULL;
+
+	if(!(png = pngutil_create_read_struct())) {
+		error = "png_create_read_struct() failed";
+		goto done;
+	}
+
+	if(!(png_info = png_create_info_struct(png))) {
+		error = "png_create_info_struct() failed";
+		goto done;
+	}
+
+	if(setjmp(png_jmpbuf(png))) {
+		error = "PNG error";
 		goto done;
 	}
 
-	png_bytep buffer = pixmap->data.untyped = pixmap_alloc_buffer_for_copy(pixmap, &pixmap->data_size);
+	png_set_progressive_read_fn(png, &ls, px_png_info_callback, px_png_row_callback, px_png_end_callback);
 
-	for(int pass = 0; pass < num_passes; ++pass) {
-		for(int row = pixmap->height - 1; row >= 0; --row) {
-			png_read_row(png, buffer + row * pixmap->width * pixel_size, NULL);
-		}
+	const uint8_t *chunk;
+	size_t chunk_size;
+
+	while(!ls.finished && (chunk_size = chunkreader_next(&cr, &chunk))) {
+		png_process_data(png, png_info, (png_bytep)chunk, chunk_size);
+	}
+
+	if(!ls.finished) {
+		error = "Unexpected end of stream";
 	}
 
 done:
+	chunkreader_end(&cr);
+
 	if(png != NULL) {
 		png_destroy_read_struct(
 			&png,
@@ -10,6 +10,7 @@
 
 #include "util.h"
 #include "fileformats.h"
+#include "chunkreader.h"
 
 #include <webp/decode.h>
 
@@ -65,6 +66,8 @@ static bool px_webp_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferr
 	// BUG: Unfortunately, the decoder seems to ignore the flip option, at least in
 	// some instances.
 
+	// Lets the lossy decoder filter the previous row band on a second thread
+	// while decoding the next one.
 	// TODO: Make sure this isn't counter-productive with our own inter-resource
 	// loading parallelism.
 	config.options.use_threads = true;
@@ -74,21 +77,19 @@ static bool px_webp_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferr
 	// config.options.dithering_strength = 50;
 	// config.options.alpha_dithering_strength = 50;
 
+	// Feed the incremental decoder chunk by chunk.
+	StreamChunkReader cr;
+	chunkreader_begin(&cr, stream);
+
 	WebPBitstreamFeatures features;
-	uint8_t buf[BUFSIZ] = { 0 };
-	size_t data_available = SDL_RWread(stream, buf, 1, sizeof(buf));
+	const uint8_t *chunk;
+	size_t chunk_size = chunkreader_next(&cr, &chunk);
 
-	status = WebPGetFeatures(buf, data_available, &features);
+	status = WebPGetFeatures(chunk, chunk_size, &features);
 
 	if(status != VP8_STATUS_OK) {
 		log_error("WebPGetFeatures() failed: %s", webp_error_str(status));
-		return false;
-	}
-
-	WebPIDecoder *idec = WebPINewDecoder(&config.output);
-
-	if(idec == NULL) {
-		log_error("WebPINewDecoder() failed");
+		chunkreader_end(&cr);
 		return false;
 	}
 
@@ -99,8 +100,8 @@ static bool px_webp_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferr
 	size_t pixel_size = PIXMAP_FORMAT_PIXEL_SIZE(pixmap->format);
 
 	if(pixmap->height > PIXMAP_BUFFER_MAX_SIZE / (pixmap->width * pixel_size)) {
-		WebPIDelete(idec);
 		log_error("The image is too large");
+		chunkreader_end(&cr);
 		return false;
 	}
 
@@ -112,8 +113,20 @@ static bool px_webp_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferr
 	config.output.u.RGBA.size = pixmap->data_size;
 	config.output.u.RGBA.stride = pixel_size * pixmap->width;
 
+	// NOTE: WebPINewDecoder() only takes the output buffer and ignores config.options,
+	// so use_threads would have no effect with it.
+	WebPIDecoder *idec = WebPIDecode(NULL, 0, &config);
+
+	if(idec == NULL) {
+		log_error("WebPIDecode() failed");
+		mem_free(pixmap->data.untyped);
+		pixmap->data.untyped = NULL;
+		chunkreader_end(&cr);
+		return false;
+	}
+
 	do {
-		status = WebPIAppend(idec, buf, data_available);
+		status = WebPIAppend(idec, chunk, chunk_size);
 
 		if(status != VP8_STATUS_OK && status != VP8_STATUS_SUSPENDED) {
 			log_error("WebPIAppend() failed: %s", webp_error_str(status));
@@ -121,10 +134,15 @@ static bool px_webp_load(SDL_RWops *stream, Pixmap *pixmap, PixmapFormat preferr
 			pixmap->data.untyped = NULL;
 			break;
 		}
+	} while(status == VP8_STATUS_SUSPENDED && (chunk_size = chunkreader_next(&cr, &chunk)) > 0);
 
-		data_available = SDL_RWread(stream, buf, 1, sizeof(buf));
-	} while(data_available > 0);
+	if(status == VP8_STATUS_SUSPENDED) {
+		log_error("WebPIAppend() failed: %s", webp_error_str(VP8_STATUS_NOT_ENOUGH_DATA));
+		mem_free(pixmap->data.untyped);
+		pixmap->data.untyped = NULL;
+	}
 
+	chunkreader_end(&cr);
 	WebPIDelete(idec);
 	WebPFreeDecBuffer(&config.output);
 	return pixmap->data.untyped != NULL;
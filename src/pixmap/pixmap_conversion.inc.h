@@ -21,7 +21,8 @@ static _CONV_OUT_TYPE _CONV_VALUE_FUNC(_CONV_IN_TYPE val) {
 		if(_CONV_OUT_IS_FLOAT) {
 			return val;
 		} else {
-			return (_CONV_OUT_TYPE)roundf(clampf(val, 0.0f, 1.0f) * (float)_CONV_OUT_MAX);
+			// NOTE: NaN maps to 0; converting it to an integer is undefined
+			return LIKELY(val == val) ? (_CONV_OUT_TYPE)roundf(clampf(val, 0.0f, 1.0f) * (float)_CONV_OUT_MAX) : 0;
 		}
 	} else if(_CONV_OUT_IS_FLOAT) {
 		return val * (1.0f / (float)_CONV_IN_MAX);
@@ -10,7 +10,9 @@
 
 #include "projectile.h"
 
+#include "eventloop/eventloop.h"
 #include "global.h"
+#include "gpuparticles.h"
 #include "list.h"
 #include "stageobjects.h"
 #include "util/glm.h"
@@ -126,7 +128,7 @@ static void projectile_size(Projectile *p, double *w, double *h) {
 	assert(*h > 0);
 }
 
-static Projectile *spawn_bullet_spawning_effect(Projectile *p);
+static void spawn_bullet_spawning_effect(Projectile *p);
 
 // Returns true if projectile should be destroyed
 static inline bool proj_update(Projectile *p, int t) {
@@ -229,6 +231,14 @@ void projectile_set_layer(Projectile *p, drawlayer_t layer) {
 
 static void ent_draw_projectile(EntityInterface *ent);
 
+static void projectile_update_draw_state(Projectile *p) {
+	p->ent.draw_state = r_state_block(&(RenderStateBlockParams) {
+		.fields = RSB_SHADER | RSB_BLEND,
+		.shader = p->shader,
+		.blend = p->blend,
+	});
+}
+
 static Projectile* _create_projectile(ProjArgs *args) {
 	if(IN_DRAW_CODE) {
 		log_fatal("Tried to spawn a projectile while in drawing code");
@@ -243,6 +253,7 @@ static Projectile* _create_projectile(ProjArgs *args) {
 	p->draw_rule = args->draw_rule;
 	p->shader = args->shader_ptr;
 	p->blend = args->blend;
+	projectile_update_draw_state(p);
 	p->sprite = args->sprite_ptr;
 	p->type = args->type;
 	p->color = *args->color;
@@ -452,8 +463,23 @@ void apply_projectile_collision(ProjectileList *projlist, Projectile *p, ProjCol
 static void ent_draw_projectile(EntityInterface *ent) {
 	Projectile *proj = ENT_CAST(ent, Projectile);
 
-	r_blend(proj->blend);
-	r_shader_ptr(proj->shader);
+	// NOTE: blend mode and shader are set through ent.draw_state by ent_draw().
+	// If either has been reassigned since the block was built, it is stale; rebuild it.
+	const RenderStateBlockParams *bp = r_state_block_params(proj->ent.draw_state);
+
+	if(UNLIKELY(bp->shader != proj->shader || bp->blend != proj->blend)) {
+		projectile_update_draw_state(proj);
+		r_state_block_apply(proj->ent.draw_state);
+	}
+
+	// With render interpolation, draw at a point between the previous and current positions.
+	// The draw rule only ever sees the projectile's position, so substitute it temporarily.
+	cmplx pos = proj->pos;
+	float interp = eventloop_get_interpolation();
+
+	if(interp < 1) {
+		proj->pos = clerp(proj->prevpos, pos, interp);
+	}
 
 #ifdef PROJ_DEBUG
 	static Projectile prev_state;
@@ -468,6 +494,8 @@ static void ent_draw_projectile(EntityInterface *ent) {
 #else
 	proj->draw_rule.func(proj, global.frames - proj->birthtime, proj->draw_rule.args);
 #endif
+
+	proj->pos = pos;
 }
 
 bool projectile_in_viewport(Projectile *proj) {
@@ -650,35 +678,9 @@ static float proj_spawn_effect_factor(Projectile *proj, int t) {
 	return t / (float)maxt;
 }
 
-static void bullet_highlight_draw(Projectile *p, int t, ProjDrawRuleArgs args) {
-	float timefactor = t / p->timeout;
-	float sx = args[0].as_float[0];
-	float sy = args[0].as_float[1];
-	float tex_angle = args[1].as_float[0];
-
-	float opacity = pow(1 - timefactor, 3);
-	opacity = fmin(1, 1.5 * opacity) * fmin(1, timefactor * 10);
-	opacity *= p->opacity;
-
-	r_mat_mv_push();
-	r_mat_mv_translate(creal(p->pos), cimag(p->pos), 0);
-	r_mat_mv_rotate(p->angle + M_PI * 0.5, 0, 0, 1);
-	r_mat_mv_scale(sx, sy, 1);
-	r_mat_mv_rotate(tex_angle, 0, 0, 1);
-
-	r_draw_sprite(&(SpriteParams) {
-		.sprite_ptr = p->sprite,
-		.shader_ptr = p->shader,
-		.shader_params = &(ShaderCustomParams) {{ opacity }},
-		.color = &p->color,
-	});
-
-	r_mat_mv_pop();
-}
-
-static Projectile* spawn_projectile_highlight_effect_internal(Projectile *p, bool flare) {
+static void spawn_projectile_highlight_effect_internal(Projectile *p, bool flare, float opacity) {
 	if(!p->sprite) {
-		return NULL;
+		return;
 	}
 
 	Color clr = p->color;
@@ -699,12 +701,11 @@ static Projectile* spawn_projectile_highlight_effect_internal(Projectile *p, boo
 
 		RNG_ARRAY(R, 5);
 
-		PARTICLE(
+		GPU_PARTICLE(
 			.sprite = "stardust_green",
-			.shader = "sprite_bullet",
-			.size = p->size * 4.5,
+			.shader = "gpu_particle_bullet",
 			.layer = LAYER_PARTICLE_HIGH | 0x40,
-			.draw_rule = pdraw_timeout_scalefade_exp(0, 0.2f * fmaxf(sx, sy) * vrng_f32_range(R[0], 0.8f, 1.0f), 1, 0, 2),
+			.anim = gpart_anim_scalefade_exp(0, 0.2f * fmaxf(sx, sy) * vrng_f32_range(R[0], 0.8f, 1.0f), 1, 0, 2),
 			.angle = vrng_angle(R[1]),
 			.pos = p->pos + vrng_range(R[2], 0, 8) * vrng_dir(R[3]),
 			.flags = PFLAG_NOREFLECT,
@@ -719,17 +720,22 @@ static Projectile* spawn_projectile_highlight_effect_internal(Projectile *p, boo
 
 	RNG_ARRAY(R, 5);
 
-	return PARTICLE(
+	// Opacity is min(1, 1.5 * (1 - t)³) * min(1, 10 * t)
+	GPU_PARTICLE(
 		.sprite = "bullet_flare",
-		.size = p->size * 4.5,
-		.shader = "sprite_bullet",
+		.shader = "gpu_particle_bullet",
 		.layer = LAYER_PARTICLE_HIGH | 0x80,
-		.draw_rule = {
-			bullet_highlight_draw,
-			.args[0].as_cmplx = 0.125 * (sx + I * sy),
-			.args[1].as_float = vrng_angle(R[0]),
+		.anim = {
+			.scale0 = 0.125f * CMPLXF(sx, sy),
+			.scale1 = 0.125f * CMPLXF(sx, sy),
+			.opacity0 = cbrtf(1.5f),
+			.opacity1 = 0,
+			.opacity_exp = 3,
+			.fadein = 0.1f,
 		},
+		.image_angle = vrng_angle(R[0]),
 		.angle = p->angle,
+		.opacity = opacity,
 		.pos = p->pos + vrng_range(R[1], 0, 2) * vrng_dir(R[2]),
 		.flags = PFLAG_NOREFLECT | PFLAG_REQUIREDPARTICLE,
 		.timeout = vrng_range(R[3], 30, 34),
@@ -737,16 +743,18 @@ static Projectile* spawn_projectile_highlight_effect_internal(Projectile *p, boo
 	);
 }
 
-Projectile* spawn_projectile_highlight_effect(Projectile *p) {
-	return spawn_projectile_highlight_effect_internal(p, true);
+void spawn_projectile_highlight_effect(Projectile *p) {
+	spawn_projectile_highlight_effect_internal(p, true, 1);
 }
 
-static Projectile* spawn_bullet_spawning_effect(Projectile *p) {
+void spawn_projectile_highlight_effect_ex(Projectile *p, float opacity) {
+	spawn_projectile_highlight_effect_internal(p, true, opacity);
+}
+
+static void spawn_bullet_spawning_effect(Projectile *p) {
 	if(proj_uses_spawning_effect(p, PFLAG_NOSPAWNFLARE)) {
-		return spawn_projectile_highlight_effect(p);
+		spawn_projectile_highlight_effect(p);
 	}
-
-	return NULL;
 }
 
 static void projectile_clear_effect_draw(Projectile *p, int t, ProjDrawRuleArgs args) {
@@ -1007,18 +1015,34 @@ ProjDrawRule pdraw_petal_random(void) {
 }
 
 void petal_explosion(int n, cmplx pos) {
+	// GPU particles are not culled when they leave the viewport, so the lifetime must cover
+	// the distance to the farthest corner. The speed never drops below |v|.
+	real max_dist = fmax(
+		fmax(cabs(pos), cabs(pos - VIEWPORT_W)),
+		fmax(cabs(pos - VIEWPORT_H * I), cabs(pos - (VIEWPORT_W + VIEWPORT_H * I)))
+	) + 64;
+
 	for(int i = 0; i < n; i++) {
 		cmplx v = rng_dir();
 		v *= rng_range(3, 8);
 		real t = rng_real();
 
-		PARTICLE(
+		// Same RNG call order as pdraw_petal_random()
+		float x = rng_f32();
+		float y = rng_f32();
+		float z = rng_f32();
+		float rot_angle = rng_f32_angle();
+
+		GPU_PARTICLE(
 			.sprite = "petal",
 			.pos = pos,
 			.color = RGBA(sin(5*t) * t, cos(5*t) * t, 0.5 * t, 0),
 			.move = move_asymptotic_simple(v, 5),
-			.draw_rule = pdraw_petal_random(),
-			.flags = (n % 2 ? 0 : PFLAG_REQUIREDPARTICLE) | PFLAG_MANUALANGLE,
+			.rotation_axis = { x, y, z },
+			.angle = rot_angle,
+			.angle_delta = DEG2RAD*4.0f,
+			.timeout = ceil(max_dist / cabs(v)),
+			.flags = (n % 2 ? 0 : PFLAG_REQUIREDPARTICLE),
 			.layer = LAYER_PARTICLE_PETAL,
 		);
 	}
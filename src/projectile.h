@@ -240,7 +240,8 @@ bool projectile_is_clearable(Projectile *p) attr_nonnull_all;
 
 Projectile *spawn_projectile_collision_effect(Projectile *proj) attr_nonnull_all;
 Projectile *spawn_projectile_clear_effect(Projectile *proj) attr_nonnull_all;
-Projectile *spawn_projectile_highlight_effect(Projectile *proj) attr_nonnull_all;
+void spawn_projectile_highlight_effect(Projectile *proj) attr_nonnull_all;
+void spawn_projectile_highlight_effect_ex(Projectile *proj, float opacity) attr_nonnull_all;
 
 void projectile_set_prototype(Projectile *p, ProjPrototype *proto) attr_nonnull(1);
 void projectile_set_layer(Projectile *p, drawlayer_t layer) attr_nonnull_all;
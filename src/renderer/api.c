@@ -352,6 +352,14 @@ ShaderObject* r_shader_object_compile(ShaderSource *source) {
 	return B.shader_object_compile(source);
 }
 
+bool r_shader_object_ready(ShaderObject *shobj) {
+	return B.shader_object_ready(shobj);
+}
+
+bool r_shader_object_finish(ShaderObject *shobj) {
+	return B.shader_object_finish(shobj);
+}
+
 void r_shader_object_destroy(ShaderObject *shobj) {
 	B.shader_object_destroy(shobj);
 }
@@ -372,6 +380,14 @@ ShaderProgram* r_shader_program_link(uint num_objects, ShaderObject *shobjs[num_
 	return B.shader_program_link(num_objects, shobjs);
 }
 
+bool r_shader_program_ready(ShaderProgram *prog) {
+	return B.shader_program_ready(prog);
+}
+
+bool r_shader_program_finish(ShaderProgram *prog) {
+	return B.shader_program_finish(prog);
+}
+
 void r_shader_program_destroy(ShaderProgram *prog) {
 	B.shader_program_destroy(prog);
 }
@@ -805,14 +821,54 @@ VsyncMode r_vsync_current(void) {
 
 void r_swap(SDL_Window *window) {
 	coroutines_draw_stats();
+	_r_state_end_frame();
 	_r_sprite_batch_end_frame();
 	B.swap(window);
 }
 
+void r_flush(void) {
+	B.flush();
+}
+
 bool r_screenshot(Pixmap *out) {
 	return B.screenshot(out);
 }
 
+void r_screenshot_async(ScreenshotCallback callback, void *userdata) {
+	B.screenshot_async(callback, userdata);
+}
+
+void r_screenshot_async_finish(void) {
+	B.screenshot_async_finish();
+}
+
+TimerQuery *r_timer_query_create(void) {
+	if(!r_supports(RFEAT_TIMER_QUERY)) {
+		return NULL;
+	}
+
+	return B.timer_query_create();
+}
+
+void r_timer_query_destroy(TimerQuery *tq) {
+	B.timer_query_destroy(tq);
+}
+
+void r_timer_query_begin(TimerQuery *tq) {
+	// Batched sprites belong to whatever was drawn before
+	r_flush_sprites();
+	B.timer_query_begin(tq);
+}
+
+void r_timer_query_end(TimerQuery *tq) {
+	r_flush_sprites();
+	B.timer_query_end(tq);
+}
+
+bool r_timer_query_result(TimerQuery *tq, uint64_t *out_nsec) {
+	return B.timer_query_result(tq, out_nsec);
+}
+
 // uniforms garbage; hope your compiler is smart enough to inline most of this
 
 // TODO: verify sampler-to-texture type consistency?
@@ -26,6 +26,8 @@ typedef struct ShaderObject ShaderObject;
 typedef struct ShaderProgram ShaderProgram;
 typedef struct Sprite Sprite;
 typedef struct Model Model;
+typedef struct RenderStateBlock RenderStateBlock;
+typedef struct TimerQuery TimerQuery;
 
 enum {
 	R_DEBUG_LABEL_SIZE = 128,
@@ -40,6 +42,7 @@ typedef enum RendererFeature {
 	RFEAT_TEXTURE_BOTTOMLEFT_ORIGIN,
 	RFEAT_TEXTURE_SWIZZLE,
 	RFEAT_PARTIAL_MIPMAPS,
+	RFEAT_TIMER_QUERY,
 
 	NUM_RFEATS,
 } RendererFeature;
@@ -429,6 +432,25 @@ typedef union ShaderCustomParams {
 	Color color;
 } ShaderCustomParams;
 
+typedef enum RenderStateBlockField {
+	RSB_SHADER       = (1 << 0),
+	RSB_BLEND        = (1 << 1),
+	RSB_CAPABILITIES = (1 << 2),
+	RSB_CULL         = (1 << 3),
+	RSB_DEPTH_FUNC   = (1 << 4),
+} RenderStateBlockField;
+
+typedef struct RenderStateBlockParams {
+	// Only fields whose bits are set here are part of the block; the rest are ignored.
+	uint fields;
+
+	ShaderProgram *shader;
+	BlendMode blend;
+	r_capability_bits_t capabilities;
+	CullFaceMode cull;
+	DepthTestFunc depth_func;
+} RenderStateBlockParams;
+
 typedef struct SpriteStateParams {
 	Texture *primary_texture;
 	Texture *aux_textures[R_NUM_SPRITE_AUX_TEXTURES];
@@ -543,13 +565,23 @@ DepthTestFunc r_depth_func_current(void);
 
 bool r_shader_language_supported(const ShaderLangInfo *lang, ShaderLangInfo *out_alternative) attr_nonnull(1);
 
+// Compilation and linking may continue in the background after r_shader_object_compile and
+// r_shader_program_link return, if the backend supports it. The result must be retrieved with
+// the corresponding *_finish function, which waits for the driver if necessary. It returns false
+// on failure, in which case the object must be destroyed. *_ready returns true if *_finish would
+// not have to wait.
+
 ShaderObject* r_shader_object_compile(ShaderSource *source) attr_nonnull(1);
+bool r_shader_object_ready(ShaderObject *shobj) attr_nonnull(1);
+bool r_shader_object_finish(ShaderObject *shobj) attr_nonnull(1);
 void r_shader_object_destroy(ShaderObject *shobj) attr_nonnull(1);
 void r_shader_object_set_debug_label(ShaderObject *shobj, const char *label) attr_nonnull(1);
 const char* r_shader_object_get_debug_label(ShaderObject *shobj) attr_nonnull(1);
 bool r_shader_object_transfer(ShaderObject *dst, ShaderObject *src) attr_nonnull_all;
 
 ShaderProgram* r_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) attr_nonnull(2);
+bool r_shader_program_ready(ShaderProgram *prog) attr_nonnull(1);
+bool r_shader_program_finish(ShaderProgram *prog) attr_nonnull(1);
 void r_shader_program_destroy(ShaderProgram *prog);
 void r_shader_program_set_debug_label(ShaderProgram *prog, const char *label) attr_nonnull(1);
 const char* r_shader_program_get_debug_label(ShaderProgram *prog) attr_nonnull(1);
@@ -818,8 +850,48 @@ VsyncMode r_vsync_current(void);
 
 void r_swap(SDL_Window *window);
 
+// Submits all queued rendering commands to the GPU without waiting for them to complete.
+void r_flush(void);
+
 bool r_screenshot(Pixmap *dest) attr_nodiscard attr_nonnull(1);
 
+/*
+ * Asynchronous screenshots.
+ *
+ * r_screenshot_async() requests a capture of the default framebuffer as presented by the next
+ * r_swap(). Where the backend supports it, the pixels are copied into a buffer on the GPU side
+ * and mapped a frame or two later, so the capture doesn't stall the pipeline.
+ *
+ * The callback is invoked on the main thread, from within r_swap() or
+ * r_screenshot_async_finish(), in the order the requests were made. It takes ownership of the
+ * pixmap's data (free it with mem_free). On failure, it is called with a NULL pixmap.
+ *
+ * r_screenshot_async_finish() blocks until all pending captures have been delivered.
+ * Requests that haven't been serviced by an r_swap() yet fail.
+ */
+
+typedef void (*ScreenshotCallback)(Pixmap *image, void *userdata);
+
+void r_screenshot_async(ScreenshotCallback callback, void *userdata) attr_nonnull(1);
+void r_screenshot_async_finish(void);
+
+/*
+ * GPU timer queries.
+ *
+ * Measure the GPU time taken by the commands submitted between r_timer_query_begin() and
+ * r_timer_query_end(). Results arrive asynchronously, typically a few frames later, and
+ * r_timer_query_result() never blocks: it returns the most recent available measurement.
+ * Timer queries must not be nested or overlap.
+ *
+ * r_timer_query_create() returns NULL if RFEAT_TIMER_QUERY is not supported.
+ */
+
+TimerQuery *r_timer_query_create(void);
+void r_timer_query_destroy(TimerQuery *tq) attr_nonnull(1);
+void r_timer_query_begin(TimerQuery *tq) attr_nonnull(1);
+void r_timer_query_end(TimerQuery *tq) attr_nonnull(1);
+bool r_timer_query_result(TimerQuery *tq, uint64_t *out_nsec) attr_nonnull(1, 2);
+
 void r_mat_mv_push(void);
 void r_mat_mv_push_premade(mat4 mat);
 void r_mat_mv_push_identity(void);
@@ -870,6 +942,18 @@ VertexArray* r_vertex_array_static_models(void) attr_returns_nonnull;
 void r_state_push(void);
 void r_state_pop(void);
 
+// Returns the unique, immutable state block for the given parameters. Blocks are
+// interned: equal parameters always give the same pointer. They live until the
+// renderer shuts down.
+const RenderStateBlock *r_state_block(const RenderStateBlockParams *params) attr_nonnull(1) attr_returns_nonnull;
+
+// Applies a state block. This is just a pointer comparison if it's the most
+// recently applied block and nothing it covers has been changed since.
+void r_state_block_apply(const RenderStateBlock *block) attr_nonnull(1);
+
+const RenderStateBlockParams *r_state_block_params(const RenderStateBlock *block)
+	attr_nonnull(1) attr_returns_nonnull;
+
 void r_draw_quad(void);
 void r_draw_quad_instanced(uint instances);
 void r_draw_model_ptr(const Model *model, uint instances, uint base_instance) attr_nonnull(1);
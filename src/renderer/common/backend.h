@@ -46,12 +46,16 @@ typedef struct RendererFuncs {
 	bool (*shader_language_supported)(const ShaderLangInfo *lang, ShaderLangInfo *out_alternative);
 
 	ShaderObject* (*shader_object_compile)(ShaderSource *source);
+	bool (*shader_object_ready)(ShaderObject *shobj);
+	bool (*shader_object_finish)(ShaderObject *shobj);
 	void (*shader_object_destroy)(ShaderObject *shobj);
 	void (*shader_object_set_debug_label)(ShaderObject *shobj, const char *label);
 	const char* (*shader_object_get_debug_label)(ShaderObject *shobj);
 	bool (*shader_object_transfer)(ShaderObject *dst, ShaderObject *src);
 
 	ShaderProgram* (*shader_program_link)(uint num_objects, ShaderObject *shobjs[num_objects]);
+	bool (*shader_program_ready)(ShaderProgram *prog);
+	bool (*shader_program_finish)(ShaderProgram *prog);
 	void (*shader_program_destroy)(ShaderProgram *prog);
 	void (*shader_program_set_debug_label)(ShaderProgram *prog, const char *label);
 	const char* (*shader_program_get_debug_label)(ShaderProgram *prog);
@@ -131,8 +135,17 @@ typedef struct RendererFuncs {
 	VsyncMode (*vsync_current)(void);
 
 	void (*swap)(SDL_Window *window);
+	void (*flush)(void);
 
 	bool (*screenshot)(Pixmap *dst);
+	void (*screenshot_async)(ScreenshotCallback callback, void *userdata);
+	void (*screenshot_async_finish)(void);
+
+	TimerQuery* (*timer_query_create)(void);
+	void (*timer_query_destroy)(TimerQuery *tq);
+	void (*timer_query_begin)(TimerQuery *tq);
+	void (*timer_query_end)(TimerQuery *tq);
+	bool (*timer_query_result)(TimerQuery *tq, uint64_t *out_nsec);
 } RendererFuncs;
 
 typedef struct RendererBackend {
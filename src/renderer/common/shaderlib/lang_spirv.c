@@ -16,7 +16,12 @@
 #include <shaderc/shaderc.h>
 #include <spirv_cross_c.h>
 
-static shaderc_compiler_t spirv_compiler;
+// Each thread gets its own compiler instance, so that shaders can be translated in parallel by
+// the resource loader's workers.
+static struct {
+	SDL_TLSID tls;
+	SDL_atomic_t initialized;
+} spirv_compiler;
 
 static inline shaderc_optimization_level resolve_opt_level(SPIRVOptimizationLevel lvl) {
 	switch(lvl) {
@@ -63,19 +68,64 @@ static inline shaderc_shader_kind resolve_kind(ShaderStage stage) {
 	}
 }
 
+static void spirv_compiler_tls_destructor(void *compiler) {
+	shaderc_compiler_release(NOT_NULL(compiler));
+}
+
+static shaderc_compiler_t spirv_get_compiler(void) {
+	if(UNLIKELY(!SDL_AtomicGet(&spirv_compiler.initialized))) {
+		return NULL;
+	}
+
+	shaderc_compiler_t compiler = SDL_TLSGet(spirv_compiler.tls);
+
+	if(LIKELY(compiler)) {
+		return compiler;
+	}
+
+	compiler = shaderc_compiler_initialize();
+
+	if(UNLIKELY(compiler == NULL)) {
+		log_error("Failed to initialize the compiler");
+		return NULL;
+	}
+
+	log_debug("Created compiler %p for thread %p", (void*)compiler, (void*)SDL_ThreadID());
+
+	if(SDL_TLSSet(spirv_compiler.tls, compiler, spirv_compiler_tls_destructor) < 0) {
+		log_error("SDL_TLSSet() failed: %s", SDL_GetError());
+		shaderc_compiler_release(compiler);
+		return NULL;
+	}
+
+	return compiler;
+}
+
 void spirv_init_compiler(void) {
-	if(spirv_compiler == NULL) {
-		spirv_compiler = shaderc_compiler_initialize();
-		if(spirv_compiler == NULL) {
-			log_error("Failed to initialize the compiler");
-		}
+	if(SDL_AtomicGet(&spirv_compiler.initialized)) {
+		return;
+	}
+
+	if(!spirv_compiler.tls && !(spirv_compiler.tls = SDL_TLSCreate())) {
+		log_error("SDL_TLSCreate() failed: %s", SDL_GetError());
+		return;
 	}
+
+	SDL_AtomicSet(&spirv_compiler.initialized, true);
 }
 
 void spirv_shutdown_compiler(void) {
-	if(spirv_compiler != NULL) {
-		shaderc_compiler_release(spirv_compiler);
-		spirv_compiler = NULL;
+	// Compilers owned by worker threads are released when those threads exit.
+	// Only the calling thread's instance can be released here.
+	SDL_AtomicSet(&spirv_compiler.initialized, false);
+
+	if(spirv_compiler.tls) {
+		shaderc_compiler_t compiler = SDL_TLSGet(spirv_compiler.tls);
+
+		if(compiler) {
+			SDL_TLSSet(spirv_compiler.tls, NULL, NULL);
+			shaderc_compiler_release(compiler);
+		}
 	}
 }
 
@@ -85,7 +135,9 @@ bool _spirv_compile(const ShaderSource *in, ShaderSource *out, const SPIRVCompil
 		return false;
 	}
 
-	if(spirv_compiler == NULL) {
+	shaderc_compiler_t compiler = spirv_get_compiler();
+
+	if(compiler == NULL) {
 		log_error("Compiler is not initialized");
 		return false;
 	}
@@ -119,7 +171,7 @@ bool _spirv_compile(const ShaderSource *in, ShaderSource *out, const SPIRVCompil
 	const char *filename = options->filename ? options->filename : "<main>";
 
 	shaderc_compilation_result_t result = shaderc_compile_into_spv(
-		spirv_compiler,
+		compiler,
 		in->content,
 		in->content_size - 1,
 		resolve_kind(in->stage),
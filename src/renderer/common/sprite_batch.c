@@ -25,12 +25,47 @@
 #endif
 
 #define SIZEOF_SPRITE_ATTRIBS (offsetof(SpriteInstanceAttribs, end_of_fields))
+#define SIZEOF_SPRITE_COMPACT_ATTRIBS (offsetof(SpriteCompactInstanceAttribs, end_of_fields))
+
+// Large enough that every instance in a batch fetches element 0 of the constants buffer
+#define SPRITE_CONSTANT_DIVISOR (1u << 30)
+
+/*
+ * Alternative instance layout for sprites with a 2D affine modelview matrix, an identity
+ * texture matrix, and a color within [0, 1]. This covers the vast majority of sprites.
+ *
+ * The vertex array for this layout feeds the same shader attributes as the full one:
+ * the constant parts of the matrices are fetched from a static buffer, the translation
+ * column is expanded to (x, y, 0, 1) by the vertex fetch, and the color is normalized.
+ */
+typedef struct SpriteCompactInstanceAttribs {
+	float mv_transform_col0[4];  // (m00, m01, 0, 0)
+	float mv_transform_col1[4];  // (m10, m11, 0, 0)
+	float mv_translation[2];
+	float texrect[4];
+	float sprite_size[2];
+	float custom[4];
+	uint8_t rgba[4];
+
+	char end_of_fields;
+} SpriteCompactInstanceAttribs;
+
+static const float sprite_batch_constants[][4] = {
+	{ 0, 0, 1, 0 },  // mv_transform[2]
+	{ 1, 0, 0, 0 },  // tex_transform[0]
+	{ 0, 1, 0, 0 },  // tex_transform[1]
+	{ 0, 0, 1, 0 },  // tex_transform[2]
+	{ 0, 0, 0, 1 },  // tex_transform[3]
+};
 
 static struct SpriteBatchState {
 	// constants (set once on init and not expected to change)
 	VertexArray *varr;
+	VertexArray *varr_compact;
 	VertexBuffer *vbuf;
+	VertexBuffer *constants_vbuf;
 	Model quad;
+	Model quad_compact;
 	r_feature_bits_t renderer_features;
 
 	// varying state
@@ -38,18 +73,30 @@ static struct SpriteBatchState {
 	Texture *primary_texture;
 	Texture *aux_textures[R_NUM_SPRITE_AUX_TEXTURES];
 	ShaderProgram *shader;
+	struct {
+		// resolved once per shader change
+		Uniform *tex;
+		Uniform *tex_aux;
+	} uniforms;
 	Framebuffer *framebuffer;
 	uint base_instance;
 	BlendMode blend;
 	CullFaceMode cull_mode;
 	DepthTestFunc depth_func;
 	uint num_pending;
+	bool pending_compact;
 	r_capability_bits_t capbits;
 
+	// Full attributes of the pending sprites while the batch uses the compact layout, so it
+	// can be rewritten in the full layout if a sprite that doesn't fit is added.
+	DYNAMIC_ARRAY(SpriteInstanceAttribs) compact_backlog;
+
 #if SPRITE_BATCH_STATS
 	struct {
 		uint flushes;
 		uint sprites;
+		uint compact_sprites;
+		uint expanded_batches;
 		uint best_batch;
 		uint worst_batch;
 	} frame_stats;
@@ -89,8 +136,39 @@ void _r_sprite_batch_init(void) {
 		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_attr, INSTANCE_OFS(custom),           1 },
 	};
 
+	size_t sz_cattr = SIZEOF_SPRITE_COMPACT_ATTRIBS;
+	size_t sz_const = sizeof(*sprite_batch_constants);
+	uint cdiv = SPRITE_CONSTANT_DIVISOR;
+
+	#define COMPACT_OFS(attr) offsetof(SpriteCompactInstanceAttribs, attr)
+	#define CONST_OFS(idx)    (idx * sz_const)
+
+	VertexAttribFormat fmt_compact[] = {
+		// Per-vertex attributes (for the static models buffer, bound at 0)
+		fmt[0], fmt[1], fmt[2], fmt[3],
+
+		// Per-instance attributes (for our own sprites buffer, bound at 1)
+		// Constant attributes (for the constants buffer, bound at 2)
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            1    }, sz_cattr, COMPACT_OFS(mv_transform_col0), 1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            1    }, sz_cattr, COMPACT_OFS(mv_transform_col1), 1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            cdiv }, sz_const, CONST_OFS(0),                   2 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT,            1    }, sz_cattr, COMPACT_OFS(mv_translation),    1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            cdiv }, sz_const, CONST_OFS(1),                   2 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            cdiv }, sz_const, CONST_OFS(2),                   2 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            cdiv }, sz_const, CONST_OFS(3),                   2 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            cdiv }, sz_const, CONST_OFS(4),                   2 },
+		{ { 4, VA_UBYTE, VA_CONVERT_FLOAT_NORMALIZED, 1    }, sz_cattr, COMPACT_OFS(rgba),              1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            1    }, sz_cattr, COMPACT_OFS(texrect),           1 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT,            1    }, sz_cattr, COMPACT_OFS(sprite_size),       1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT,            1    }, sz_cattr, COMPACT_OFS(custom),            1 },
+	};
+
+	static_assert(ARRAY_SIZE(fmt_compact) == ARRAY_SIZE(fmt), "Sprite vertex layouts must have the same attributes");
+
 	#undef VERTEX_OFS
 	#undef INSTANCE_OFS
+	#undef COMPACT_OFS
+	#undef CONST_OFS
 
 	uint capacity = 1 << 11;
 
@@ -98,24 +176,41 @@ void _r_sprite_batch_init(void) {
 	r_vertex_buffer_set_debug_label(_r_sprite_batch.vbuf, "Sprite batch vertex buffer");
 	r_vertex_buffer_invalidate(_r_sprite_batch.vbuf);
 
+	_r_sprite_batch.constants_vbuf = r_vertex_buffer_create(
+		sizeof(sprite_batch_constants), (void*)sprite_batch_constants);
+	r_vertex_buffer_set_debug_label(_r_sprite_batch.constants_vbuf, "Sprite batch constants buffer");
+
 	_r_sprite_batch.varr = r_vertex_array_create();
 	r_vertex_array_set_debug_label(_r_sprite_batch.varr, "Sprite batch vertex array");
 	r_vertex_array_layout(_r_sprite_batch.varr, sizeof(fmt)/sizeof(*fmt), fmt);
 	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr, r_vertex_buffer_static_models(), 0);
 	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr, _r_sprite_batch.vbuf, 1);
 
+	_r_sprite_batch.varr_compact = r_vertex_array_create();
+	r_vertex_array_set_debug_label(_r_sprite_batch.varr_compact, "Sprite batch compact vertex array");
+	r_vertex_array_layout(_r_sprite_batch.varr_compact, sizeof(fmt_compact)/sizeof(*fmt_compact), fmt_compact);
+	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr_compact, r_vertex_buffer_static_models(), 0);
+	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr_compact, _r_sprite_batch.vbuf, 1);
+	r_vertex_array_attach_vertex_buffer(_r_sprite_batch.varr_compact, _r_sprite_batch.constants_vbuf, 2);
+
 	_r_sprite_batch.quad.num_indices = 0;
 	_r_sprite_batch.quad.num_vertices = 4;
 	_r_sprite_batch.quad.offset = 0;
 	_r_sprite_batch.quad.primitive = PRIM_TRIANGLE_STRIP;
 	_r_sprite_batch.quad.vertex_array = _r_sprite_batch.varr;
 
+	_r_sprite_batch.quad_compact = _r_sprite_batch.quad;
+	_r_sprite_batch.quad_compact.vertex_array = _r_sprite_batch.varr_compact;
+
 	_r_sprite_batch.renderer_features = r_features();
 }
 
 void _r_sprite_batch_shutdown(void) {
 	r_vertex_array_destroy(_r_sprite_batch.varr);
+	r_vertex_array_destroy(_r_sprite_batch.varr_compact);
 	r_vertex_buffer_destroy(_r_sprite_batch.vbuf);
+	r_vertex_buffer_destroy(_r_sprite_batch.constants_vbuf);
+	dynarray_free_data(&_r_sprite_batch.compact_backlog);
 }
 
 void r_flush_sprites(void) {
@@ -142,14 +237,18 @@ void r_flush_sprites(void) {
 	}
 
 	_r_sprite_batch.frame_stats.flushes++;
+
+	if(_r_sprite_batch.pending_compact) {
+		_r_sprite_batch.frame_stats.compact_sprites += pending;
+	}
 #endif
 
 	r_state_push();
 	r_mat_proj_push_premade(_r_sprite_batch.projection);
 
 	r_shader_ptr(NOT_NULL(_r_sprite_batch.shader));
-	r_uniform_sampler("tex", _r_sprite_batch.primary_texture);
-	r_uniform_sampler_array("tex_aux[0]", 0, R_NUM_SPRITE_AUX_TEXTURES, _r_sprite_batch.aux_textures);
+	r_uniform_sampler(_r_sprite_batch.uniforms.tex, _r_sprite_batch.primary_texture);
+	r_uniform_sampler_array(_r_sprite_batch.uniforms.tex_aux, 0, R_NUM_SPRITE_AUX_TEXTURES, _r_sprite_batch.aux_textures);
 	r_framebuffer(_r_sprite_batch.framebuffer);
 	r_blend(_r_sprite_batch.blend);
 	r_capabilities(_r_sprite_batch.capbits);
@@ -162,7 +261,12 @@ void r_flush_sprites(void) {
 		r_cull(_r_sprite_batch.cull_mode);
 	}
 
-	r_draw_model_ptr(&_r_sprite_batch.quad, pending, 0);
+	if(_r_sprite_batch.pending_compact) {
+		r_draw_model_ptr(&_r_sprite_batch.quad_compact, pending, 0);
+	} else {
+		r_draw_model_ptr(&_r_sprite_batch.quad, pending, 0);
+	}
+
 	r_vertex_buffer_invalidate(_r_sprite_batch.vbuf);
 
 	r_mat_proj_pop();
@@ -292,6 +396,8 @@ void r_sprite_batch_prepare_state(const SpriteStateParams *stp) {
 	if(stp->shader != _r_sprite_batch.shader) {
 		r_flush_sprites();
 		_r_sprite_batch.shader = stp->shader;
+		_r_sprite_batch.uniforms.tex = r_shader_uniform(stp->shader, "tex");
+		_r_sprite_batch.uniforms.tex_aux = r_shader_uniform(stp->shader, "tex_aux[0]");
 	}
 
 	BlendMode blend = stp->blend;
@@ -335,9 +441,88 @@ void r_sprite_batch_prepare_state(const SpriteStateParams *stp) {
 	}
 }
 
+INLINE bool color_is_unorm(const Color *c) {
+	return
+		c->r >= 0 && c->r <= 1 &&
+		c->g >= 0 && c->g <= 1 &&
+		c->b >= 0 && c->b <= 1 &&
+		c->a >= 0 && c->a <= 1;
+}
+
+static bool _r_sprite_batch_attribs_compactable(const SpriteInstanceAttribs *attribs) {
+	const vec4 *mv = attribs->mv_transform;
+
+	return
+		mv[0][2] == 0 && mv[0][3] == 0 &&
+		mv[1][2] == 0 && mv[1][3] == 0 &&
+		mv[2][0] == 0 && mv[2][1] == 0 && mv[2][2] == 1 && mv[2][3] == 0 &&
+		mv[3][2] == 0 && mv[3][3] == 1 &&
+		!memcmp(attribs->tex_transform, sprite_batch_constants + 1, sizeof(mat4)) &&
+		color_is_unorm(&attribs->rgba);
+}
+
+static void _r_sprite_batch_compact_attribs(
+	const SpriteInstanceAttribs *restrict attribs,
+	SpriteCompactInstanceAttribs *restrict out_attribs
+) {
+	const vec4 *mv = attribs->mv_transform;
+	const Color *c = &attribs->rgba;
+
+	*out_attribs = (SpriteCompactInstanceAttribs) {
+		.mv_transform_col0 = { mv[0][0], mv[0][1] },
+		.mv_transform_col1 = { mv[1][0], mv[1][1] },
+		.mv_translation = { mv[3][0], mv[3][1] },
+		.texrect = { attribs->texrect.x, attribs->texrect.y, attribs->texrect.w, attribs->texrect.h },
+		.sprite_size = { attribs->sprite_size.w, attribs->sprite_size.h },
+		.custom = { attribs->custom.vector[0], attribs->custom.vector[1], attribs->custom.vector[2], attribs->custom.vector[3] },
+		.rgba = {
+			(uint8_t)(c->r * 255.0f + 0.5f),
+			(uint8_t)(c->g * 255.0f + 0.5f),
+			(uint8_t)(c->b * 255.0f + 0.5f),
+			(uint8_t)(c->a * 255.0f + 0.5f),
+		},
+	};
+}
+
+static void _r_sprite_batch_expand_pending(SDL_RWops *stream) {
+	// Rewrite the pending batch in the full layout. The batch always starts at the beginning
+	// of the buffer, since it is invalidated on every flush.
+	assert(_r_sprite_batch.compact_backlog.num_elements == _r_sprite_batch.num_pending);
+	SDL_RWseek(stream, 0, RW_SEEK_SET);
+
+	dynarray_foreach_elem(&_r_sprite_batch.compact_backlog, SpriteInstanceAttribs *a, {
+		SDL_RWwrite(stream, a, SIZEOF_SPRITE_ATTRIBS, 1);
+	});
+
+	_r_sprite_batch.compact_backlog.num_elements = 0;
+	_r_sprite_batch.pending_compact = false;
+
+#if SPRITE_BATCH_STATS
+	_r_sprite_batch.frame_stats.expanded_batches++;
+#endif
+}
+
 void r_sprite_batch_add_instance(const SpriteInstanceAttribs *attribs) {
+	// The layout is chosen per batch: compact as long as every sprite in it fits, so that
+	// mixing layouts never causes an extra flush.
+	bool compact = _r_sprite_batch_attribs_compactable(attribs);
 	SDL_RWops *stream = r_vertex_buffer_get_stream(_r_sprite_batch.vbuf);
-	SDL_RWwrite(stream, attribs, SIZEOF_SPRITE_ATTRIBS, 1);
+
+	if(_r_sprite_batch.num_pending == 0) {
+		_r_sprite_batch.pending_compact = compact;
+		_r_sprite_batch.compact_backlog.num_elements = 0;
+	} else if(_r_sprite_batch.pending_compact && !compact) {
+		_r_sprite_batch_expand_pending(stream);
+	}
+
+	if(_r_sprite_batch.pending_compact) {
+		SpriteCompactInstanceAttribs cattribs;
+		_r_sprite_batch_compact_attribs(attribs, &cattribs);
+		SDL_RWwrite(stream, &cattribs, SIZEOF_SPRITE_COMPACT_ATTRIBS, 1);
+		*dynarray_append(&_r_sprite_batch.compact_backlog) = *attribs;
+	} else {
+		SDL_RWwrite(stream, attribs, SIZEOF_SPRITE_ATTRIBS, 1);
+	}
 
 	_r_sprite_batch.num_pending++;
 
@@ -371,8 +556,10 @@ void _r_sprite_batch_end_frame(void) {
 	}
 
 	static char buf[512];
-	snprintf(buf, sizeof(buf), "%6i sprites %6i flushes %9.02f spr/flush %6i best %6i worst %12.02f fps",
+	snprintf(buf, sizeof(buf), "%6i sprites (%6i compact, %4i batches expanded) %6i flushes %9.02f spr/flush %6i best %6i worst %12.02f fps",
 		_r_sprite_batch.frame_stats.sprites,
+		_r_sprite_batch.frame_stats.compact_sprites,
+		_r_sprite_batch.frame_stats.expanded_batches,
 		_r_sprite_batch.frame_stats.flushes,
 		_r_sprite_batch.frame_stats.sprites / (double)_r_sprite_batch.frame_stats.flushes,
 		_r_sprite_batch.frame_stats.best_batch,
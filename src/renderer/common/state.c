@@ -11,20 +11,61 @@
 #include "state.h"
 #include "backend.h"
 #include "matstack.h"
+#include "hashtable.h"
 
 #define RSTATE_STACK_SIZE 16
 
+#define RSTATE_BLOCK_STATS 0
+
+#ifndef RSTATE_BLOCK_STATS
+#ifdef DEBUG
+	#define RSTATE_BLOCK_STATS 1
+#else
+	#define RSTATE_BLOCK_STATS 0
+#endif
+#endif
+
+struct RenderStateBlock {
+	RenderStateBlockParams params;
+	RenderStateBlock *next;  // blocks with the same hash
+};
+
 static struct {
 	RendererStateRollback *head;
 	RendererStateRollback stack[RSTATE_STACK_SIZE];
+
+	// last applied block, as long as the state it covers hasn't been changed since
+	const RenderStateBlock *block;
+	ht_int2ptr_t blocks;
+	uint num_blocks;
+
+#if RSTATE_BLOCK_STATS
+	struct {
+		uint applied;
+		uint elided;
+		uint skipped_fields;
+	} frame_stats;
+#endif
 } _r_state;
 
 void _r_state_init(void) {
 	memset(&_r_state, 0, sizeof(_r_state));
+	ht_create(&_r_state.blocks);
 }
 
-void _r_state_shutdown(void) {
+static void *free_block_chain(int64_t key, void *data, void *arg) {
+	for(RenderStateBlock *blk = data, *next; blk; blk = next) {
+		next = blk->next;
+		mem_free(blk);
+	}
+
+	return NULL;
+}
 
+void _r_state_shutdown(void) {
+	ht_foreach(&_r_state.blocks, free_block_chain, NULL);
+	ht_destroy(&_r_state.blocks);
+	_r_state.block = NULL;
 }
 
 #define S (*_r_state.head)
@@ -48,6 +89,7 @@ void r_state_push(void) {
 
 	// memset(_r_state.head, 0, sizeof(*_r_state.head));
 	_r_state.head->dirty_bits = 0;
+	_r_state.head->block = _r_state.block;
 }
 
 void r_state_pop(void) {
@@ -89,6 +131,9 @@ void r_state_pop(void) {
 		B.scissor(S.scissor);
 	}
 
+	// Everything a block covers is now back to how it was at push time.
+	_r_state.block = S.block;
+
 	if(_r_state.head == _r_state.stack) {
 		_r_state.head = NULL;
 	} else {
@@ -97,6 +142,7 @@ void r_state_pop(void) {
 }
 
 void _r_state_touch_capabilities(void) {
+	_r_state.block = NULL;
 	TAINT(RSTATE_CAPABILITIES, {
 		S.capabilities = B.capabilities_current();
 	});
@@ -109,23 +155,27 @@ void _r_state_touch_color(void) {
 }
 
 void _r_state_touch_blend_mode(void) {
+	_r_state.block = NULL;
 	TAINT(RSTATE_BLENDMODE, {
 		S.blend_mode = B.blend_current();
 	});
 }
 
 void _r_state_touch_cull_mode(void) {
+	_r_state.block = NULL;
 	TAINT(RSTATE_CULLMODE, {
 		S.cull_mode = B.cull_current();
 	});
 }
 void _r_state_touch_depth_func(void) {
+	_r_state.block = NULL;
 	TAINT(RSTATE_DEPTHFUNC, {
 		S.depth_func = B.depth_func_current();
 	});
 }
 
 void _r_state_touch_shader(void) {
+	_r_state.block = NULL;
 	TAINT(RSTATE_SHADER, {
 		S.shader = B.shader_current();
 	});
@@ -146,3 +196,130 @@ void _r_state_touch_scissor(void) {
 		B.scissor_current(&S.scissor);
 	});
 }
+
+static uint64_t hash_block_params(const RenderStateBlockParams *p) {
+	// FNV-1a; p is normalized, so padding is zeroed
+	const uint8_t *bytes = (const uint8_t*)p;
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for(size_t i = 0; i < sizeof(*p); ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+
+	return hash;
+}
+
+static bool block_params_equal(const RenderStateBlockParams *a, const RenderStateBlockParams *b) {
+	return
+		a->fields == b->fields &&
+		a->shader == b->shader &&
+		a->blend == b->blend &&
+		a->capabilities == b->capabilities &&
+		a->cull == b->cull &&
+		a->depth_func == b->depth_func;
+}
+
+const RenderStateBlock *r_state_block(const RenderStateBlockParams *params) {
+	RenderStateBlockParams p;
+	memset(&p, 0, sizeof(p));
+	p.fields = params->fields;
+
+	if(p.fields & RSB_SHADER)       p.shader = params->shader;
+	if(p.fields & RSB_BLEND)        p.blend = params->blend;
+	if(p.fields & RSB_CAPABILITIES) p.capabilities = params->capabilities;
+	if(p.fields & RSB_CULL)         p.cull = params->cull;
+	if(p.fields & RSB_DEPTH_FUNC)   p.depth_func = params->depth_func;
+
+	uint64_t hash = hash_block_params(&p);
+	RenderStateBlock *head = ht_get(&_r_state.blocks, hash, NULL);
+
+	for(RenderStateBlock *blk = head; blk; blk = blk->next) {
+		if(block_params_equal(&blk->params, &p)) {
+			return blk;
+		}
+	}
+
+	auto blk = ALLOC(RenderStateBlock, {
+		.params = p,
+		.next = head,
+	});
+
+	ht_set(&_r_state.blocks, hash, blk);
+	++_r_state.num_blocks;
+	return blk;
+}
+
+const RenderStateBlockParams *r_state_block_params(const RenderStateBlock *block) {
+	return &block->params;
+}
+
+void r_state_block_apply(const RenderStateBlock *block) {
+	if(block == _r_state.block) {
+	#if RSTATE_BLOCK_STATS
+		++_r_state.frame_stats.elided;
+	#endif
+		return;
+	}
+
+	const RenderStateBlockParams *p = &block->params;
+	uint skipped = 0;
+
+	#define APPLY(field, getter, setter, value) do { \
+		if(p->fields & (field)) { \
+			if(B.getter() != (value)) { \
+				setter(value); \
+			} else { \
+				++skipped; \
+			} \
+		} \
+	} while(0)
+
+	APPLY(RSB_CAPABILITIES, capabilities_current, r_capabilities, p->capabilities);
+	APPLY(RSB_BLEND, blend_current, r_blend, p->blend);
+	APPLY(RSB_CULL, cull_current, r_cull, p->cull);
+	APPLY(RSB_DEPTH_FUNC, depth_func_current, r_depth_func, p->depth_func);
+	APPLY(RSB_SHADER, shader_current, r_shader_ptr, p->shader);
+
+	#undef APPLY
+
+	_r_state.block = block;
+
+#if RSTATE_BLOCK_STATS
+	++_r_state.frame_stats.applied;
+	_r_state.frame_stats.skipped_fields += skipped;
+#else
+	(void)skipped;
+#endif
+}
+
+#if RSTATE_BLOCK_STATS
+#include "resource/font.h"
+#include "global.h"
+#endif
+
+void _r_state_end_frame(void) {
+#if RSTATE_BLOCK_STATS
+	if(!_r_state.frame_stats.applied && !_r_state.frame_stats.elided) {
+		return;
+	}
+
+	static char buf[256];
+	snprintf(buf, sizeof(buf), "%6u blocks applied %6u elided %6u redundant fields skipped (%u unique)",
+		_r_state.frame_stats.applied,
+		_r_state.frame_stats.elided,
+		_r_state.frame_stats.skipped_fields,
+		_r_state.num_blocks
+	);
+
+	Font *font = res_font("monotiny");
+	text_draw(buf, &(TextParams) {
+		.pos = { 0, 2 * font_get_lineskip(font) },
+		.font_ptr = font,
+		.color = RGB(1, 1, 1),
+		.shader = "text_default",
+	});
+
+	memset(&_r_state.frame_stats, 0, sizeof(_r_state.frame_stats));
+#endif
+}
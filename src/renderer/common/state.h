@@ -49,6 +49,9 @@ typedef struct RendererStateRollback {
 	// TODO uniforms
 	Framebuffer *framebuffer;
 	IntRect scissor;
+
+	// state block that was current when this entry was pushed
+	const RenderStateBlock *block;
 } RendererStateRollback;
 
 void _r_state_touch_capabilities(void);
@@ -63,3 +66,4 @@ void _r_state_touch_scissor(void);
 
 void _r_state_init(void);
 void _r_state_shutdown(void);
+void _r_state_end_frame(void);
@@ -20,7 +20,10 @@
 #include "common_buffer.h"
 #include "vertex_buffer.h"
 #include "index_buffer.h"
+#include "program_cache.h"
 #include "vertex_array.h"
+#include "readback.h"
+#include "timer_query.h"
 #include "../glcommon/debug.h"
 #include "../glcommon/vtable.h"
 #include "resource/resource.h"
@@ -301,6 +304,7 @@ static void gl33_init_context(SDL_Window *window) {
 
 	glcommon_load_functions();
 	glcommon_check_capabilities();
+	gl33_program_cache_init();
 
 	if(glcommon_debug_requested()) {
 		glcommon_debug_enable();
@@ -362,9 +366,15 @@ static void gl33_init_context(SDL_Window *window) {
 
 	R.features |= r_feature_bit(RFEAT_TEXTURE_BOTTOMLEFT_ORIGIN);
 
+	if(glext.timer_query) {
+		R.features |= r_feature_bit(RFEAT_TIMER_QUERY);
+	}
+
 	if(glext.clear_texture) {
 		_r_backend.funcs.texture_clear = gl44_texture_clear;
 	}
+
+	gl33_readback_init();
 }
 
 static void gl33_apply_capability(RendererCapability cap, bool value) {
@@ -831,6 +841,7 @@ GLenum gl33_bindidx_to_glenum(BufferBindingIndex bindidx) {
 	static GLenum map[] = {
 		[GL33_BUFFER_BINDING_ARRAY] = GL_ARRAY_BUFFER,
 		[GL33_BUFFER_BINDING_COPY_WRITE] = GL_COPY_WRITE_BUFFER,
+		[GL33_BUFFER_BINDING_PIXEL_PACK] = GL_PIXEL_PACK_BUFFER,
 		[GL33_BUFFER_BINDING_PIXEL_UNPACK] = GL_PIXEL_UNPACK_BUFFER,
 	};
 
@@ -1183,6 +1194,7 @@ static void gl33_post_init(void) {
 }
 
 static void gl33_shutdown(void) {
+	gl33_readback_shutdown();
 	glcommon_unload_library();
 	SDL_GL_DeleteContext(R.gl_context);
 }
@@ -1380,10 +1392,12 @@ static void gl33_swap(SDL_Window *window) {
 	Framebuffer *prev_fb = r_framebuffer_current();
 	r_framebuffer(NULL);
 	gl33_sync_framebuffer();
+	gl33_readback_capture(&R.viewport.default_framebuffer);
 #ifndef __EMSCRIPTEN__
 	SDL_GL_SwapWindow(window);
 #endif
 	r_framebuffer(prev_fb);
+	gl33_readback_collect();
 
 	gl33_stats_post_frame();
 
@@ -1394,6 +1408,11 @@ static void gl33_swap(SDL_Window *window) {
 	memset(&R.viewport.active, 0, sizeof(R.viewport.active));
 }
 
+static void gl33_flush(void) {
+	r_flush_sprites();
+	glFlush();
+}
+
 static void gl33_blend(BlendMode mode) {
 	R.blend.mode.pending = mode;
 }
@@ -1460,11 +1479,15 @@ RendererBackend _r_backend_gl33 = {
 		.depth_func_current = gl33_depth_func_current,
 		.shader_language_supported = gl33_shader_language_supported,
 		.shader_object_compile = gl33_shader_object_compile,
+		.shader_object_ready = gl33_shader_object_ready,
+		.shader_object_finish = gl33_shader_object_finish,
 		.shader_object_destroy = gl33_shader_object_destroy,
 		.shader_object_set_debug_label = gl33_shader_object_set_debug_label,
 		.shader_object_get_debug_label = gl33_shader_object_get_debug_label,
 		.shader_object_transfer = gl33_shader_object_transfer,
 		.shader_program_link = gl33_shader_program_link,
+		.shader_program_ready = gl33_shader_program_ready,
+		.shader_program_finish = gl33_shader_program_finish,
 		.shader_program_destroy = gl33_shader_program_destroy,
 		.shader_program_set_debug_label = gl33_shader_program_set_debug_label,
 		.shader_program_get_debug_label = gl33_shader_program_get_debug_label,
@@ -1533,7 +1556,15 @@ RendererBackend _r_backend_gl33 = {
 		.vsync = gl33_vsync,
 		.vsync_current = gl33_vsync_current,
 		.swap = gl33_swap,
+		.flush = gl33_flush,
 		.screenshot = gl33_screenshot,
+		.screenshot_async = gl33_screenshot_async,
+		.screenshot_async_finish = gl33_screenshot_async_finish,
+		.timer_query_create = gl33_timer_query_create,
+		.timer_query_destroy = gl33_timer_query_destroy,
+		.timer_query_begin = gl33_timer_query_begin,
+		.timer_query_end = gl33_timer_query_end,
+		.timer_query_result = gl33_timer_query_result,
 	},
 	.custom = &(GLBackendData) {
 		.vtable = {
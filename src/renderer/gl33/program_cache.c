@@ -0,0 +1,266 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "program_cache.h"
+#include "util.h"
+#include "util/env.h"
+#include "rwops/rwops_crc32.h"
+#include "rwops/rwops_zstd.h"
+
+#define CACHE_VERSION 1
+#define CACHE_ROOT "cache/glprograms"
+#define CRC_INIT 0
+
+#define MAX_DRIVER_ID_SIZE  4096
+#define MAX_BINARY_SIZE     (16 * 1024 * 1024)
+
+static struct {
+	bool enabled;
+	char *driver_id;
+	size_t driver_id_size;
+	char dir[sizeof(CACHE_ROOT) + SHA256_HEXDIGEST_SIZE];
+	DYNAMIC_ARRAY(GLint) formats;
+} cache;
+
+void gl33_program_cache_init(void) {
+	cache.enabled = false;
+	dynarray_free_data(&cache.formats);
+	mem_free(cache.driver_id);
+	cache.driver_id = NULL;
+
+	if(!glext.get_program_binary || !env_get("TAISEI_GL_PROGRAM_CACHE", true)) {
+		return;
+	}
+
+	GLint num_formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+	if(num_formats < 1) {
+		return;
+	}
+
+	GLint formats[num_formats];
+	glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats);
+	dynarray_set_elements(&cache.formats, num_formats, formats);
+
+	cache.driver_id = strjoin(
+		(const char*)glGetString(GL_VENDOR), "\n",
+		(const char*)glGetString(GL_RENDERER), "\n",
+		(const char*)glGetString(GL_VERSION),
+	NULL);
+	cache.driver_id_size = strlen(cache.driver_id);
+
+	if(cache.driver_id_size > MAX_DRIVER_ID_SIZE) {
+		log_warn("Driver identification string is too long, program binary cache disabled");
+		return;
+	}
+
+	char driver_hash[SHA256_HEXDIGEST_SIZE];
+	sha256_hexdigest((uint8_t*)cache.driver_id, cache.driver_id_size, driver_hash, sizeof(driver_hash));
+	snprintf(cache.dir, sizeof(cache.dir), CACHE_ROOT "/%s", driver_hash);
+
+	cache.enabled = true;
+	log_info("Program binary cache enabled (%i formats supported)", num_formats);
+}
+
+bool gl33_program_cache_enabled(void) {
+	return cache.enabled;
+}
+
+bool gl33_program_cache_key(uint num_objects, ShaderObject *shobjs[num_objects], char key[PROGRAM_CACHE_KEY_SIZE]) {
+	if(!cache.enabled) {
+		return false;
+	}
+
+	uint8_t digest[SHA256_BLOCK_SIZE];
+	SHA256State *sha = sha256_new();
+
+	for(uint i = 0; i < num_objects; ++i) {
+		sha256_update(sha, shobjs[i]->source_hash, sizeof(shobjs[i]->source_hash));
+	}
+
+	sha256_final(sha, digest, sizeof(digest));
+	sha256_free(sha);
+
+	for(uint i = 0; i < sizeof(digest); ++i) {
+		snprintf(key + i * 2, 3, "%02x", digest[i]);
+	}
+
+	return true;
+}
+
+static bool format_supported(GLint format) {
+	dynarray_foreach_elem(&cache.formats, GLint *f, {
+		if(*f == format) {
+			return true;
+		}
+	});
+
+	return false;
+}
+
+static void *read_entry(SDL_RWops *stream, GLenum *out_format, GLsizei *out_size) {
+	uint32_t crc = CRC_INIT;
+	SDL_RWops *s = NOT_NULL(SDL_RWWrapCRC32(stream, &crc, false));
+	void *binary = NULL;
+
+	if(SDL_ReadU8(s) != CACHE_VERSION) {
+		log_debug("Version mismatch");
+		goto fail;
+	}
+
+	uint32_t driver_id_size = SDL_ReadLE32(s);
+
+	if(driver_id_size != cache.driver_id_size) {
+		log_debug("Driver mismatch");
+		goto fail;
+	}
+
+	char driver_id[MAX_DRIVER_ID_SIZE];
+
+	if(
+		SDL_RWread(s, driver_id, driver_id_size, 1) != 1 ||
+		memcmp(driver_id, cache.driver_id, driver_id_size)
+	) {
+		log_debug("Driver mismatch");
+		goto fail;
+	}
+
+	GLenum format = SDL_ReadLE32(s);
+	uint32_t size = SDL_ReadLE32(s);
+
+	if(!format_supported(format)) {
+		log_debug("Binary format 0x%04x is not supported by the driver", format);
+		goto fail;
+	}
+
+	if(size == 0 || size > MAX_BINARY_SIZE) {
+		log_debug("Bad binary size %u", size);
+		goto fail;
+	}
+
+	binary = mem_alloc(size);
+
+	if(SDL_RWread(s, binary, size, 1) != 1) {
+		log_debug("Read error");
+		goto fail;
+	}
+
+	uint32_t file_crc = SDL_ReadLE32(stream);
+
+	if(crc != file_crc) {
+		log_warn("CRC mismatch (%08x != %08x), cache entry is corrupted", crc, file_crc);
+		goto fail;
+	}
+
+	SDL_RWclose(s);
+	*out_format = format;
+	*out_size = size;
+	return binary;
+
+fail:
+	mem_free(binary);
+	SDL_RWclose(s);
+	return NULL;
+}
+
+bool gl33_program_cache_load(GLuint prog, const char *key) {
+	assert(cache.enabled);
+
+	char path[sizeof(cache.dir) + PROGRAM_CACHE_KEY_SIZE + 1];
+	snprintf(path, sizeof(path), "%s/%s", cache.dir, key);
+
+	SDL_RWops *stream = vfs_open(path, VFS_MODE_READ);
+
+	if(stream == NULL) {
+		return false;
+	}
+
+	stream = NOT_NULL(SDL_RWWrapZstdReader(stream, true));
+
+	GLenum format;
+	GLsizei size;
+	void *binary = read_entry(stream, &format, &size);
+	SDL_RWclose(stream);
+
+	if(binary == NULL) {
+		log_debug("Ignoring cached program %s", key);
+		return false;
+	}
+
+	glProgramBinary(prog, format, binary, size);
+	mem_free(binary);
+
+	GLint link_status;
+	glGetProgramiv(prog, GL_LINK_STATUS, &link_status);
+
+	if(!link_status) {
+		// Can happen after a driver update that didn't change the version string
+		log_info("Driver rejected cached program %s, relinking", key);
+		return false;
+	}
+
+	log_debug("Loaded program %s from cache", key);
+	return true;
+}
+
+void gl33_program_cache_store(GLuint prog, const char *key) {
+	assert(cache.enabled);
+
+	GLint size = 0;
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+
+	if(size <= 0 || size > MAX_BINARY_SIZE) {
+		return;
+	}
+
+	void *binary = mem_alloc(size);
+	GLenum format;
+	GLsizei written = 0;
+	glGetProgramBinary(prog, size, &written, &format, binary);
+
+	if(written <= 0) {
+		mem_free(binary);
+		return;
+	}
+
+	char path[sizeof(cache.dir) + PROGRAM_CACHE_KEY_SIZE + 1];
+	vfs_mkdir("cache");
+	vfs_mkdir(CACHE_ROOT);
+	vfs_mkdir(cache.dir);
+	snprintf(path, sizeof(path), "%s/%s", cache.dir, key);
+
+	SDL_RWops *out = vfs_open(path, VFS_MODE_WRITE);
+
+	if(out == NULL) {
+		log_error("VFS error: %s", vfs_get_error());
+		mem_free(binary);
+		return;
+	}
+
+	out = NOT_NULL(SDL_RWWrapZstdWriter(out, RW_ZSTD_LEVEL_DEFAULT, true));
+
+	uint32_t crc = CRC_INIT;
+	SDL_RWops *s = NOT_NULL(SDL_RWWrapCRC32(out, &crc, false));
+
+	SDL_WriteU8(s, CACHE_VERSION);
+	SDL_WriteLE32(s, cache.driver_id_size);
+	SDL_RWwrite(s, cache.driver_id, cache.driver_id_size, 1);
+	SDL_WriteLE32(s, format);
+	SDL_WriteLE32(s, written);
+	SDL_RWwrite(s, binary, written, 1);
+	SDL_RWclose(s);
+
+	SDL_WriteLE32(out, crc);
+	SDL_RWclose(out);
+
+	mem_free(binary);
+	log_debug("Stored program %s in cache", key);
+}
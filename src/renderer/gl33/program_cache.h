@@ -0,0 +1,39 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "opengl.h"
+#include "shader_object.h"
+#include "util/sha256.h"
+
+/*
+ * On-disk cache of linked program binaries (GL_ARB_get_program_binary).
+ *
+ * Entries are keyed by the sources of the program's shader objects, and stored per driver
+ * (vendor, renderer and version strings), since binaries are not portable between them.
+ * A binary rejected by the driver is treated as a cache miss, and gets replaced after the
+ * program is linked normally.
+ */
+
+#define PROGRAM_CACHE_KEY_SIZE SHA256_HEXDIGEST_SIZE
+
+void gl33_program_cache_init(void);
+bool gl33_program_cache_enabled(void);
+
+bool gl33_program_cache_key(uint num_objects, ShaderObject *shobjs[num_objects], char key[PROGRAM_CACHE_KEY_SIZE])
+	attr_nonnull_all;
+
+// Returns true if the program has been successfully loaded and linked from the cache.
+bool gl33_program_cache_load(GLuint prog, const char *key)
+	attr_nonnull_all;
+
+// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+void gl33_program_cache_store(GLuint prog, const char *key)
+	attr_nonnull_all;
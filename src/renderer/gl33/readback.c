@@ -0,0 +1,249 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "readback.h"
+#include "gl33.h"
+#include "dynarray.h"
+#include "util.h"
+
+typedef struct ReadbackRequest {
+	ScreenshotCallback callback;
+	void *userdata;
+} ReadbackRequest;
+
+typedef struct ReadbackSlot {
+	ReadbackRequest req;
+	GLuint pbo;
+	GLsizeiptr pbo_size;
+	GLsync fence;
+	uint width;
+	uint height;
+	bool busy;
+} ReadbackSlot;
+
+static struct {
+	// Requests made since the last swap.
+	DYNAMIC_ARRAY(ReadbackRequest) requests;
+
+	// Captures in flight. The oldest one lives in the slot that will be reused next.
+	ReadbackSlot slots[READBACK_RING_SIZE];
+	uint next;
+
+	bool async;
+} RB;
+
+void gl33_readback_init(void) {
+#ifdef __EMSCRIPTEN__
+	// WebGL can't map buffers
+	RB.async = false;
+#else
+	RB.async = glext.pixel_buffer_object && glext.sync && HAVE_GL_FUNC(glMapBufferRange);
+#endif
+
+	if(RB.async) {
+		log_info("Using pixel pack buffers for asynchronous screenshots");
+	} else {
+		log_info("Asynchronous screenshots are not supported; falling back to synchronous readback");
+	}
+}
+
+static void gl33_readback_fail(const ReadbackRequest *req) {
+	req->callback(NULL, req->userdata);
+}
+
+// Returns false if the capture is not ready yet and wait is false.
+static bool gl33_readback_deliver(ReadbackSlot *slot, bool wait) {
+	assert(slot->busy);
+
+	GLenum status;
+
+	if(wait) {
+		do {
+			status = glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+		} while(status == GL_TIMEOUT_EXPIRED);
+	} else {
+		status = glClientWaitSync(slot->fence, 0, 0);
+
+		if(status == GL_TIMEOUT_EXPIRED) {
+			return false;
+		}
+	}
+
+	glDeleteSync(slot->fence);
+	slot->fence = NULL;
+	slot->busy = false;
+
+	// The callback may request another capture, so don't hold on to the slot.
+	ReadbackRequest req = slot->req;
+
+	if(status == GL_WAIT_FAILED) {
+		log_error("glClientWaitSync() failed");
+		gl33_readback_fail(&req);
+		return true;
+	}
+
+	Pixmap px = {
+		.width = slot->width,
+		.height = slot->height,
+		.format = PIXMAP_FORMAT_RGBA8,
+		.origin = PIXMAP_ORIGIN_BOTTOMLEFT,
+	};
+
+	px.data.untyped = pixmap_alloc_buffer_for_copy(&px, &px.data_size);
+	assert(px.data_size == slot->pbo_size);
+
+	gl33_bind_buffer(GL33_BUFFER_BINDING_PIXEL_PACK, slot->pbo);
+	gl33_sync_buffer(GL33_BUFFER_BINDING_PIXEL_PACK);
+
+	void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, px.data_size, GL_MAP_READ_BIT);
+
+	if(mapped) {
+		memcpy(px.data.untyped, mapped, px.data_size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+
+	gl33_bind_buffer(GL33_BUFFER_BINDING_PIXEL_PACK, 0);
+	gl33_sync_buffer(GL33_BUFFER_BINDING_PIXEL_PACK);
+
+	if(!mapped) {
+		log_error("glMapBufferRange() failed");
+		mem_free(px.data.untyped);
+		gl33_readback_fail(&req);
+		return true;
+	}
+
+	req.callback(&px, req.userdata);
+	return true;
+}
+
+static void gl33_readback_poll(bool wait) {
+	// Deliver in submission order; stop at the first capture that isn't ready yet.
+	for(uint i = 0; i < READBACK_RING_SIZE; ++i) {
+		ReadbackSlot *slot = RB.slots + (RB.next + i) % READBACK_RING_SIZE;
+
+		if(slot->busy && !gl33_readback_deliver(slot, wait)) {
+			break;
+		}
+	}
+}
+
+static void gl33_readback_capture_sync(const ReadbackRequest *req) {
+	Pixmap px;
+
+	if(r_screenshot(&px)) {
+		req->callback(&px, req->userdata);
+	} else {
+		gl33_readback_fail(req);
+	}
+}
+
+static void gl33_readback_capture_async(const ReadbackRequest *req, const FloatRect *vp) {
+	ReadbackSlot *slot = RB.slots + RB.next;
+
+	if(slot->busy) {
+		// The GPU is READBACK_RING_SIZE captures behind; the oldest one has to be waited for.
+		// Everything older than it has already been delivered, so order is preserved.
+		gl33_readback_deliver(slot, true);
+	}
+
+	RB.next = (RB.next + 1) % READBACK_RING_SIZE;
+
+	slot->width = vp->w;
+	slot->height = vp->h;
+	GLsizeiptr size = (GLsizeiptr)slot->width * slot->height * 4;
+
+	if(!slot->pbo) {
+		glGenBuffers(1, &slot->pbo);
+	}
+
+	gl33_bind_buffer(GL33_BUFFER_BINDING_PIXEL_PACK, slot->pbo);
+	gl33_sync_buffer(GL33_BUFFER_BINDING_PIXEL_PACK);
+
+	if(slot->pbo_size != size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		slot->pbo_size = size;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadPixels(vp->x, vp->y, vp->w, vp->h, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	// Leave nothing bound, so that synchronous glReadPixels calls elsewhere aren't redirected.
+	gl33_bind_buffer(GL33_BUFFER_BINDING_PIXEL_PACK, 0);
+	gl33_sync_buffer(GL33_BUFFER_BINDING_PIXEL_PACK);
+
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot->req = *req;
+	slot->busy = true;
+}
+
+void gl33_readback_capture(const FloatRect *viewport) {
+	// Callbacks may append new requests while we're iterating; those are captured too.
+	for(uint i = 0; i < RB.requests.num_elements; ++i) {
+		ReadbackRequest req = dynarray_get(&RB.requests, i);
+
+		if(RB.async) {
+			gl33_readback_capture_async(&req, viewport);
+		} else {
+			gl33_readback_capture_sync(&req);
+		}
+	}
+
+	RB.requests.num_elements = 0;
+}
+
+void gl33_readback_collect(void) {
+	if(RB.async) {
+		gl33_readback_poll(false);
+	}
+}
+
+void gl33_screenshot_async(ScreenshotCallback callback, void *userdata) {
+	*dynarray_append(&RB.requests) = (ReadbackRequest) {
+		.callback = callback,
+		.userdata = userdata,
+	};
+}
+
+static void gl33_readback_fail_requests(void) {
+	for(uint i = 0; i < RB.requests.num_elements; ++i) {
+		ReadbackRequest req = dynarray_get(&RB.requests, i);
+		gl33_readback_fail(&req);
+	}
+
+	RB.requests.num_elements = 0;
+}
+
+void gl33_screenshot_async_finish(void) {
+	if(RB.async) {
+		gl33_readback_poll(true);
+	}
+
+	gl33_readback_fail_requests();
+}
+
+void gl33_readback_shutdown(void) {
+	for(uint i = 0; i < READBACK_RING_SIZE; ++i) {
+		ReadbackSlot *slot = RB.slots + (RB.next + i) % READBACK_RING_SIZE;
+
+		if(slot->busy) {
+			glDeleteSync(slot->fence);
+			slot->busy = false;
+			gl33_readback_fail(&slot->req);
+		}
+
+		if(slot->pbo) {
+			glDeleteBuffers(1, &slot->pbo);
+		}
+	}
+
+	gl33_readback_fail_requests();
+	dynarray_free_data(&RB.requests);
+	memset(&RB, 0, sizeof(RB));
+}
@@ -0,0 +1,28 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "../api.h"
+
+// Number of pixel pack buffers cycled through for asynchronous screenshots.
+// This is how many captures can be in flight before r_swap() has to wait for the oldest one.
+#define READBACK_RING_SIZE 3
+
+void gl33_readback_init(void);
+void gl33_readback_shutdown(void);
+
+// Must be called right before presenting, with the default framebuffer bound.
+void gl33_readback_capture(const FloatRect *viewport) attr_nonnull(1);
+
+// Delivers the captures that have completed since the last call, without blocking.
+void gl33_readback_collect(void);
+
+void gl33_screenshot_async(ScreenshotCallback callback, void *userdata);
+void gl33_screenshot_async_finish(void);
@@ -42,6 +42,23 @@ bool gl33_shader_language_supported(const ShaderLangInfo *lang, ShaderLangInfo *
 	return supported;
 }
 
+static void hash_source(const ShaderSource *source, uint8_t hash[SHA256_BLOCK_SIZE]) {
+	SHA256State *sha = sha256_new();
+	uint8_t stage = source->stage;
+	sha256_update(sha, &stage, sizeof(stage));
+	sha256_update(sha, (const uint8_t*)source->content, source->content_size);
+
+	for(uint i = 0; i < source->meta.glsl.num_attributes; ++i) {
+		GLSLAttribute *a = source->meta.glsl.attributes + i;
+		int32_t loc = a->location;
+		sha256_update(sha, (const uint8_t*)&loc, sizeof(loc));
+		sha256_update(sha, (const uint8_t*)a->name, strlen(a->name) + 1);
+	}
+
+	sha256_final(sha, hash, SHA256_BLOCK_SIZE);
+	sha256_free(sha);
+}
+
 static void print_info_log(GLuint shader) {
 	GLint len = 0, alen = 0;
 	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
@@ -67,8 +84,6 @@ ShaderObject *gl33_shader_object_compile(ShaderSource *source) {
 			: GL_FRAGMENT_SHADER
 	);
 
-	GLint status;
-
 	// log_debug("Source code for %s:\n%s", path, source->content);
 
 	glShaderSource(
@@ -79,6 +94,60 @@ ShaderObject *gl33_shader_object_compile(ShaderSource *source) {
 
 	glCompileShader(gl_handle);
 
+	uint nattribs = source->meta.glsl.num_attributes;
+
+	auto shobj = ALLOC(ShaderObject, {
+		.gl_handle = gl_handle,
+		.stage = source->stage,
+		.num_attribs = nattribs,
+		.compile_pending = true,
+	});
+	snprintf(shobj->debug_label, sizeof(shobj->debug_label), "Shader object #%i", gl_handle);
+	hash_source(source, shobj->source_hash);
+
+	if(nattribs > 0) {
+		shobj->attribs = ALLOC_ARRAY(nattribs, typeof(*shobj->attribs));
+	}
+
+	for(uint i = 0; i < nattribs; ++i) {
+		GLSLAttribute *a = source->meta.glsl.attributes + i;
+		shobj->attribs[i].name = strdup(a->name);
+		shobj->attribs[i].location = a->location;
+	}
+
+	if(glext.parallel_shader_compile) {
+		// Let the driver compile in the background; the caller will check the result later.
+		return shobj;
+	}
+
+	if(!gl33_shader_object_finish(shobj)) {
+		gl33_shader_object_destroy(shobj);
+		return NULL;
+	}
+
+	return shobj;
+}
+
+bool gl33_shader_object_ready(ShaderObject *shobj) {
+	if(!shobj->compile_pending) {
+		return true;
+	}
+
+	assert(glext.parallel_shader_compile);
+
+	GLint done = GL_TRUE;
+	glGetShaderiv(shobj->gl_handle, GL_COMPLETION_STATUS_KHR, &done);
+	return done;
+}
+
+bool gl33_shader_object_finish(ShaderObject *shobj) {
+	if(!shobj->compile_pending) {
+		return true;
+	}
+
+	shobj->compile_pending = false;
+	GLuint gl_handle = shobj->gl_handle;
+
 #if defined DEBUG && !defined STATIC_GLES3
 	if(GLAD_GL_ANGLE_translated_shader_source) {
 		GLint srclen;
@@ -92,35 +161,11 @@ ShaderObject *gl33_shader_object_compile(ShaderSource *source) {
 	}
 #endif
 
+	GLint status;
 	glGetShaderiv(gl_handle, GL_COMPILE_STATUS, &status);
 	print_info_log(gl_handle);
 
-	ShaderObject *shobj = NULL;
-
-	if(status) {
-		uint nattribs = source->meta.glsl.num_attributes;
-
-		shobj = ALLOC(ShaderObject, {
-			.gl_handle = gl_handle,
-			.stage = source->stage,
-			.num_attribs = nattribs,
-		});
-		snprintf(shobj->debug_label, sizeof(shobj->debug_label), "Shader object #%i", gl_handle);
-
-		if(nattribs > 0) {
-			shobj->attribs = ALLOC_ARRAY(nattribs, typeof(*shobj->attribs));
-		}
-
-		for(uint i = 0; i < nattribs; ++i) {
-			GLSLAttribute *a = source->meta.glsl.attributes + i;
-			shobj->attribs[i].name = strdup(a->name);
-			shobj->attribs[i].location = a->location;
-		}
-	} else {
-		glDeleteShader(gl_handle);
-	}
-
-	return shobj;
+	return status;
 }
 
 void gl33_shader_object_destroy(ShaderObject *shobj) {
@@ -229,45 +229,117 @@ static GLuint get_texture_target(Texture *tex, UniformType utype) {
 	}
 }
 
-static void *gl33_sync_uniform(const char *key, void *value, void *arg) {
-	Uniform *uniform = value;
-
+static void gl33_sync_sampler_uniform(Uniform *uniform) {
 	// special case: for sampler uniforms, we have to construct the actual data from the texture pointers array.
 	UniformType utype = uniform->type;
-	if(UNIFORM_TYPE_IS_SAMPLER(utype)) {
-		Uniform *size_uniform = uniform->size_uniform;
-
-		for(uint i = 0; i < uniform->array_size; ++i) {
-			Texture *tex = uniform->textures[i];
-			GLuint preferred_unit = CASTPTR_ASSUME_ALIGNED(uniform->cache.pending, int)[i];
-			GLuint unit = gl33_bind_texture(tex, get_texture_target(tex, utype), preferred_unit);
+	Uniform *size_uniform = uniform->size_uniform;
+	assert(UNIFORM_TYPE_IS_SAMPLER(utype));
 
-			if(unit != preferred_unit) {
-				gl33_update_uniform(uniform, i, 1, &unit);
-			}
+	for(uint i = 0; i < uniform->array_size; ++i) {
+		Texture *tex = uniform->textures[i];
+		GLuint preferred_unit = CASTPTR_ASSUME_ALIGNED(uniform->cache.pending, int)[i];
+		GLuint unit = gl33_bind_texture(tex, get_texture_target(tex, utype), preferred_unit);
 
-			if(size_uniform) {
-				uint w, h;
+		if(unit != preferred_unit) {
+			gl33_update_uniform(uniform, i, 1, &unit);
+		}
 
-				if(tex) {
-					r_texture_get_size(tex, 0, &w, &h);
-				} else {
-					w = h = 0;
-				}
+		if(size_uniform) {
+			uint w, h;
 
-				vec2_noalign size = { w, h };
-				gl33_update_uniform(size_uniform, i, 1, &size);
-				gl33_commit_uniform(size_uniform);
+			if(tex) {
+				r_texture_get_size(tex, 0, &w, &h);
+			} else {
+				w = h = 0;
 			}
+
+			vec2_noalign size = { w, h };
+			gl33_update_uniform(size_uniform, i, 1, &size);
+			gl33_commit_uniform(size_uniform);
 		}
 	}
 
 	gl33_commit_uniform(uniform);
-	return NULL;
 }
 
 void gl33_sync_uniforms(ShaderProgram *prog) {
-	ht_foreach(&prog->uniforms, gl33_sync_uniform, NULL);
+	// Samplers are synced unconditionally, since their textures must be (re)bound to units every time.
+	for(uint i = 0; i < prog->num_sampler_uniforms; ++i) {
+		gl33_sync_sampler_uniform(prog->sampler_uniforms[i]);
+	}
+
+	uint num_words = (prog->num_active_uniforms + 31) / 32;
+
+	for(uint w = 0; w < num_words; ++w) {
+		uint32_t bits = prog->dirty_uniforms[w];
+		prog->dirty_uniforms[w] = 0;
+
+		while(bits) {
+			uint idx = w * 32 + __builtin_ctz(bits);
+			bits &= bits - 1;
+			gl33_commit_uniform(prog->active_uniforms[idx]);
+		}
+	}
+}
+
+static void gl33_mark_uniform_dirty(Uniform *uniform) {
+	ShaderProgram *prog = uniform->prog;
+
+	if(uniform->location == INVALID_UNIFORM_LOCATION) {
+		// orphaned by a shader reload; not in the active list anymore
+		return;
+	}
+
+	assert(uniform->index < prog->num_active_uniforms);
+	prog->dirty_uniforms[uniform->index / 32] |= 1u << (uniform->index % 32);
+}
+
+static void gl33_index_uniforms(ShaderProgram *prog) {
+	mem_free(prog->active_uniforms);
+	mem_free(prog->sampler_uniforms);
+	mem_free(prog->dirty_uniforms);
+
+	uint num_active = 0, num_samplers = 0;
+	ht_str2ptr_iter_t iter;
+
+	ht_iter_begin(&prog->uniforms, &iter);
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		Uniform *u = iter.value;
+
+		if(u->location != INVALID_UNIFORM_LOCATION) {
+			++num_active;
+			num_samplers += UNIFORM_TYPE_IS_SAMPLER(u->type);
+		}
+	}
+	ht_iter_end(&iter);
+
+	prog->num_active_uniforms = num_active;
+	prog->num_sampler_uniforms = num_samplers;
+	prog->active_uniforms = ALLOC_ARRAY(num_active, Uniform*);
+	prog->sampler_uniforms = ALLOC_ARRAY(num_samplers, Uniform*);
+	prog->dirty_uniforms = ALLOC_ARRAY((num_active + 31) / 32, uint32_t);
+
+	num_active = num_samplers = 0;
+
+	ht_iter_begin(&prog->uniforms, &iter);
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		Uniform *u = iter.value;
+
+		if(u->location == INVALID_UNIFORM_LOCATION) {
+			continue;
+		}
+
+		u->index = num_active;
+		prog->active_uniforms[num_active++] = u;
+
+		if(UNIFORM_TYPE_IS_SAMPLER(u->type)) {
+			prog->sampler_uniforms[num_samplers++] = u;
+		}
+
+		// Some uniforms may have pending updates already
+		gl33_mark_uniform_dirty(u);
+	}
+	ht_iter_end(&iter);
 }
 
 void gl33_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
@@ -299,6 +371,7 @@ void gl33_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
 		memcpy(uniform->textures + offset, textures, sizeof(Texture*) * count);
 	} else {
 		gl33_update_uniform(uniform, offset, count, data);
+		gl33_mark_uniform_dirty(uniform);
 	}
 }
 
@@ -306,8 +379,6 @@ static bool cache_uniforms(ShaderProgram *prog) {
 	int maxlen = 0;
 	GLint unicount;
 
-	ht_create(&prog->uniforms);
-
 	glGetProgramiv(prog->gl_handle, GL_ACTIVE_UNIFORMS, &unicount);
 	glGetProgramiv(prog->gl_handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxlen);
 
@@ -462,6 +533,7 @@ static bool cache_uniforms(ShaderProgram *prog) {
 	}
 	ht_iter_end(&iter);
 
+	gl33_index_uniforms(prog);
 	return true;
 }
 
@@ -530,6 +602,9 @@ void gl33_shader_program_destroy(ShaderProgram *prog) {
 	glDeleteProgram(prog->gl_handle);
 	ht_foreach(&prog->uniforms, free_uniform, NULL);
 	ht_destroy(&prog->uniforms);
+	mem_free(prog->active_uniforms);
+	mem_free(prog->sampler_uniforms);
+	mem_free(prog->dirty_uniforms);
 	mem_free(prog);
 }
 
@@ -538,6 +613,18 @@ ShaderProgram *gl33_shader_program_link(uint num_objects, ShaderObject *shobjs[n
 
 	prog->gl_handle = glCreateProgram();
 	snprintf(prog->debug_label, sizeof(prog->debug_label), "Shader program #%i", prog->gl_handle);
+	ht_create(&prog->uniforms);
+
+	bool use_cache = gl33_program_cache_key(num_objects, shobjs, prog->link.cache_key);
+
+	if(use_cache && gl33_program_cache_load(prog->gl_handle, prog->link.cache_key)) {
+		if(!cache_uniforms(prog)) {
+			gl33_shader_program_destroy(prog);
+			return NULL;
+		}
+
+		return prog;
+	}
 
 	for(int i = 0; i < num_objects; ++i) {
 		ShaderObject *shobj = shobjs[i];
@@ -550,7 +637,46 @@ ShaderProgram *gl33_shader_program_link(uint num_objects, ShaderObject *shobjs[n
 		}
 	}
 
+	if(use_cache) {
+		glProgramParameteri(prog->gl_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
 	glLinkProgram(prog->gl_handle);
+
+	prog->link.pending = true;
+	prog->link.store_in_cache = use_cache;
+
+	if(glext.parallel_shader_compile) {
+		// Let the driver link in the background; the caller will check the result later.
+		return prog;
+	}
+
+	if(!gl33_shader_program_finish(prog)) {
+		gl33_shader_program_destroy(prog);
+		return NULL;
+	}
+
+	return prog;
+}
+
+bool gl33_shader_program_ready(ShaderProgram *prog) {
+	if(!prog->link.pending) {
+		return true;
+	}
+
+	assert(glext.parallel_shader_compile);
+
+	GLint done = GL_TRUE;
+	glGetProgramiv(prog->gl_handle, GL_COMPLETION_STATUS_KHR, &done);
+	return done;
+}
+
+bool gl33_shader_program_finish(ShaderProgram *prog) {
+	if(!prog->link.pending) {
+		return true;
+	}
+
+	prog->link.pending = false;
 	print_info_log(prog->gl_handle);
 
 	GLint link_status;
@@ -558,17 +684,14 @@ ShaderProgram *gl33_shader_program_link(uint num_objects, ShaderObject *shobjs[n
 
 	if(!link_status) {
 		log_error("Failed to link the shader program");
-		glDeleteProgram(prog->gl_handle);
-		mem_free(prog);
-		return NULL;
+		return false;
 	}
 
-	if(!cache_uniforms(prog)) {
-		gl33_shader_program_destroy(prog);
-		return NULL;
+	if(prog->link.store_in_cache) {
+		gl33_program_cache_store(prog->gl_handle, prog->link.cache_key);
 	}
 
-	return prog;
+	return cache_uniforms(prog);
 }
 
 void gl33_shader_program_set_debug_label(ShaderProgram *prog, const char *label) {
@@ -684,7 +807,12 @@ bool gl33_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
 
 	ht_destroy(&old_new_map);
 	ht_destroy(&src->uniforms);
+	mem_free(src->active_uniforms);
+	mem_free(src->sampler_uniforms);
+	mem_free(src->dirty_uniforms);
 	mem_free(src);
 
+	gl33_index_uniforms(dst);
+
 	return true;
 }
@@ -13,6 +13,7 @@
 #include "hashtable.h"
 #include "../api.h"
 #include "opengl.h"
+#include "program_cache.h"
 #include "resource/shader_program.h"
 
 typedef enum MagicUniformIndex {
@@ -33,6 +34,22 @@ struct ShaderProgram {
 	GLuint gl_handle;
 	ht_str2ptr_t uniforms;
 	Uniform *magic_uniforms[NUM_MAGIC_UNIFORMS];
+
+	// Flat views of the active uniforms, rebuilt whenever the uniform set changes.
+	// Uniform.index points into active_uniforms and dirty_uniforms (a bitset).
+	Uniform **active_uniforms;
+	Uniform **sampler_uniforms;
+	uint32_t *dirty_uniforms;
+	uint num_active_uniforms;
+	uint num_sampler_uniforms;
+
+	// Set while the link status hasn't been checked yet; see gl33_shader_program_finish.
+	struct {
+		bool pending;
+		bool store_in_cache;
+		char cache_key[PROGRAM_CACHE_KEY_SIZE];
+	} link;
+
 	char debug_label[R_DEBUG_LABEL_SIZE];
 };
 
@@ -47,6 +64,7 @@ struct Uniform {
 	size_t elem_size; // bytes
 	uint array_size; // elements
 	uint location;
+	uint index;
 	UniformType type;
 
 	// corresponding _SIZE uniform (for samplers; optional)
@@ -65,6 +83,8 @@ struct Uniform {
 void gl33_sync_uniforms(ShaderProgram *prog);
 
 ShaderProgram *gl33_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]);
+bool gl33_shader_program_ready(ShaderProgram *prog);
+bool gl33_shader_program_finish(ShaderProgram *prog);
 void gl33_shader_program_destroy(ShaderProgram *prog);
 void gl33_shader_program_set_debug_label(ShaderProgram *prog, const char *label);
 const char* gl33_shader_program_get_debug_label(ShaderProgram *prog);
@@ -0,0 +1,85 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "timer_query.h"
+
+TimerQuery *gl33_timer_query_create(void) {
+	auto tq = ALLOC(TimerQuery);
+	glGenQueries(ARRAY_SIZE(tq->gl_handles), tq->gl_handles);
+	return tq;
+}
+
+void gl33_timer_query_destroy(TimerQuery *tq) {
+	assert(!tq->running);
+	glDeleteQueries(ARRAY_SIZE(tq->gl_handles), tq->gl_handles);
+	mem_free(tq);
+}
+
+static void gl33_timer_query_collect(TimerQuery *tq) {
+	// Queries complete in submission order, and the oldest one lives in the slot that
+	// will be reused next. Stop at the first one that isn't ready yet.
+	for(uint i = 0; i < TIMER_QUERY_RING_SIZE; ++i) {
+		uint slot = (tq->next + i) % TIMER_QUERY_RING_SIZE;
+
+		if(!(tq->pending_mask & (1u << slot))) {
+			continue;
+		}
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(tq->gl_handles[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if(!available) {
+			break;
+		}
+
+		GLuint64 nsec;
+		glGetQueryObjectui64v(tq->gl_handles[slot], GL_QUERY_RESULT, &nsec);
+		tq->pending_mask &= ~(1u << slot);
+		tq->result = nsec;
+		tq->have_result = true;
+	}
+}
+
+void gl33_timer_query_begin(TimerQuery *tq) {
+	assert(!tq->running);
+	gl33_timer_query_collect(tq);
+
+	uint slot = tq->next;
+	tq->next = (slot + 1) % TIMER_QUERY_RING_SIZE;
+
+	// If the GPU is more than TIMER_QUERY_RING_SIZE measurements behind,
+	// the oldest one is dropped rather than waited for.
+	tq->pending_mask &= ~(1u << slot);
+
+	glBeginQuery(GL_TIME_ELAPSED, tq->gl_handles[slot]);
+	tq->running = true;
+}
+
+void gl33_timer_query_end(TimerQuery *tq) {
+	assert(tq->running);
+
+	uint slot = (tq->next + TIMER_QUERY_RING_SIZE - 1) % TIMER_QUERY_RING_SIZE;
+	glEndQuery(GL_TIME_ELAPSED);
+	tq->pending_mask |= 1u << slot;
+	tq->running = false;
+}
+
+bool gl33_timer_query_result(TimerQuery *tq, uint64_t *out_nsec) {
+	if(!tq->running) {
+		gl33_timer_query_collect(tq);
+	}
+
+	if(tq->have_result) {
+		*out_nsec = tq->result;
+		return true;
+	}
+
+	return false;
+}
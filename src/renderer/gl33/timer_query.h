@@ -0,0 +1,32 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "../api.h"
+#include "opengl.h"
+
+// Number of GL query objects cycled through per TimerQuery.
+// This is how many frames a result can lag behind without stalling or being dropped.
+#define TIMER_QUERY_RING_SIZE 4
+
+struct TimerQuery {
+	GLuint gl_handles[TIMER_QUERY_RING_SIZE];
+	uint64_t result;
+	uint8_t pending_mask;
+	uint8_t next;
+	bool running;
+	bool have_result;
+};
+
+TimerQuery *gl33_timer_query_create(void);
+void gl33_timer_query_destroy(TimerQuery *tq);
+void gl33_timer_query_begin(TimerQuery *tq);
+void gl33_timer_query_end(TimerQuery *tq);
+bool gl33_timer_query_result(TimerQuery *tq, uint64_t *out_nsec);
@@ -255,6 +255,22 @@ static void glcommon_ext_depth_texture(void) {
 #endif
 }
 
+static void glcommon_ext_get_program_binary(void) {
+	EXT_FLAG(get_program_binary);
+
+	if(
+		!glext.version.is_webgl &&
+		HAVE_GL_FUNC(glGetProgramBinary) &&
+		HAVE_GL_FUNC(glProgramBinary) &&
+		HAVE_GL_FUNC(glProgramParameteri)
+	) {
+		CHECK_CORE(GL_ATLEAST(4, 1) || GLES_ATLEAST(3, 0));
+		CHECK_EXT(GL_ARB_get_program_binary);
+	}
+
+	EXT_MISSING();
+}
+
 static void glcommon_ext_instanced_arrays(void) {
 	EXT_FLAG(instanced_arrays);
 
@@ -288,6 +304,15 @@ static void glcommon_ext_internalformat_query2(void) {
 	EXT_MISSING();
 }
 
+static void glcommon_ext_parallel_shader_compile(void) {
+	EXT_FLAG(parallel_shader_compile);
+
+	CHECK_EXT(GL_KHR_parallel_shader_compile);
+	CHECK_EXT(GL_ARB_parallel_shader_compile);
+
+	EXT_MISSING();
+}
+
 static void glcommon_ext_draw_buffers(void) {
 	EXT_FLAG(draw_buffers);
 
@@ -304,6 +329,25 @@ static void glcommon_ext_draw_buffers(void) {
 #endif
 }
 
+static void glcommon_ext_sync(void) {
+	EXT_FLAG(sync);
+
+#ifdef STATIC_GLES3
+	CHECK_CORE(1);
+#else
+	if(
+		HAVE_GL_FUNC(glFenceSync) &&
+		HAVE_GL_FUNC(glClientWaitSync) &&
+		HAVE_GL_FUNC(glDeleteSync)
+	) {
+		CHECK_CORE(GL_ATLEAST(3, 2) || GLES_ATLEAST(3, 0));
+		CHECK_EXT(GL_ARB_sync);
+	}
+
+	EXT_MISSING();
+#endif
+}
+
 static void glcommon_ext_texture_filter_anisotropic(void) {
 	EXT_FLAG(texture_filter_anisotropic);
 
@@ -427,6 +471,24 @@ static void glcommon_ext_float_blend(void) {
 	EXT_MISSING();
 }
 
+static void glcommon_ext_timer_query(void) {
+	EXT_FLAG(timer_query);
+
+#ifndef STATIC_GLES3
+	// Desktop GL only; GPU timing is not available on GLES.
+	if(
+		HAVE_GL_FUNC(glGenQueries) &&
+		HAVE_GL_FUNC(glBeginQuery) &&
+		HAVE_GL_FUNC(glGetQueryObjectui64v)
+	) {
+		CHECK_CORE(GL_ATLEAST(3, 3));
+		CHECK_EXT(GL_ARB_timer_query);
+	}
+#endif
+
+	EXT_MISSING();
+}
+
 static void glcommon_ext_vertex_array_object(void) {
 	EXT_FLAG(vertex_array_object);
 
@@ -806,6 +868,25 @@ static void glcommon_check_issues(void) {
 
 static inline void (*load_gl_func(const char *name))(void);
 
+static void glcommon_setup_parallel_shader_compile(void) {
+#ifndef STATIC_GLES3
+	// Not in glad; the KHR and ARB versions share the same semantics.
+	union {
+		void (*fp);
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
+	} u = { load_gl_func("glMaxShaderCompilerThreadsKHR") };
+
+	if(u.glMaxShaderCompilerThreadsKHR == NULL) {
+		u.fp = load_gl_func("glMaxShaderCompilerThreadsARB");
+	}
+
+	if(u.glMaxShaderCompilerThreadsKHR != NULL) {
+		// 0xFFFFFFFF lets the driver pick the thread count
+		u.glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+#endif
+}
+
 void glcommon_check_capabilities(void) {
 	const char *glslv = (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);
 	const char *glv = (const char*)glGetString(GL_VERSION);
@@ -907,10 +988,13 @@ void glcommon_check_capabilities(void) {
 	glcommon_ext_depth_texture();
 	glcommon_ext_draw_buffers();
 	glcommon_ext_float_blend();
+	glcommon_ext_get_program_binary();
 	glcommon_ext_instanced_arrays();
 	glcommon_ext_internalformat_query2();
+	glcommon_ext_parallel_shader_compile();
 	glcommon_ext_pixel_buffer_object();
 	glcommon_ext_seamless_cubemap();
+	glcommon_ext_sync();
 	glcommon_ext_texture_filter_anisotropic();
 	glcommon_ext_texture_float();
 	glcommon_ext_texture_float_linear();
@@ -919,6 +1003,7 @@ void glcommon_check_capabilities(void) {
 	glcommon_ext_texture_norm16();
 	glcommon_ext_texture_rg();
 	glcommon_ext_texture_swizzle();
+	glcommon_ext_timer_query();
 	glcommon_ext_vertex_array_object();
 	glcommon_ext_viewport_array();
 
@@ -941,6 +1026,10 @@ void glcommon_check_capabilities(void) {
 	glcommon_ext_texture_format_atc();
 	glcommon_ext_texture_format_fxt1();
 
+	if(glext.parallel_shader_compile) {
+		glcommon_setup_parallel_shader_compile();
+	}
+
 	glcommon_build_shader_lang_table();
 	glcommon_init_texture_formats();
 	glcommon_check_issues();
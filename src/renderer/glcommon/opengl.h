@@ -82,6 +82,8 @@
 
 	#define glClearDepth glClearDepthf
 	#define glClearTexImage glClearTexImageEXT
+	#define glGetQueryObjectui64v glGetQueryObjectui64vEXT
+	#define GL_TIME_ELAPSED GL_TIME_ELAPSED_EXT
 #else
 	#include <glad/gl.h>
 	#define GL_FUNC(f) (glad_gl##f)
@@ -99,6 +101,13 @@ typedef void (APIENTRY *PFNGLREQUESTEXTENSIONANGLEPROC) (const GLchar *name);
 typedef void (APIENTRY *PFNGLDISABLEEXTENSIONANGLEPROC) (const GLchar *name);
 #endif /* GL_ANGLE_request_extension */
 
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (APIENTRY *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) (GLuint count);
+#endif /* GL_KHR_parallel_shader_compile */
+
 #include "assert.h"
 
 // NOTE: The ability to query supported GLSL versions was added in GL 4.3,
@@ -167,10 +176,13 @@ struct glext_s {
 	ext_flag_t depth_texture;
 	ext_flag_t draw_buffers;
 	ext_flag_t float_blend;
+	ext_flag_t get_program_binary;
 	ext_flag_t instanced_arrays;
 	ext_flag_t internalformat_query2;
+	ext_flag_t parallel_shader_compile;
 	ext_flag_t pixel_buffer_object;
 	ext_flag_t seamless_cubemap;
+	ext_flag_t sync;
 	ext_flag_t texture_filter_anisotropic;
 	ext_flag_t texture_float;
 	ext_flag_t texture_float_linear;
@@ -179,6 +191,7 @@ struct glext_s {
 	ext_flag_t texture_norm16;
 	ext_flag_t texture_rg;
 	ext_flag_t texture_swizzle;
+	ext_flag_t timer_query;
 	ext_flag_t vertex_array_object;
 	ext_flag_t viewport_array;
 
@@ -43,12 +43,16 @@ static DepthTestFunc null_depth_func_current(void) { return DEPTH_LESS; }
 static bool null_shader_language_supported(const ShaderLangInfo *lang, ShaderLangInfo *out_alternative) { return true; }
 
 static ShaderObject* null_shader_object_compile(ShaderSource *source) { return (void*)&placeholder; }
+static bool null_shader_object_ready(ShaderObject *shobj) { return true; }
+static bool null_shader_object_finish(ShaderObject *shobj) { return true; }
 static void null_shader_object_destroy(ShaderObject *shobj) { }
 static void null_shader_object_set_debug_label(ShaderObject *shobj, const char *label) { }
 static const char* null_shader_object_get_debug_label(ShaderObject *shobj) { return "Null shader object"; }
 static bool null_shader_object_transfer(ShaderObject *dst, ShaderObject *src) { return true; }
 
 static ShaderProgram* null_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) { return (void*)&placeholder; }
+static bool null_shader_program_ready(ShaderProgram *prog) { return true; }
+static bool null_shader_program_finish(ShaderProgram *prog) { return true; }
 static void null_shader_program_destroy(ShaderProgram *prog) { }
 static void null_shader_program_set_debug_label(ShaderProgram *prog, const char *label) { }
 static const char* null_shader_program_get_debug_label(ShaderProgram *prog) { return "Null shader program"; }
@@ -189,8 +193,17 @@ static void null_vsync(VsyncMode mode) { }
 static VsyncMode null_vsync_current(void) { return VSYNC_NONE; }
 
 static void null_swap(SDL_Window *window) { }
+static void null_flush(void) { }
 
 static bool null_screenshot(Pixmap *dest) { return false; }
+static void null_screenshot_async(ScreenshotCallback cb, void *userdata) { cb(NULL, userdata); }
+static void null_screenshot_async_finish(void) { }
+
+static TimerQuery* null_timer_query_create(void) { return (void*)&placeholder; }
+static void null_timer_query_destroy(TimerQuery *tq) { }
+static void null_timer_query_begin(TimerQuery *tq) { }
+static void null_timer_query_end(TimerQuery *tq) { }
+static bool null_timer_query_result(TimerQuery *tq, uint64_t *out_nsec) { return false; }
 
 RendererBackend _r_backend_null = {
 	.name = "null",
@@ -214,11 +227,15 @@ RendererBackend _r_backend_null = {
 		.depth_func_current = null_depth_func_current,
 		.shader_language_supported = null_shader_language_supported,
 		.shader_object_compile = null_shader_object_compile,
+		.shader_object_ready = null_shader_object_ready,
+		.shader_object_finish = null_shader_object_finish,
 		.shader_object_destroy = null_shader_object_destroy,
 		.shader_object_set_debug_label = null_shader_object_set_debug_label,
 		.shader_object_get_debug_label = null_shader_object_get_debug_label,
 		.shader_object_transfer = null_shader_object_transfer,
 		.shader_program_link = null_shader_program_link,
+		.shader_program_ready = null_shader_program_ready,
+		.shader_program_finish = null_shader_program_finish,
 		.shader_program_destroy = null_shader_program_destroy,
 		.shader_program_set_debug_label = null_shader_program_set_debug_label,
 		.shader_program_get_debug_label = null_shader_program_get_debug_label,
@@ -287,6 +304,14 @@ RendererBackend _r_backend_null = {
 		.vsync = null_vsync,
 		.vsync_current = null_vsync_current,
 		.swap = null_swap,
+		.flush = null_flush,
 		.screenshot = null_screenshot,
+		.screenshot_async = null_screenshot_async,
+		.screenshot_async_finish = null_screenshot_async_finish,
+		.timer_query_create = null_timer_query_create,
+		.timer_query_destroy = null_timer_query_destroy,
+		.timer_query_begin = null_timer_query_begin,
+		.timer_query_end = null_timer_query_end,
+		.timer_query_result = null_timer_query_result,
 	},
 };
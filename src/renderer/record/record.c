@@ -0,0 +1,1107 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "record.h"
+#include "../null/null.h"
+#include "resource/shader_object.h"
+
+typedef struct RecordObject {
+	uint32_t id;
+	char debug_label[R_DEBUG_LABEL_SIZE];
+} RecordObject;
+
+typedef struct RecordBuffer {
+	SDL_RWops stream;
+	RecordObject obj;
+	size_t size;
+	size_t offset;
+	size_t update_begin;
+	size_t update_end;
+} RecordBuffer;
+
+struct Texture {
+	RecordObject obj;
+	TextureParams params;
+};
+
+struct Framebuffer {
+	RecordObject obj;
+	Texture *attachments[FRAMEBUFFER_MAX_ATTACHMENTS];
+	uint attachment_mipmaps[FRAMEBUFFER_MAX_ATTACHMENTS];
+	FramebufferAttachment output_mapping[FRAMEBUFFER_MAX_OUTPUTS];
+	FloatRect viewport;
+};
+
+struct VertexBuffer {
+	RecordBuffer buf;
+};
+
+struct IndexBuffer {
+	RecordBuffer buf;
+	uint index_size;
+};
+
+struct VertexArray {
+	RecordObject obj;
+	VertexBuffer **attachments;
+	IndexBuffer *index_attachment;
+	uint num_attachments;
+};
+
+struct ShaderObject {
+	RecordObject obj;
+};
+
+struct ShaderProgram {
+	RecordObject obj;
+};
+
+typedef struct RecordStats {
+	uint32_t draw_calls;
+	uint32_t state_changes;
+	uint32_t redundant_state_changes;
+	uint64_t buffer_bytes;
+	uint64_t texture_bytes;
+} RecordStats;
+
+static struct {
+	SDL_RWops *log;
+	SDL_RWops *stats_out;
+	SDL_Window *window;
+	uint32_t next_id;
+	uint32_t frame;
+
+	RecordStats frame_stats;
+	RecordStats total_stats;
+	RecordStats max_stats;
+
+	struct {
+		r_capability_bits_t capabilities;
+		Color color;
+		BlendMode blend;
+		CullFaceMode cull;
+		DepthTestFunc depth_func;
+		ShaderProgram *shader;
+		Framebuffer *framebuffer;
+		FloatRect default_viewport;
+		IntRect scissor;
+		VsyncMode vsync;
+	} state;
+} R;
+
+#define STREAM_BUFFER(rw) ((RecordBuffer*)(rw))
+#define OBJ_ID(o) ((o) ? (o)->obj.id : 0)
+
+static void record_u8(uint8_t v) {
+	if(R.log) SDL_WriteU8(R.log, v);
+}
+
+static void record_u16(uint16_t v) {
+	if(R.log) SDL_WriteLE16(R.log, v);
+}
+
+static void record_u32(uint32_t v) {
+	if(R.log) SDL_WriteLE32(R.log, v);
+}
+
+static void record_u64(uint64_t v) {
+	if(R.log) SDL_WriteLE64(R.log, v);
+}
+
+static void record_f32(float v) {
+	union { float f; uint32_t u; } conv = { .f = v };
+	record_u32(conv.u);
+}
+
+static void record_floats(uint num, const float v[num]) {
+	for(uint i = 0; i < num; ++i) {
+		record_f32(v[i]);
+	}
+}
+
+static void record_state_change(RecordOp op, bool changed) {
+	if(changed) {
+		++R.frame_stats.state_changes;
+	} else {
+		++R.frame_stats.redundant_state_changes;
+	}
+
+	record_u8(op);
+}
+
+static void record_object_init(RecordObject *obj, RecordObjectType type, const char *kind) {
+	obj->id = ++R.next_id;
+	snprintf(obj->debug_label, sizeof(obj->debug_label), "%s #%u", kind, obj->id);
+	record_u8(RECORD_OP_CREATE);
+	record_u8(type);
+	record_u32(obj->id);
+}
+
+static void record_object_destroy(RecordObject *obj) {
+	record_u8(RECORD_OP_DESTROY);
+	record_u32(obj->id);
+}
+
+static void record_object_transfer(RecordObject *dst, RecordObject *src) {
+	record_u8(RECORD_OP_TRANSFER);
+	record_u32(dst->id);
+	record_u32(src->id);
+}
+
+static void record_object_set_debug_label(RecordObject *obj, const char *label) {
+	if(label) {
+		strlcpy(obj->debug_label, label, sizeof(obj->debug_label));
+	} else {
+		snprintf(obj->debug_label, sizeof(obj->debug_label), "Object #%u", obj->id);
+	}
+}
+
+/*
+ * Statistics
+ */
+
+static void record_stats_accumulate(RecordStats *total, RecordStats *max, const RecordStats *s) {
+	total->draw_calls += s->draw_calls;
+	total->state_changes += s->state_changes;
+	total->redundant_state_changes += s->redundant_state_changes;
+	total->buffer_bytes += s->buffer_bytes;
+	total->texture_bytes += s->texture_bytes;
+
+	max->draw_calls = umax(max->draw_calls, s->draw_calls);
+	max->state_changes = umax(max->state_changes, s->state_changes);
+	max->redundant_state_changes = umax(max->redundant_state_changes, s->redundant_state_changes);
+	max->buffer_bytes = umax(max->buffer_bytes, s->buffer_bytes);
+	max->texture_bytes = umax(max->texture_bytes, s->texture_bytes);
+}
+
+static void record_end_frame(void) {
+	RecordStats *s = &R.frame_stats;
+
+	record_u8(RECORD_OP_FRAME);
+	record_u32(R.frame);
+	record_u32(s->draw_calls);
+	record_u32(s->state_changes);
+	record_u32(s->redundant_state_changes);
+	record_u64(s->buffer_bytes);
+	record_u64(s->texture_bytes);
+
+	if(R.stats_out) {
+		SDL_RWprintf(R.stats_out, "%u,%u,%u,%u,%"PRIu64",%"PRIu64"\n",
+			R.frame,
+			s->draw_calls,
+			s->state_changes,
+			s->redundant_state_changes,
+			s->buffer_bytes,
+			s->texture_bytes
+		);
+	}
+
+	record_stats_accumulate(&R.total_stats, &R.max_stats, s);
+	*s = (RecordStats) { 0 };
+	++R.frame;
+}
+
+static void record_print_summary(void) {
+	if(!R.frame) {
+		return;
+	}
+
+	RecordStats *t = &R.total_stats;
+	RecordStats *m = &R.max_stats;
+	double f = R.frame;
+
+	log_info("Recorded %u frames", R.frame);
+	log_info("Draw calls per frame: %.1f avg, %u max", t->draw_calls / f, m->draw_calls);
+	log_info("State changes per frame: %.1f avg, %u max (plus %.1f avg redundant)",
+		t->state_changes / f, m->state_changes, t->redundant_state_changes / f);
+	log_info("Buffer uploads per frame: %.1f KiB avg, %.1f KiB max",
+		t->buffer_bytes / f / 1024.0, m->buffer_bytes / 1024.0);
+	log_info("Texture uploads per frame: %.1f KiB avg, %.1f KiB max",
+		t->texture_bytes / f / 1024.0, m->texture_bytes / 1024.0);
+}
+
+/*
+ * Init/shutdown
+ */
+
+static SDL_RWops *record_open_output(const char *env) {
+	const char *path = env_get(env, NULL);
+
+	if(!path || !*path) {
+		return NULL;
+	}
+
+	SDL_RWops *rw = SDL_RWFromFile(path, "wb");
+
+	if(!rw) {
+		log_sdl_error(LOG_ERROR, "SDL_RWFromFile");
+	} else {
+		log_info("%s: writing to %s", env, path);
+	}
+
+	return rw;
+}
+
+static void record_init(void) {
+	_r_backend_inherit(&_r_backend_record, &_r_backend_null);
+
+	R.state.color = *RGBA(1, 1, 1, 1);
+	R.state.blend = BLEND_NONE;
+	R.state.cull = CULL_BACK;
+	R.state.depth_func = DEPTH_LESS;
+	R.state.vsync = VSYNC_NONE;
+
+	R.log = record_open_output("TAISEI_RECORD_LOG");
+	R.stats_out = record_open_output("TAISEI_RECORD_STATS");
+
+	if(R.log) {
+		SDL_WriteLE32(R.log, RECORD_LOG_MAGIC);
+		SDL_WriteLE16(R.log, RECORD_LOG_VERSION);
+	}
+
+	if(R.stats_out) {
+		SDL_RWprintf(R.stats_out,
+			"frame,draw_calls,state_changes,redundant_state_changes,buffer_bytes,texture_bytes\n");
+	}
+}
+
+static void record_shutdown(void) {
+	record_print_summary();
+
+	if(R.log) {
+		SDL_RWclose(R.log);
+	}
+
+	if(R.stats_out) {
+		SDL_RWclose(R.stats_out);
+	}
+
+	R.log = R.stats_out = NULL;
+}
+
+static SDL_Window *record_create_window(const char *title, int x, int y, int w, int h, uint32_t flags) {
+	R.window = SDL_CreateWindow(title, x, y, w, h, flags);
+	return R.window;
+}
+
+/*
+ * Pipeline state
+ */
+
+static void record_capabilities(r_capability_bits_t capbits) {
+	record_state_change(RECORD_OP_CAPABILITIES, R.state.capabilities != capbits);
+	record_u32(capbits);
+	R.state.capabilities = capbits;
+}
+
+static r_capability_bits_t record_capabilities_current(void) {
+	return R.state.capabilities;
+}
+
+static void record_color4(float r, float g, float b, float a) {
+	Color c = { { r, g, b, a } };
+	record_state_change(RECORD_OP_COLOR, memcmp(&c, &R.state.color, sizeof(c)));
+	record_floats(4, (float[]) { r, g, b, a });
+	R.state.color = c;
+}
+
+static const Color *record_color_current(void) {
+	return &R.state.color;
+}
+
+static void record_blend(BlendMode mode) {
+	record_state_change(RECORD_OP_BLEND, R.state.blend != mode);
+	record_u32(mode);
+	R.state.blend = mode;
+}
+
+static BlendMode record_blend_current(void) {
+	return R.state.blend;
+}
+
+static void record_cull(CullFaceMode mode) {
+	record_state_change(RECORD_OP_CULL, R.state.cull != mode);
+	record_u8(mode);
+	R.state.cull = mode;
+}
+
+static CullFaceMode record_cull_current(void) {
+	return R.state.cull;
+}
+
+static void record_depth_func(DepthTestFunc func) {
+	record_state_change(RECORD_OP_DEPTH_FUNC, R.state.depth_func != func);
+	record_u8(func);
+	R.state.depth_func = func;
+}
+
+static DepthTestFunc record_depth_func_current(void) {
+	return R.state.depth_func;
+}
+
+static void record_shader(ShaderProgram *prog) {
+	record_state_change(RECORD_OP_SHADER, R.state.shader != prog);
+	record_u32(OBJ_ID(prog));
+	R.state.shader = prog;
+}
+
+static ShaderProgram *record_shader_current(void) {
+	return R.state.shader;
+}
+
+static void record_scissor(IntRect scissor) {
+	record_state_change(RECORD_OP_SCISSOR, memcmp(&scissor, &R.state.scissor, sizeof(scissor)));
+	record_u32(scissor.x);
+	record_u32(scissor.y);
+	record_u32(scissor.w);
+	record_u32(scissor.h);
+	R.state.scissor = scissor;
+}
+
+static void record_scissor_current(IntRect *scissor) {
+	*scissor = R.state.scissor;
+}
+
+static void record_vsync(VsyncMode mode) {
+	record_state_change(RECORD_OP_VSYNC, R.state.vsync != mode);
+	record_u8(mode);
+	R.state.vsync = mode;
+}
+
+static VsyncMode record_vsync_current(void) {
+	return R.state.vsync;
+}
+
+/*
+ * Buffers
+ */
+
+static int64_t record_buffer_stream_seek(SDL_RWops *rw, int64_t offset, int whence) {
+	RecordBuffer *buf = STREAM_BUFFER(rw);
+
+	switch(whence) {
+		case RW_SEEK_CUR: buf->offset += offset;            break;
+		case RW_SEEK_END: buf->offset = buf->size + offset; break;
+		case RW_SEEK_SET: buf->offset = offset;             break;
+	}
+
+	assert(buf->offset <= buf->size);
+	return buf->offset;
+}
+
+static int64_t record_buffer_stream_size(SDL_RWops *rw) {
+	return STREAM_BUFFER(rw)->size;
+}
+
+static size_t record_buffer_stream_write(SDL_RWops *rw, const void *data, size_t size, size_t num) {
+	RecordBuffer *buf = STREAM_BUFFER(rw);
+	size_t total_size = size * num;
+
+	if(UNLIKELY(buf->offset + total_size > buf->size)) {
+		buf->size = topow2(buf->offset + total_size);
+		buf->update_begin = 0;
+		buf->update_end = buf->size;
+	}
+
+	if(LIKELY(total_size > 0)) {
+		buf->update_begin = umin(buf->offset, buf->update_begin);
+		buf->update_end = umax(buf->offset + total_size, buf->update_end);
+		buf->offset += total_size;
+	}
+
+	return num;
+}
+
+static size_t record_buffer_stream_read(SDL_RWops *rw, void *data, size_t size, size_t num) {
+	SDL_SetError("Stream is write-only");
+	return 0;
+}
+
+static int record_buffer_stream_close(SDL_RWops *rw) {
+	SDL_SetError("Can't close a buffer stream");
+	return -1;
+}
+
+static void record_buffer_init(RecordBuffer *buf, size_t capacity) {
+	buf->stream.type = SDL_RWOPS_UNKNOWN;
+	buf->stream.close = record_buffer_stream_close;
+	buf->stream.read = record_buffer_stream_read;
+	buf->stream.write = record_buffer_stream_write;
+	buf->stream.seek = record_buffer_stream_seek;
+	buf->stream.size = record_buffer_stream_size;
+	buf->size = topow2(capacity);
+	buf->update_begin = buf->size;
+}
+
+// Like the GL backends, pending writes are only "uploaded" right before a draw call.
+static void record_buffer_flush(RecordBuffer *buf) {
+	if(buf->update_begin >= buf->update_end) {
+		return;
+	}
+
+	size_t update_size = buf->update_end - buf->update_begin;
+
+	record_u8(RECORD_OP_BUFFER_UPLOAD);
+	record_u32(buf->obj.id);
+	record_u32(buf->update_begin);
+	record_u32(update_size);
+	R.frame_stats.buffer_bytes += update_size;
+
+	buf->update_begin = buf->size;
+	buf->update_end = 0;
+}
+
+static void record_buffer_invalidate(RecordBuffer *buf) {
+	record_u8(RECORD_OP_BUFFER_INVALIDATE);
+	record_u32(buf->obj.id);
+	buf->offset = 0;
+}
+
+static VertexBuffer *record_vertex_buffer_create(size_t capacity, void *data) {
+	auto vbuf = ALLOC(VertexBuffer);
+	record_object_init(&vbuf->buf.obj, RECORD_OBJ_VERTEX_BUFFER, "VBO");
+	record_buffer_init(&vbuf->buf, capacity);
+	record_u32(vbuf->buf.size);
+
+	if(data) {
+		vbuf->buf.update_begin = 0;
+		vbuf->buf.update_end = capacity;
+	}
+
+	return vbuf;
+}
+
+static const char *record_vertex_buffer_get_debug_label(VertexBuffer *vbuf) {
+	return vbuf->buf.obj.debug_label;
+}
+
+static void record_vertex_buffer_set_debug_label(VertexBuffer *vbuf, const char *label) {
+	record_object_set_debug_label(&vbuf->buf.obj, label);
+}
+
+static void record_vertex_buffer_destroy(VertexBuffer *vbuf) {
+	record_object_destroy(&vbuf->buf.obj);
+	mem_free(vbuf);
+}
+
+static void record_vertex_buffer_invalidate(VertexBuffer *vbuf) {
+	record_buffer_invalidate(&vbuf->buf);
+}
+
+static SDL_RWops *record_vertex_buffer_get_stream(VertexBuffer *vbuf) {
+	return &vbuf->buf.stream;
+}
+
+static IndexBuffer *record_index_buffer_create(uint index_size, size_t max_elements) {
+	auto ibuf = ALLOC(IndexBuffer, { .index_size = index_size });
+	record_object_init(&ibuf->buf.obj, RECORD_OBJ_INDEX_BUFFER, "IBO");
+	record_buffer_init(&ibuf->buf, max_elements * index_size);
+	record_u8(index_size);
+	record_u32(ibuf->buf.size);
+	return ibuf;
+}
+
+static size_t record_index_buffer_get_capacity(IndexBuffer *ibuf) {
+	return ibuf->buf.size / ibuf->index_size;
+}
+
+static uint record_index_buffer_get_index_size(IndexBuffer *ibuf) {
+	return ibuf->index_size;
+}
+
+static const char *record_index_buffer_get_debug_label(IndexBuffer *ibuf) {
+	return ibuf->buf.obj.debug_label;
+}
+
+static void record_index_buffer_set_debug_label(IndexBuffer *ibuf, const char *label) {
+	record_object_set_debug_label(&ibuf->buf.obj, label);
+}
+
+static void record_index_buffer_set_offset(IndexBuffer *ibuf, size_t offset) {
+	ibuf->buf.offset = offset * ibuf->index_size;
+}
+
+static size_t record_index_buffer_get_offset(IndexBuffer *ibuf) {
+	return ibuf->buf.offset / ibuf->index_size;
+}
+
+static void record_index_buffer_add_indices(IndexBuffer *ibuf, size_t data_size, void *data) {
+	SDL_RWwrite(&ibuf->buf.stream, data, data_size, 1);
+}
+
+static void record_index_buffer_invalidate(IndexBuffer *ibuf) {
+	record_buffer_invalidate(&ibuf->buf);
+}
+
+static void record_index_buffer_destroy(IndexBuffer *ibuf) {
+	record_object_destroy(&ibuf->buf.obj);
+	mem_free(ibuf);
+}
+
+/*
+ * Vertex arrays
+ */
+
+static VertexArray *record_vertex_array_create(void) {
+	auto varr = ALLOC(VertexArray);
+	record_object_init(&varr->obj, RECORD_OBJ_VERTEX_ARRAY, "VAO");
+	return varr;
+}
+
+static const char *record_vertex_array_get_debug_label(VertexArray *varr) {
+	return varr->obj.debug_label;
+}
+
+static void record_vertex_array_set_debug_label(VertexArray *varr, const char *label) {
+	record_object_set_debug_label(&varr->obj, label);
+}
+
+static void record_vertex_array_destroy(VertexArray *varr) {
+	record_object_destroy(&varr->obj);
+	mem_free(varr->attachments);
+	mem_free(varr);
+}
+
+static void record_vertex_array_attach_vertex_buffer(VertexArray *varr, VertexBuffer *vbuf, uint attachment) {
+	assert(attachment < UINT8_MAX);
+
+	if(attachment >= varr->num_attachments) {
+		varr->attachments = mem_realloc(varr->attachments, (attachment + 1) * sizeof(VertexBuffer*));
+
+		for(uint i = varr->num_attachments; i < attachment; ++i) {
+			varr->attachments[i] = NULL;
+		}
+
+		varr->num_attachments = attachment + 1;
+	}
+
+	varr->attachments[attachment] = vbuf;
+
+	record_u8(RECORD_OP_VERTEX_ARRAY_ATTACH);
+	record_u32(varr->obj.id);
+	record_u8(attachment);
+	record_u32(vbuf ? vbuf->buf.obj.id : 0);
+}
+
+static void record_vertex_array_attach_index_buffer(VertexArray *varr, IndexBuffer *ibuf) {
+	varr->index_attachment = ibuf;
+
+	record_u8(RECORD_OP_VERTEX_ARRAY_ATTACH);
+	record_u32(varr->obj.id);
+	record_u8(UINT8_MAX);
+	record_u32(ibuf ? ibuf->buf.obj.id : 0);
+}
+
+static VertexBuffer *record_vertex_array_get_vertex_attachment(VertexArray *varr, uint attachment) {
+	if(varr->num_attachments <= attachment) {
+		return NULL;
+	}
+
+	return varr->attachments[attachment];
+}
+
+static IndexBuffer *record_vertex_array_get_index_attachment(VertexArray *varr) {
+	return varr->index_attachment;
+}
+
+static void record_vertex_array_layout(VertexArray *varr, uint nattribs, VertexAttribFormat attribs[nattribs]) {
+	record_u8(RECORD_OP_VERTEX_ARRAY_LAYOUT);
+	record_u32(varr->obj.id);
+	record_u8(nattribs);
+
+	for(uint i = 0; i < nattribs; ++i) {
+		VertexAttribFormat *a = attribs + i;
+		record_u8(a->spec.elements);
+		record_u8(a->spec.type);
+		record_u8(a->spec.coversion);
+		record_u32(a->spec.divisor);
+		record_u16(a->stride);
+		record_u16(a->offset);
+		record_u8(a->attachment);
+	}
+}
+
+/*
+ * Drawing
+ */
+
+static void record_draw_common(
+	RecordOp op, VertexArray *varr, Primitive prim, uint first, uint count, uint instances, uint base_instance
+) {
+	for(uint i = 0; i < varr->num_attachments; ++i) {
+		if(varr->attachments[i]) {
+			record_buffer_flush(&varr->attachments[i]->buf);
+		}
+	}
+
+	if(varr->index_attachment) {
+		record_buffer_flush(&varr->index_attachment->buf);
+	}
+
+	record_u8(op);
+	record_u32(varr->obj.id);
+	record_u8(prim);
+	record_u32(first);
+	record_u32(count);
+	record_u32(instances);
+	record_u32(base_instance);
+
+	++R.frame_stats.draw_calls;
+}
+
+static void record_draw(VertexArray *varr, Primitive prim, uint first, uint count, uint instances, uint base_instance) {
+	record_draw_common(RECORD_OP_DRAW, varr, prim, first, count, instances, base_instance);
+}
+
+static void record_draw_indexed(VertexArray *varr, Primitive prim, uint first, uint count, uint instances, uint base_instance) {
+	assert(varr->index_attachment != NULL);
+	record_draw_common(RECORD_OP_DRAW_INDEXED, varr, prim, first, count, instances, base_instance);
+}
+
+static void record_swap(SDL_Window *window) {
+	record_end_frame();
+}
+
+static void record_flush(void) {
+	// Nothing to submit; commands are only recorded.
+}
+
+/*
+ * Shaders
+ */
+
+static ShaderObject *record_shader_object_compile(ShaderSource *source) {
+	auto shobj = ALLOC(ShaderObject);
+	record_object_init(&shobj->obj, RECORD_OBJ_SHADER_OBJECT, "Shader object");
+	record_u8(source->stage);
+	return shobj;
+}
+
+static bool record_shader_object_ready(ShaderObject *shobj) {
+	return true;
+}
+
+static bool record_shader_object_finish(ShaderObject *shobj) {
+	return true;
+}
+
+static void record_shader_object_destroy(ShaderObject *shobj) {
+	record_object_destroy(&shobj->obj);
+	mem_free(shobj);
+}
+
+static void record_shader_object_set_debug_label(ShaderObject *shobj, const char *label) {
+	record_object_set_debug_label(&shobj->obj, label);
+}
+
+static const char *record_shader_object_get_debug_label(ShaderObject *shobj) {
+	return shobj->obj.debug_label;
+}
+
+static bool record_shader_object_transfer(ShaderObject *dst, ShaderObject *src) {
+	record_object_transfer(&dst->obj, &src->obj);
+	mem_free(src);
+	return true;
+}
+
+static ShaderProgram *record_shader_program_link(uint num_objects, ShaderObject *shobjs[num_objects]) {
+	auto prog = ALLOC(ShaderProgram);
+	record_object_init(&prog->obj, RECORD_OBJ_SHADER_PROGRAM, "Shader program");
+	record_u8(num_objects);
+
+	for(uint i = 0; i < num_objects; ++i) {
+		record_u32(shobjs[i]->obj.id);
+	}
+
+	return prog;
+}
+
+static bool record_shader_program_ready(ShaderProgram *prog) {
+	return true;
+}
+
+static bool record_shader_program_finish(ShaderProgram *prog) {
+	return true;
+}
+
+static void record_shader_program_destroy(ShaderProgram *prog) {
+	if(R.state.shader == prog) {
+		R.state.shader = NULL;
+	}
+
+	record_object_destroy(&prog->obj);
+	mem_free(prog);
+}
+
+static void record_shader_program_set_debug_label(ShaderProgram *prog, const char *label) {
+	record_object_set_debug_label(&prog->obj, label);
+}
+
+static const char *record_shader_program_get_debug_label(ShaderProgram *prog) {
+	return prog->obj.debug_label;
+}
+
+static bool record_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
+	if(R.state.shader == src) {
+		R.state.shader = dst;
+	}
+
+	record_object_transfer(&dst->obj, &src->obj);
+	mem_free(src);
+	return true;
+}
+
+/*
+ * Textures
+ */
+
+static Texture *record_texture_create(const TextureParams *params) {
+	auto tex = ALLOC(Texture, { .params = *params });
+	tex->params.mipmaps = umax(1, tex->params.mipmaps);
+	tex->params.layers = umax(1, tex->params.layers);
+
+	record_object_init(&tex->obj, RECORD_OBJ_TEXTURE, "Texture");
+	record_u8(params->type);
+	record_u32(params->width);
+	record_u32(params->height);
+	record_u32(tex->params.layers);
+	record_u32(tex->params.mipmaps);
+
+	return tex;
+}
+
+static void record_texture_get_size(Texture *tex, uint mipmap, uint *width, uint *height) {
+	if(width) *width = umax(1, tex->params.width >> mipmap);
+	if(height) *height = umax(1, tex->params.height >> mipmap);
+}
+
+static void record_texture_get_params(Texture *tex, TextureParams *params) {
+	*params = tex->params;
+}
+
+static const char *record_texture_get_debug_label(Texture *tex) {
+	return tex->obj.debug_label;
+}
+
+static void record_texture_set_debug_label(Texture *tex, const char *label) {
+	record_object_set_debug_label(&tex->obj, label);
+}
+
+static void record_texture_set_filter(Texture *tex, TextureFilterMode fmin, TextureFilterMode fmag) {
+	tex->params.filter.min = fmin;
+	tex->params.filter.mag = fmag;
+
+	record_u8(RECORD_OP_TEXTURE_FILTER);
+	record_u32(tex->obj.id);
+	record_u8(fmin);
+	record_u8(fmag);
+}
+
+static void record_texture_set_wrap(Texture *tex, TextureWrapMode ws, TextureWrapMode wt) {
+	tex->params.wrap.s = ws;
+	tex->params.wrap.t = wt;
+
+	record_u8(RECORD_OP_TEXTURE_WRAP);
+	record_u32(tex->obj.id);
+	record_u8(ws);
+	record_u8(wt);
+}
+
+static void record_texture_destroy(Texture *tex) {
+	record_object_destroy(&tex->obj);
+	mem_free(tex);
+}
+
+static void record_texture_invalidate(Texture *tex) {
+	record_u8(RECORD_OP_TEXTURE_INVALIDATE);
+	record_u32(tex->obj.id);
+}
+
+static void record_texture_fill_region(Texture *tex, uint mipmap, uint layer, uint x, uint y, const Pixmap *image) {
+	record_u8(RECORD_OP_TEXTURE_FILL);
+	record_u32(tex->obj.id);
+	record_u8(mipmap);
+	record_u16(layer);
+	record_u32(x);
+	record_u32(y);
+	record_u32(image->width);
+	record_u32(image->height);
+	record_u32(image->data_size);
+
+	R.frame_stats.texture_bytes += image->data_size;
+}
+
+static void record_texture_fill(Texture *tex, uint mipmap, uint layer, const Pixmap *image) {
+	record_texture_fill_region(tex, mipmap, layer, 0, 0, image);
+}
+
+static void record_texture_clear(Texture *tex, const Color *clr) {
+	record_u8(RECORD_OP_TEXTURE_CLEAR);
+	record_u32(tex->obj.id);
+	record_floats(4, (float[]) { clr->r, clr->g, clr->b, clr->a });
+}
+
+static bool record_texture_transfer(Texture *dst, Texture *src) {
+	dst->params = src->params;
+	record_object_transfer(&dst->obj, &src->obj);
+	mem_free(src);
+	return true;
+}
+
+/*
+ * Framebuffers
+ */
+
+static Framebuffer *record_framebuffer_create(void) {
+	auto fb = ALLOC(Framebuffer);
+	record_object_init(&fb->obj, RECORD_OBJ_FRAMEBUFFER, "FBO");
+
+	for(int i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
+		fb->output_mapping[i] = FRAMEBUFFER_ATTACH_COLOR0 + i;
+	}
+
+	return fb;
+}
+
+static const char *record_framebuffer_get_debug_label(Framebuffer *fb) {
+	return fb->obj.debug_label;
+}
+
+static void record_framebuffer_set_debug_label(Framebuffer *fb, const char *label) {
+	record_object_set_debug_label(&fb->obj, label);
+}
+
+static void record_framebuffer_destroy(Framebuffer *fb) {
+	if(R.state.framebuffer == fb) {
+		R.state.framebuffer = NULL;
+	}
+
+	record_object_destroy(&fb->obj);
+	mem_free(fb);
+}
+
+static void record_framebuffer_attach(Framebuffer *fb, Texture *tex, uint mipmap, FramebufferAttachment attachment) {
+	assert(attachment >= 0 && attachment < FRAMEBUFFER_MAX_ATTACHMENTS);
+	fb->attachments[attachment] = tex;
+	fb->attachment_mipmaps[attachment] = mipmap;
+
+	record_u8(RECORD_OP_FRAMEBUFFER_ATTACH);
+	record_u32(fb->obj.id);
+	record_u32(OBJ_ID(tex));
+	record_u8(mipmap);
+	record_u8(attachment);
+}
+
+static FramebufferAttachmentQueryResult record_framebuffer_query_attachment(Framebuffer *fb, FramebufferAttachment attachment) {
+	assert(attachment >= 0 && attachment < FRAMEBUFFER_MAX_ATTACHMENTS);
+
+	return (FramebufferAttachmentQueryResult) {
+		.texture = fb->attachments[attachment],
+		.miplevel = fb->attachment_mipmaps[attachment],
+	};
+}
+
+static void record_framebuffer_outputs(Framebuffer *fb, FramebufferAttachment config[FRAMEBUFFER_MAX_OUTPUTS], uint8_t write_mask) {
+	if(write_mask == 0x00) {
+		memcpy(config, fb->output_mapping, sizeof(fb->output_mapping));
+		return;
+	}
+
+	for(int i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
+		if(write_mask & (1 << i)) {
+			fb->output_mapping[i] = config[i];
+		}
+	}
+
+	record_u8(RECORD_OP_FRAMEBUFFER_OUTPUTS);
+	record_u32(fb->obj.id);
+
+	for(int i = 0; i < FRAMEBUFFER_MAX_OUTPUTS; ++i) {
+		record_u8(fb->output_mapping[i] == FRAMEBUFFER_ATTACH_NONE ? UINT8_MAX : fb->output_mapping[i]);
+	}
+}
+
+static IntExtent record_framebuffer_get_size(Framebuffer *fb) {
+	if(fb == NULL) {
+		IntExtent size = { 800, 600 };
+
+		if(R.window) {
+			SDL_GetWindowSize(R.window, &size.w, &size.h);
+		}
+
+		return size;
+	}
+
+	// Like the GL backends, the effective size is that of the smallest attachment.
+	IntExtent size = { INT_MAX, INT_MAX };
+	bool have_attachments = false;
+
+	for(int i = 0; i < FRAMEBUFFER_MAX_ATTACHMENTS; ++i) {
+		Texture *tex = fb->attachments[i];
+
+		if(tex) {
+			uint w, h;
+			record_texture_get_size(tex, fb->attachment_mipmaps[i], &w, &h);
+			size.w = imin(size.w, w);
+			size.h = imin(size.h, h);
+			have_attachments = true;
+		}
+	}
+
+	if(!have_attachments) {
+		size = (IntExtent) { 0, 0 };
+	}
+
+	return size;
+}
+
+static FloatRect *record_get_viewport(Framebuffer *fb) {
+	return fb ? &fb->viewport : &R.state.default_viewport;
+}
+
+static void record_framebuffer_viewport(Framebuffer *fb, FloatRect vp) {
+	FloatRect *cur = record_get_viewport(fb);
+	record_state_change(RECORD_OP_VIEWPORT, memcmp(cur, &vp, sizeof(vp)));
+	record_u32(OBJ_ID(fb));
+	record_floats(4, vp.as_array);
+	*cur = vp;
+}
+
+static void record_framebuffer_viewport_current(Framebuffer *fb, FloatRect *vp) {
+	*vp = *record_get_viewport(fb);
+
+	if(!vp->w || !vp->h) {
+		IntExtent size = record_framebuffer_get_size(fb);
+		*vp = (FloatRect) { 0, 0, size.w, size.h };
+	}
+}
+
+static void record_framebuffer(Framebuffer *fb) {
+	record_state_change(RECORD_OP_FRAMEBUFFER, R.state.framebuffer != fb);
+	record_u32(OBJ_ID(fb));
+	R.state.framebuffer = fb;
+}
+
+static Framebuffer *record_framebuffer_current(void) {
+	return R.state.framebuffer;
+}
+
+static void record_framebuffer_clear(Framebuffer *fb, BufferKindFlags flags, const Color *colorval, float depthval) {
+	Color c = colorval ? *colorval : (Color) { 0 };
+
+	record_u8(RECORD_OP_FRAMEBUFFER_CLEAR);
+	record_u32(OBJ_ID(fb));
+	record_u8(flags);
+	record_floats(4, (float[]) { c.r, c.g, c.b, c.a });
+	record_f32(depthval);
+}
+
+static void record_framebuffer_copy(Framebuffer *dst, Framebuffer *src, BufferKindFlags flags) {
+	record_u8(RECORD_OP_FRAMEBUFFER_COPY);
+	record_u32(OBJ_ID(dst));
+	record_u32(OBJ_ID(src));
+	record_u8(flags);
+}
+
+// Anything not set here (uniforms, queries, screenshots) is inherited from the null backend.
+RendererBackend _r_backend_record = {
+	.name = "record",
+	.funcs = {
+		.init = record_init,
+		.shutdown = record_shutdown,
+		.create_window = record_create_window,
+		.capabilities = record_capabilities,
+		.capabilities_current = record_capabilities_current,
+		.draw = record_draw,
+		.draw_indexed = record_draw_indexed,
+		.color4 = record_color4,
+		.color_current = record_color_current,
+		.blend = record_blend,
+		.blend_current = record_blend_current,
+		.cull = record_cull,
+		.cull_current = record_cull_current,
+		.depth_func = record_depth_func,
+		.depth_func_current = record_depth_func_current,
+		.shader_object_compile = record_shader_object_compile,
+		.shader_object_ready = record_shader_object_ready,
+		.shader_object_finish = record_shader_object_finish,
+		.shader_object_destroy = record_shader_object_destroy,
+		.shader_object_set_debug_label = record_shader_object_set_debug_label,
+		.shader_object_get_debug_label = record_shader_object_get_debug_label,
+		.shader_object_transfer = record_shader_object_transfer,
+		.shader_program_link = record_shader_program_link,
+		.shader_program_ready = record_shader_program_ready,
+		.shader_program_finish = record_shader_program_finish,
+		.shader_program_destroy = record_shader_program_destroy,
+		.shader_program_set_debug_label = record_shader_program_set_debug_label,
+		.shader_program_get_debug_label = record_shader_program_get_debug_label,
+		.shader_program_transfer = record_shader_program_transfer,
+		.shader = record_shader,
+		.shader_current = record_shader_current,
+		.texture_create = record_texture_create,
+		.texture_get_params = record_texture_get_params,
+		.texture_get_size = record_texture_get_size,
+		.texture_get_debug_label = record_texture_get_debug_label,
+		.texture_set_debug_label = record_texture_set_debug_label,
+		.texture_set_filter = record_texture_set_filter,
+		.texture_set_wrap = record_texture_set_wrap,
+		.texture_destroy = record_texture_destroy,
+		.texture_invalidate = record_texture_invalidate,
+		.texture_fill = record_texture_fill,
+		.texture_fill_region = record_texture_fill_region,
+		.texture_clear = record_texture_clear,
+		.texture_transfer = record_texture_transfer,
+		.framebuffer_create = record_framebuffer_create,
+		.framebuffer_get_debug_label = record_framebuffer_get_debug_label,
+		.framebuffer_set_debug_label = record_framebuffer_set_debug_label,
+		.framebuffer_destroy = record_framebuffer_destroy,
+		.framebuffer_attach = record_framebuffer_attach,
+		.framebuffer_query_attachment = record_framebuffer_query_attachment,
+		.framebuffer_outputs = record_framebuffer_outputs,
+		.framebuffer_viewport = record_framebuffer_viewport,
+		.framebuffer_viewport_current = record_framebuffer_viewport_current,
+		.framebuffer = record_framebuffer,
+		.framebuffer_current = record_framebuffer_current,
+		.framebuffer_clear = record_framebuffer_clear,
+		.framebuffer_copy = record_framebuffer_copy,
+		.framebuffer_get_size = record_framebuffer_get_size,
+		.vertex_buffer_create = record_vertex_buffer_create,
+		.vertex_buffer_get_debug_label = record_vertex_buffer_get_debug_label,
+		.vertex_buffer_set_debug_label = record_vertex_buffer_set_debug_label,
+		.vertex_buffer_destroy = record_vertex_buffer_destroy,
+		.vertex_buffer_invalidate = record_vertex_buffer_invalidate,
+		.vertex_buffer_get_stream = record_vertex_buffer_get_stream,
+		.index_buffer_create = record_index_buffer_create,
+		.index_buffer_get_capacity = record_index_buffer_get_capacity,
+		.index_buffer_get_index_size = record_index_buffer_get_index_size,
+		.index_buffer_get_debug_label = record_index_buffer_get_debug_label,
+		.index_buffer_set_debug_label = record_index_buffer_set_debug_label,
+		.index_buffer_set_offset = record_index_buffer_set_offset,
+		.index_buffer_get_offset = record_index_buffer_get_offset,
+		.index_buffer_add_indices = record_index_buffer_add_indices,
+		.index_buffer_invalidate = record_index_buffer_invalidate,
+		.index_buffer_destroy = record_index_buffer_destroy,
+		.vertex_array_create = record_vertex_array_create,
+		.vertex_array_get_debug_label = record_vertex_array_get_debug_label,
+		.vertex_array_set_debug_label = record_vertex_array_set_debug_label,
+		.vertex_array_destroy = record_vertex_array_destroy,
+		.vertex_array_layout = record_vertex_array_layout,
+		.vertex_array_attach_vertex_buffer = record_vertex_array_attach_vertex_buffer,
+		.vertex_array_get_vertex_attachment = record_vertex_array_get_vertex_attachment,
+		.vertex_array_attach_index_buffer = record_vertex_array_attach_index_buffer,
+		.vertex_array_get_index_attachment = record_vertex_array_get_index_attachment,
+		.scissor = record_scissor,
+		.scissor_current = record_scissor_current,
+		.vsync = record_vsync,
+		.vsync_current = record_vsync_current,
+		.swap = record_swap,
+		.flush = record_flush,
+	},
+};
@@ -0,0 +1,106 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "../common/backend.h"
+
+/*
+ * The "record" backend behaves like the null backend (nothing is displayed, no
+ * GPU is needed), but keeps track of all objects and pipeline state, and can
+ * write the complete backend call stream into a binary log.
+ *
+ * Environment variables:
+ *
+ *   TAISEI_RECORD_LOG=<path>     write the command log to this file
+ *   TAISEI_RECORD_STATS=<path>   write per-frame statistics to this file (CSV)
+ *
+ * A summary of the statistics is always logged at shutdown.
+ *
+ * Log layout (all integers little-endian, floats as IEEE 754 binary32):
+ *
+ *   uint32_t magic;    // RECORD_LOG_MAGIC
+ *   uint16_t version;  // RECORD_LOG_VERSION
+ *   commands[] {
+ *       uint8_t op;    // RecordOp
+ *       payload;       // see RecordOp
+ *   }
+ *
+ * Objects are referred to by 32-bit IDs, which are assigned on creation and never
+ * reused. ID 0 refers to "no object" or the default framebuffer.
+ */
+
+#define RECORD_LOG_MAGIC 0x43455254  // 'TREC'
+#define RECORD_LOG_VERSION 1
+
+typedef enum RecordOp {
+	// u32 frame, u32 draw_calls, u32 state_changes, u32 redundant_state_changes,
+	// u64 buffer_bytes, u64 texture_bytes
+	RECORD_OP_FRAME,
+
+	// u32 varr, u8 prim, u32 first, u32 count, u32 instances, u32 base_instance
+	RECORD_OP_DRAW,
+	RECORD_OP_DRAW_INDEXED,
+
+	// state changes; logged even if redundant
+	RECORD_OP_CAPABILITIES,     // u32 capbits
+	RECORD_OP_COLOR,            // f32 r, g, b, a
+	RECORD_OP_BLEND,            // u32 mode
+	RECORD_OP_CULL,             // u8 mode
+	RECORD_OP_DEPTH_FUNC,       // u8 func
+	RECORD_OP_SHADER,           // u32 prog
+	RECORD_OP_FRAMEBUFFER,      // u32 fb
+	RECORD_OP_VIEWPORT,         // u32 fb, f32 x, y, w, h
+	RECORD_OP_SCISSOR,          // i32 x, y, w, h
+	RECORD_OP_VSYNC,            // u8 mode
+
+	// u8 RecordObjectType, u32 id, then per type:
+	//   texture:          u8 type, u32 width, u32 height, u32 layers, u32 mipmaps
+	//   vertex buffer:    u32 capacity
+	//   index buffer:     u8 index_size, u32 capacity
+	//   shader object:    u8 stage
+	//   shader program:   u8 num_objects, u32 objects[num_objects]
+	//   others:           nothing
+	RECORD_OP_CREATE,
+	RECORD_OP_DESTROY,          // u32 id
+	RECORD_OP_TRANSFER,         // u32 dst, u32 src (hot reload; src is destroyed)
+
+	RECORD_OP_BUFFER_UPLOAD,    // u32 buffer, u32 offset, u32 size
+	RECORD_OP_BUFFER_INVALIDATE,// u32 buffer
+
+	RECORD_OP_TEXTURE_FILL,     // u32 tex, u8 mipmap, u16 layer, u32 x, y, w, h, u32 size
+	RECORD_OP_TEXTURE_FILTER,   // u32 tex, u8 min, u8 mag
+	RECORD_OP_TEXTURE_WRAP,     // u32 tex, u8 s, u8 t
+	RECORD_OP_TEXTURE_CLEAR,    // u32 tex, f32 r, g, b, a
+	RECORD_OP_TEXTURE_INVALIDATE, // u32 tex
+
+	RECORD_OP_FRAMEBUFFER_ATTACH,  // u32 fb, u32 tex, u8 mipmap, u8 attachment
+	RECORD_OP_FRAMEBUFFER_OUTPUTS, // u32 fb, u8 outputs[FRAMEBUFFER_MAX_OUTPUTS] (0xff = none)
+	RECORD_OP_FRAMEBUFFER_CLEAR,   // u32 fb, u8 flags, f32 r, g, b, a, f32 depth
+	RECORD_OP_FRAMEBUFFER_COPY,    // u32 dst, u32 src, u8 flags
+
+	// u32 varr, u8 attachment, u32 vbuf (attachment 0xff = index buffer)
+	RECORD_OP_VERTEX_ARRAY_ATTACH,
+	// u32 varr, u8 num_attribs, attribs[num_attribs] {
+	//     u8 elements, u8 type, u8 conversion, u32 divisor, u16 stride, u16 offset, u8 attachment
+	// }
+	RECORD_OP_VERTEX_ARRAY_LAYOUT,
+} RecordOp;
+
+typedef enum RecordObjectType {
+	RECORD_OBJ_TEXTURE,
+	RECORD_OBJ_FRAMEBUFFER,
+	RECORD_OBJ_VERTEX_BUFFER,
+	RECORD_OBJ_INDEX_BUFFER,
+	RECORD_OBJ_VERTEX_ARRAY,
+	RECORD_OBJ_SHADER_OBJECT,
+	RECORD_OBJ_SHADER_PROGRAM,
+} RecordObjectType;
+
+extern RendererBackend _r_backend_record;
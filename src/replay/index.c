@@ -0,0 +1,322 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#include "taisei.h"
+
+#include "index.h"
+#include "struct.h"
+
+#include "util.h"
+#include "vfs/public.h"
+
+#define REPLAY_INDEX_PATH "cache/replays.idx"
+#define REPLAY_INDEX_MAGIC 0x58444952  // 'RIDX'
+#define REPLAY_INDEX_VERSION 1
+
+/*
+ * File layout (all integers little-endian):
+ *
+ *   uint32_t magic;
+ *   uint16_t version;
+ *   uint32_t num_entries;
+ *   entries[num_entries] {
+ *       uint16_t filename_size; char filename[filename_size];
+ *       uint64_t filesize;
+ *       uint16_t replay_version;
+ *       uint8_t playername_size; char playername[playername_size];
+ *       uint16_t num_stages;
+ *       stages[num_stages] {
+ *           uint16_t stage;
+ *           uint64_t start_time;
+ *           uint8_t diff;
+ *           uint8_t plr_char;
+ *           uint8_t plr_shot;
+ *           uint64_t plr_points_final;
+ *       }
+ *   }
+ *   uint32_t num_entries;  // repeated to detect truncation
+ */
+
+typedef struct ReplayIndexEntry {
+	Replay meta;
+	int64_t filesize;
+	bool seen;
+} ReplayIndexEntry;
+
+static void replay_index_entry_free(ReplayIndexEntry *e) {
+	replay_reset(&e->meta);
+	mem_free(e);
+}
+
+static void replay_copy_meta(Replay *dst, const Replay *src) {
+	dst->version = src->version;
+	dst->playername = strdup(src->playername ? src->playername : "");
+	dynarray_ensure_capacity(&dst->stages, src->stages.num_elements);
+
+	dynarray_foreach_elem(&src->stages, ReplayStage *s, {
+		*dynarray_append(&dst->stages) = (ReplayStage) {
+			.stage = s->stage,
+			.start_time = s->start_time,
+			.diff = s->diff,
+			.plr_char = s->plr_char,
+			.plr_shot = s->plr_shot,
+			.plr_points_final = s->plr_points_final,
+		};
+	});
+}
+
+static void replay_index_set(ReplayIndex *idx, const char *filename, ReplayIndexEntry *e) {
+	ReplayIndexEntry *old = ht_get(&idx->entries, filename, NULL);
+
+	if(old) {
+		replay_index_entry_free(old);
+	}
+
+	ht_set(&idx->entries, filename, e);
+}
+
+static bool replay_index_read_string(SDL_RWops *file, size_t len, char **out) {
+	char *s = mem_alloc(len + 1);
+
+	if(SDL_RWread(file, s, 1, len) != len) {
+		mem_free(s);
+		return false;
+	}
+
+	*out = s;
+	return true;
+}
+
+static bool replay_index_read_entries(ReplayIndex *idx, SDL_RWops *file) {
+	if(SDL_ReadLE32(file) != REPLAY_INDEX_MAGIC) {
+		log_warn("Bad magic header, ignoring the index");
+		return false;
+	}
+
+	uint16_t version = SDL_ReadLE16(file);
+
+	if(version != REPLAY_INDEX_VERSION) {
+		log_info("Index version %u is not supported, rebuilding", version);
+		return false;
+	}
+
+	uint32_t num_entries = SDL_ReadLE32(file);
+
+	for(uint32_t i = 0; i < num_entries; ++i) {
+		char *filename;
+
+		if(!replay_index_read_string(file, SDL_ReadLE16(file), &filename)) {
+			return false;
+		}
+
+		auto e = ALLOC(ReplayIndexEntry);
+		e->filesize = (int64_t)SDL_ReadLE64(file);
+		e->meta.version = SDL_ReadLE16(file);
+
+		if(!replay_index_read_string(file, SDL_ReadU8(file), &e->meta.playername)) {
+			replay_index_entry_free(e);
+			mem_free(filename);
+			return false;
+		}
+
+		uint16_t num_stages = SDL_ReadLE16(file);
+
+		if(!num_stages) {
+			replay_index_entry_free(e);
+			mem_free(filename);
+			return false;
+		}
+
+		dynarray_ensure_capacity(&e->meta.stages, num_stages);
+
+		for(uint16_t j = 0; j < num_stages; ++j) {
+			ReplayStage *s = dynarray_append(&e->meta.stages);
+			*s = (ReplayStage) { 0 };
+			s->stage = SDL_ReadLE16(file);
+			s->start_time = SDL_ReadLE64(file);
+			s->diff = SDL_ReadU8(file);
+			s->plr_char = SDL_ReadU8(file);
+			s->plr_shot = SDL_ReadU8(file);
+			s->plr_points_final = SDL_ReadLE64(file);
+		}
+
+		replay_index_set(idx, filename, e);
+		mem_free(filename);
+	}
+
+	if(SDL_ReadLE32(file) != num_entries) {
+		log_warn("Index appears to be truncated, ignoring it");
+		return false;
+	}
+
+	return true;
+}
+
+static void *replay_index_free_callback(const char *key, void *data, void *arg) {
+	replay_index_entry_free(data);
+	return NULL;
+}
+
+static void replay_index_clear(ReplayIndex *idx) {
+	ht_foreach(&idx->entries, replay_index_free_callback, NULL);
+	ht_unset_all(&idx->entries);
+}
+
+void replay_index_load(ReplayIndex *idx) {
+	*idx = (ReplayIndex) { 0 };
+	ht_create(&idx->entries);
+
+	SDL_RWops *file = vfs_open(REPLAY_INDEX_PATH, VFS_MODE_READ);
+
+	if(!file) {
+		log_debug("No replay index: %s", vfs_get_error());
+		idx->dirty = true;
+		return;
+	}
+
+	if(!replay_index_read_entries(idx, file)) {
+		replay_index_clear(idx);
+		idx->dirty = true;
+	}
+
+	SDL_RWclose(file);
+}
+
+void replay_index_save(ReplayIndex *idx) {
+	if(!idx->dirty) {
+		return;
+	}
+
+	SDL_RWops *file = vfs_open(REPLAY_INDEX_PATH, VFS_MODE_WRITE);
+
+	if(!file) {
+		log_warn("Failed to write the replay index: %s", vfs_get_error());
+		return;
+	}
+
+	uint32_t num_entries = idx->entries.num_elements_occupied;
+	ht_str2ptr_iter_t iter;
+
+	SDL_WriteLE32(file, REPLAY_INDEX_MAGIC);
+	SDL_WriteLE16(file, REPLAY_INDEX_VERSION);
+	SDL_WriteLE32(file, num_entries);
+
+	ht_iter_begin(&idx->entries, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		ReplayIndexEntry *e = iter.value;
+		const char *playername = e->meta.playername;
+		size_t filename_size = strlen(iter.key);
+		size_t playername_size = umin(strlen(playername), UINT8_MAX);
+
+		SDL_WriteLE16(file, filename_size);
+		SDL_RWwrite(file, iter.key, 1, filename_size);
+		SDL_WriteLE64(file, (uint64_t)e->filesize);
+		SDL_WriteLE16(file, e->meta.version);
+		SDL_WriteU8(file, playername_size);
+		SDL_RWwrite(file, playername, 1, playername_size);
+		SDL_WriteLE16(file, e->meta.stages.num_elements);
+
+		dynarray_foreach_elem(&e->meta.stages, ReplayStage *s, {
+			SDL_WriteLE16(file, s->stage);
+			SDL_WriteLE64(file, s->start_time);
+			SDL_WriteU8(file, s->diff);
+			SDL_WriteU8(file, s->plr_char);
+			SDL_WriteU8(file, s->plr_shot);
+			SDL_WriteLE64(file, s->plr_points_final);
+		});
+	}
+
+	ht_iter_end(&iter);
+
+	SDL_WriteLE32(file, num_entries);
+	SDL_RWclose(file);
+
+	idx->dirty = false;
+	log_debug("Wrote %u entries", num_entries);
+}
+
+void replay_index_unload(ReplayIndex *idx) {
+	replay_index_clear(idx);
+	ht_destroy(&idx->entries);
+}
+
+bool replay_index_lookup(ReplayIndex *idx, const char *filename, int64_t filesize, Replay *rpy) {
+	ReplayIndexEntry *e = ht_get(&idx->entries, filename, NULL);
+
+	if(!e || e->filesize != filesize || e->filesize < 0) {
+		return false;
+	}
+
+	e->seen = true;
+	replay_copy_meta(rpy, &e->meta);
+	return true;
+}
+
+void replay_index_update(ReplayIndex *idx, const char *filename, int64_t filesize, const Replay *rpy) {
+	if(!rpy->stages.num_elements) {
+		return;
+	}
+
+	auto e = ALLOC(ReplayIndexEntry, {
+		.filesize = filesize,
+		.seen = true,
+	});
+
+	replay_copy_meta(&e->meta, rpy);
+	replay_index_set(idx, filename, e);
+	idx->dirty = true;
+}
+
+void replay_index_prune(ReplayIndex *idx) {
+	DYNAMIC_ARRAY(char*) unseen = { };
+	ht_str2ptr_iter_t iter;
+
+	ht_iter_begin(&idx->entries, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		ReplayIndexEntry *e = iter.value;
+
+		if(!e->seen) {
+			*dynarray_append(&unseen) = strdup(iter.key);
+		}
+	}
+
+	ht_iter_end(&iter);
+
+	dynarray_foreach_elem(&unseen, char **key, {
+		replay_index_entry_free(ht_get(&idx->entries, *key, NULL));
+		ht_unset(&idx->entries, *key);
+		mem_free(*key);
+		idx->dirty = true;
+	});
+
+	dynarray_free_data(&unseen);
+}
+
+int64_t replay_index_query_filesize(const char *filename) {
+	char *path = strfmt("storage/replays/%s", filename);
+	SDL_RWops *file = vfs_open(path, VFS_MODE_READ);
+	mem_free(path);
+
+	if(!file) {
+		return -1;
+	}
+
+	int64_t size = SDL_RWsize(file);
+	SDL_RWclose(file);
+	return size;
+}
+
+void replay_index_add(const char *filename, int64_t filesize, const Replay *rpy) {
+	ReplayIndex idx;
+	replay_index_load(&idx);
+	replay_index_update(&idx, filename, filesize, rpy);
+	replay_index_save(&idx);
+	replay_index_unload(&idx);
+}
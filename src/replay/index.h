@@ -0,0 +1,62 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#pragma once
+#include "taisei.h"
+
+#include "replay.h"
+#include "hashtable.h"
+
+/*
+ * A persistent cache of replay metadata, used by the replay menu to avoid
+ * parsing (and decompressing) every replay file each time it's opened.
+ *
+ * Entries are keyed by file name and validated by file size. Only the fields
+ * the menu needs are cached: player name, struct version, and for every stage
+ * its ID, start time, difficulty, player mode and final score. Replays loaded
+ * from the index are therefore incomplete and must be fully reloaded before
+ * playback.
+ */
+
+typedef struct ReplayIndex {
+	ht_str2ptr_t entries;
+	bool dirty;
+} ReplayIndex;
+
+// Loads the index from disk. Starts with an empty index if it's missing or invalid.
+void replay_index_load(ReplayIndex *idx)
+	attr_nonnull_all;
+
+// Writes the index back to disk, if it was modified.
+void replay_index_save(ReplayIndex *idx)
+	attr_nonnull_all;
+
+void replay_index_unload(ReplayIndex *idx)
+	attr_nonnull_all;
+
+// Fills `rpy` with the cached metadata of `filename`, if it's up to date.
+// The entry is marked as seen (see replay_index_prune).
+bool replay_index_lookup(ReplayIndex *idx, const char *filename, int64_t filesize, Replay *rpy)
+	attr_nonnull_all;
+
+// Adds or replaces the cache entry of `filename`. The entry is marked as seen.
+void replay_index_update(ReplayIndex *idx, const char *filename, int64_t filesize, const Replay *rpy)
+	attr_nonnull_all;
+
+// Drops all entries that haven't been looked up or updated since loading.
+void replay_index_prune(ReplayIndex *idx)
+	attr_nonnull_all;
+
+// Returns the size of a file in storage/replays, or -1 if it can't be determined.
+int64_t replay_index_query_filesize(const char *filename)
+	attr_nonnull_all;
+
+// Loads the on-disk index, updates a single entry and saves it again.
+// Intended to be called right after a replay has been written.
+void replay_index_add(const char *filename, int64_t filesize, const Replay *rpy)
+	attr_nonnull_all;
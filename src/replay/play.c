@@ -9,6 +9,7 @@
 #include "taisei.h"
 
 #include "replay.h"
+#include "stage.h"
 #include "struct.h"
 #include "state.h"
 
@@ -48,26 +49,13 @@ void replay_play(Replay *rpy, int firstidx, bool demo_mode, CallChain next) {
 
 static void replay_do_play(CallChainResult ccr) {
 	ReplayContext *ctx = ccr.ctx;
-	ReplayStage *rstg = NULL;
-	StageInfo *stginfo = NULL;
+	StageInfo *stginfo;
 	Replay *rpy = ctx->rpy;
+	ReplayStage *rstg = replay_stage_next_playable(rpy, &ctx->stage_idx, &stginfo);
 
-	while(ctx->stage_idx < rpy->stages.num_elements) {
-		rstg = dynarray_get_ptr(&rpy->stages, ctx->stage_idx++);
-		stginfo = stageinfo_get_by_id(rstg->stage);
-
-		if(!stginfo) {
-			log_warn("Invalid stage %X in replay at %i skipped.", rstg->stage, ctx->stage_idx);
-			continue;
-		}
-
-		break;
-	};
-
-	if(stginfo == NULL) {
+	if(rstg == NULL) {
 		replay_do_cleanup(ccr);
 	} else {
-		assume(rstg != NULL);
 		replay_state_init_play(&global.replay.input, rpy, rstg);
 		global.replay.input.play.demo_mode = ctx->demo_mode;
 		global.plr.mode = plrmode_find(rstg->plr_char, rstg->plr_shot);
@@ -96,6 +96,7 @@ static bool replay_read_header(
 		case REPLAY_STRUCT_VERSION_TS103000_REV3:
 		case REPLAY_STRUCT_VERSION_TS104000_REV0:
 		case REPLAY_STRUCT_VERSION_TS104000_REV1:
+		case REPLAY_STRUCT_VERSION_TS104000_REV2:
 		{
 			if(taisei_version_read(file, &rpy->game_version) != TAISEI_VERSION_SIZE) {
 				log_error("%s: Failed to read game version", source);
@@ -283,12 +284,27 @@ static bool _replay_read_events(ReplayReadContext *ctx) {
 
 		dynarray_ensure_capacity(&stg->events, stg->num_events);
 
-		for(int j = 0; j < stg->num_events; ++j) {
-			ReplayEvent *evt = dynarray_append(&stg->events);
+		if(ctx->version >= REPLAY_STRUCT_VERSION_TS104000_REV2) {
+			ReplayEventCodec codec = { };
 
-			CHECKPROP(evt->frame = SDL_ReadLE32(ctx->stream), u);
-			CHECKPROP(evt->type = SDL_ReadU8(ctx->stream), u);
-			CHECKPROP(evt->value = SDL_ReadLE16(ctx->stream), u);
+			for(int j = 0; j < stg->num_events; ++j) {
+				ReplayEvent *evt = dynarray_append(&stg->events);
+
+				if(!replay_read_event_packed(ctx->stream, &codec, evt)) {
+					--stg->events.num_elements;
+					log_error("%s: Premature EOF or malformed event", ctx->filename);
+					RETURN_ERROR;
+					break;
+				}
+			}
+		} else {
+			for(int j = 0; j < stg->num_events; ++j) {
+				ReplayEvent *evt = dynarray_append(&stg->events);
+
+				CHECKPROP(evt->frame = SDL_ReadLE32(ctx->stream), u);
+				CHECKPROP(evt->type = SDL_ReadU8(ctx->stream), u);
+				CHECKPROP(evt->value = SDL_ReadLE16(ctx->stream), u);
+			}
 		}
 	});
 
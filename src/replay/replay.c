@@ -9,6 +9,7 @@
 #include "taisei.h"
 
 #include "replay.h"
+#include "index.h"
 #include "struct.h"
 #include "stage.h"
 #include "state.h"
@@ -39,15 +40,22 @@ bool replay_save(Replay *rpy, const char *name) {
 	mem_free(sp);
 
 	SDL_RWops *file = vfs_open(p, VFS_MODE_WRITE);
-	mem_free(p);
 
 	if(!file) {
 		log_error("VFS error: %s", vfs_get_error());
+		mem_free(p);
 		return false;
 	}
 
 	bool result = replay_write(rpy, file, REPLAY_STRUCT_VERSION_WRITE);
+	int64_t filesize = SDL_RWsize(file);
 	SDL_RWclose(file);
+
+	if(result) {
+		replay_index_add(p + sizeof("storage/replays/") - 1, filesize, rpy);
+	}
+
+	mem_free(p);
 	vfs_sync(VFS_SYNC_STORE, NO_CALLCHAIN);
 	return result;
 }
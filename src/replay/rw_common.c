@@ -85,3 +85,76 @@ SDL_RWops *replay_wrap_stream_decompress(uint16_t version, SDL_RWops *rw, bool a
 		return SDL_RWWrapZlibReader(rw, REPLAY_COMPRESSION_CHUNK_SIZE, autoclose);
 	}
 }
+
+static void replay_write_varint(SDL_RWops *file, uint32_t val) {
+	uint8_t buf[REPLAY_VARINT_MAX_SIZE];
+	uint i = 0;
+
+	while(val >= 0x80) {
+		buf[i++] = (val & 0x7f) | 0x80;
+		val >>= 7;
+	}
+
+	buf[i++] = val;
+	SDL_RWwrite(file, buf, 1, i);
+}
+
+static bool replay_read_varint(SDL_RWops *file, uint32_t *val) {
+	uint32_t result = 0;
+
+	for(uint i = 0; i < REPLAY_VARINT_MAX_SIZE; ++i) {
+		uint8_t byte;
+
+		if(SDL_RWread(file, &byte, 1, 1) != 1) {
+			return false;
+		}
+
+		result |= (uint32_t)(byte & 0x7f) << (7 * i);
+
+		if(!(byte & 0x80)) {
+			*val = result;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+INLINE uint16_t zigzag_encode16(int16_t x) {
+	return ((uint16_t)x << 1) ^ (uint16_t)(x >> 15);
+}
+
+INLINE int16_t zigzag_decode16(uint16_t x) {
+	return (int16_t)((x >> 1) ^ -(x & 1));
+}
+
+void replay_write_event_packed(SDL_RWops *file, ReplayEventCodec *codec, const ReplayEvent *evt) {
+	replay_write_varint(file, evt->frame - codec->frame);
+	SDL_WriteU8(file, evt->type);
+	replay_write_varint(file, zigzag_encode16(evt->value - codec->values[evt->type]));
+
+	codec->frame = evt->frame;
+	codec->values[evt->type] = evt->value;
+}
+
+bool replay_read_event_packed(SDL_RWops *file, ReplayEventCodec *codec, ReplayEvent *evt) {
+	uint32_t frame_delta, value_delta;
+	uint8_t type;
+
+	if(
+		!replay_read_varint(file, &frame_delta) ||
+		SDL_RWread(file, &type, 1, 1) != 1 ||
+		!replay_read_varint(file, &value_delta) ||
+		value_delta > UINT16_MAX
+	) {
+		return false;
+	}
+
+	evt->frame = codec->frame + frame_delta;
+	evt->type = type;
+	evt->value = codec->values[type] + zigzag_decode16(value_delta);
+
+	codec->frame = evt->frame;
+	codec->values[type] = evt->value;
+	return true;
+}
@@ -17,3 +17,8 @@ SDL_RWops *replay_wrap_stream_compress(uint16_t version, SDL_RWops *rw, bool aut
 SDL_RWops *replay_wrap_stream_decompress(uint16_t version, SDL_RWops *rw, bool autoclose);
 
 extern uint8_t replay_magic_header[REPLAY_MAGIC_HEADER_SIZE];
+
+void replay_write_event_packed(SDL_RWops *file, ReplayEventCodec *codec, const ReplayEvent *evt)
+	attr_nonnull_all;
+bool replay_read_event_packed(SDL_RWops *file, ReplayEventCodec *codec, ReplayEvent *evt)
+	attr_nonnull_all attr_nodiscard;
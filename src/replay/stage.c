@@ -87,6 +87,23 @@ void replay_stage_event(ReplayStage *stg, uint32_t frame, uint8_t type, uint16_t
 	}
 }
 
+ReplayStage *replay_stage_next_playable(Replay *rpy, int *idx, StageInfo **out_stginfo) {
+	while(*idx < rpy->stages.num_elements) {
+		ReplayStage *rstg = dynarray_get_ptr(&rpy->stages, (*idx)++);
+		StageInfo *stginfo = stageinfo_get_by_id(rstg->stage);
+
+		if(!stginfo) {
+			log_warn("Invalid stage %X in replay at %i skipped.", rstg->stage, *idx);
+			continue;
+		}
+
+		*out_stginfo = stginfo;
+		return rstg;
+	}
+
+	return NULL;
+}
+
 void replay_stage_destroy_events(ReplayStage *stg) {
 	dynarray_free_data(&stg->events);
 }
@@ -34,3 +34,8 @@ void replay_stage_update_final_stats(ReplayStage *stg, const Stats *stats)
 
 void replay_stage_destroy_events(ReplayStage *stg)
 	attr_nonnull_all;
+
+// Finds the next stage in the replay that can be played, starting at *idx, and advances *idx
+// past it. Stages with unknown IDs are skipped with a warning. Returns NULL at the end.
+ReplayStage *replay_stage_next_playable(Replay *rpy, int *idx, StageInfo **out_stginfo)
+	attr_nonnull_all;
@@ -55,6 +55,9 @@
 
 	// Taisei v1.4 revision 1: switch to zstd compression, remove plr_focus, add skip_frames (for demos), rework/fix player resource usage stats
 	#define REPLAY_STRUCT_VERSION_TS104000_REV1 14
+
+	// Taisei v1.4 revision 2: events are stored as varint frame deltas and per-type value deltas
+	#define REPLAY_STRUCT_VERSION_TS104000_REV2 15
 /* END supported struct versions */
 
 #define REPLAY_VERSION_COMPRESSION_BIT 0x8000
@@ -62,7 +65,7 @@
 
 // What struct version to use when saving recorded replays
 #define REPLAY_STRUCT_VERSION_WRITE \
-	(REPLAY_STRUCT_VERSION_TS104000_REV1 | REPLAY_VERSION_COMPRESSION_BIT)
+	(REPLAY_STRUCT_VERSION_TS104000_REV2 | REPLAY_VERSION_COMPRESSION_BIT)
 
 #define REPLAY_ALLOC_INITIAL 256
 
@@ -75,13 +78,31 @@
 typedef struct ReplayEvent {
 	/* BEGIN stored fields */
 
+	/* BEGIN REPLAY_STRUCT_VERSION_TS104000_REV1 and below */
 	uint32_t frame;
 	uint8_t type;
 	uint16_t value;
+	/* END REPLAY_STRUCT_VERSION_TS104000_REV1 and below */
+
+	/* BEGIN REPLAY_STRUCT_VERSION_TS104000_REV2 and above */
+	// varint: frame - (frame of the previous event in this stage)
+	// uint8_t type;
+	// varint: zigzag((int16_t)(value - (value of the previous event of this type in this stage)))
+	/* END REPLAY_STRUCT_VERSION_TS104000_REV2 and above */
 
 	/* END stored fields */
 } ReplayEvent;
 
+// Varints are little-endian base 128: 7 bits per byte, high bit set on all but the last byte.
+// At most 5 bytes long, since all encoded values fit in 32 bits.
+#define REPLAY_VARINT_MAX_SIZE 5
+
+// Tracks the previously coded event for the delta encoding. Reset at the start of every stage.
+typedef struct ReplayEventCodec {
+	uint32_t frame;
+	uint16_t values[256];  // indexed by event type
+} ReplayEventCodec;
+
 typedef struct ReplayStage {
 	/* BEGIN stored fields */
 
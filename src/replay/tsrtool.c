@@ -16,6 +16,7 @@
 #include "util.h"
 #include "util/strbuf.h"
 #include "plrmodes.h"
+#include "rwops/rwops_autobuf.h"
 
 typedef struct Command {
 	const char *name;
@@ -340,6 +341,107 @@ static int cmd_info(int argc, char **argv) {
 	return 0;
 }
 
+static bool events_equal(Replay *a, Replay *b) {
+	if(a->stages.num_elements != b->stages.num_elements) {
+		return false;
+	}
+
+	dynarray_foreach(&a->stages, int i, ReplayStage *astg, {
+		ReplayStage *bstg = dynarray_get_ptr(&b->stages, i);
+
+		if(astg->events.num_elements != bstg->events.num_elements) {
+			return false;
+		}
+
+		dynarray_foreach(&astg->events, int j, ReplayEvent *aevt, {
+			ReplayEvent *bevt = dynarray_get_ptr(&bstg->events, j);
+
+			if(
+				aevt->frame != bevt->frame ||
+				aevt->type != bevt->type ||
+				aevt->value != bevt->value
+			) {
+				return false;
+			}
+		});
+	});
+
+	return true;
+}
+
+static int cmd_bench(int argc, char **argv) {
+	int iterations = strtol(argv[1], NULL, 10);
+
+	if(iterations < 1) {
+		log_error("Number of iterations must be positive");
+		return -1;
+	}
+
+	if(!G.rpy.stages.num_elements) {
+		log_error("No replay loaded");
+		return -1;
+	}
+
+	static const uint16_t versions[] = {
+		REPLAY_STRUCT_VERSION_TS104000_REV1,
+		REPLAY_STRUCT_VERSION_TS104000_REV1 | REPLAY_VERSION_COMPRESSION_BIT,
+		REPLAY_STRUCT_VERSION_TS104000_REV2,
+		REPLAY_STRUCT_VERSION_TS104000_REV2 | REPLAY_VERSION_COMPRESSION_BIT,
+	};
+
+	StringBuffer sbuf = {};
+	double freq = SDL_GetPerformanceFrequency();
+
+	strbuf_printf(&sbuf, "%-14s %10s %14s %10s", "Version", "Size", "Parse (us)", "Roundtrip");
+	flushline(&sbuf);
+
+	for(int i = 0; i < ARRAY_SIZE(versions); ++i) {
+		uint16_t version = versions[i];
+		void *buf;
+		SDL_RWops *abuf = SDL_RWAutoBuffer(&buf, 4096);
+
+		if(!replay_write(&G.rpy, abuf, version)) {
+			SDL_RWclose(abuf);
+			strbuf_free(&sbuf);
+			return -1;
+		}
+
+		size_t size = SDL_RWtell(abuf);
+		uint64_t total_time = 0;
+		bool roundtrip_ok = true;
+
+		for(int j = 0; j < iterations; ++j) {
+			Replay rpy = {};
+			SDL_RWops *rw = SDL_RWFromConstMem(buf, size);
+
+			uint64_t t = SDL_GetPerformanceCounter();
+			bool ok = replay_read(&rpy, rw, REPLAY_READ_ALL, "<bench>");
+			total_time += SDL_GetPerformanceCounter() - t;
+
+			if(!ok || (j == 0 && !events_equal(&G.rpy, &rpy))) {
+				roundtrip_ok = false;
+			}
+
+			SDL_RWclose(rw);
+			replay_reset(&rpy);
+		}
+
+		SDL_RWclose(abuf);
+
+		strbuf_printf(&sbuf, "%3u %-10s %10zu %14.1f %10s",
+			version & ~REPLAY_VERSION_COMPRESSION_BIT,
+			(version & REPLAY_VERSION_COMPRESSION_BIT) ? "compressed" : "raw",
+			size,
+			1e6 * total_time / freq / iterations,
+			roundtrip_ok ? "ok" : "FAIL"
+		);
+		flushline(&sbuf);
+	}
+
+	strbuf_free(&sbuf);
+	return 1;
+}
+
 static Command commands[] = {
 	{ "reset",              0, cmd_reset, },
 	{ "load",               1, cmd_load,           "load <filename.tsr>" },
@@ -351,6 +453,7 @@ static Command commands[] = {
 	{ "drop",               0, cmd_drop, },
 	{ "isolate",            0, cmd_isolate, },
 	{ "info",               0, cmd_info, },
+	{ "bench",              1, cmd_bench,          "bench <iterations>" },
 };
 
 int tsrtool_main(int argc, char **argv) {
@@ -0,0 +1,217 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#include "taisei.h"
+
+#include "verify.h"
+#include "replay.h"
+#include "stage.h"
+#include "struct.h"
+#include "state.h"
+
+#include "global.h"
+#include "../stage.h"
+#include "stageinfo.h"
+#include "vfs/public.h"
+
+#define VERIFY_MOUNTPOINT "verify-replays"
+
+typedef enum VerifyStatus {
+	VERIFY_PASS,
+	VERIFY_DESYNC,
+	VERIFY_ERROR,
+} VerifyStatus;
+
+typedef struct VerifyResult {
+	const char *name;
+	VerifyStatus status;
+	int desync_stage;
+	int desync_frame;
+	int frames;
+	hrtime_t time;
+} VerifyResult;
+
+typedef struct VerifyContext {
+	CallChain cc;
+	char **files;
+	size_t num_files;
+	size_t current_file;
+	VerifyResult *results;
+	Replay rpy;
+	ResourceGroup rg;
+	int stage_idx;
+	hrtime_t start_time;
+} VerifyContext;
+
+static void verify_next_replay(VerifyContext *ctx);
+static void verify_post_stage(CallChainResult ccr);
+
+static bool verify_path_filter(const char *path) {
+	return strendswith(path, "." REPLAY_EXTENSION);
+}
+
+static const char *verify_status_string(VerifyStatus status) {
+	switch(status) {
+		case VERIFY_PASS:   return "PASS";
+		case VERIFY_DESYNC: return "DESYNC";
+		case VERIFY_ERROR:  return "ERROR";
+		default: UNREACHABLE;
+	}
+}
+
+static int verify_print_summary(VerifyContext *ctx) {
+	int num_failed = 0;
+	hrtime_t total_time = 0;
+
+	tsfprintf(stdout, "\n%-40s %-7s %6s %10s %10s %9s\n",
+		"Replay", "Result", "Stage", "Desync at", "Frames", "Time (s)");
+
+	for(size_t i = 0; i < ctx->num_files; ++i) {
+		VerifyResult *r = ctx->results + i;
+		char stage[8] = "-", desync[16] = "-";
+
+		if(r->status == VERIFY_DESYNC) {
+			snprintf(stage, sizeof(stage), "%X", r->desync_stage);
+			snprintf(desync, sizeof(desync), "%i", r->desync_frame);
+		}
+
+		tsfprintf(stdout, "%-40s %-7s %6s %10s %10i %9.3f\n",
+			r->name,
+			verify_status_string(r->status),
+			stage,
+			desync,
+			r->frames,
+			r->time / (double)HRTIME_RESOLUTION
+		);
+
+		if(r->status != VERIFY_PASS) {
+			++num_failed;
+		}
+
+		total_time += r->time;
+	}
+
+	tsfprintf(stdout, "\n%zu replays verified, %i failed, %.3f seconds total\n",
+		ctx->num_files, num_failed, total_time / (double)HRTIME_RESOLUTION);
+
+	return num_failed;
+}
+
+static void verify_finish(VerifyContext *ctx) {
+	int num_failed = verify_print_summary(ctx);
+
+	res_group_release(&ctx->rg);
+	vfs_dir_list_free(ctx->files, ctx->num_files);
+	vfs_unmount(VERIFY_MOUNTPOINT);
+	mem_free(ctx->results);
+
+	CallChain cc = ctx->cc;
+	mem_free(ctx);
+	run_call_chain(&cc, (void*)(intptr_t)num_failed);
+}
+
+static void verify_finish_replay(VerifyContext *ctx) {
+	VerifyResult *r = ctx->results + ctx->current_file;
+	r->time = time_get() - ctx->start_time;
+
+	log_info("%s: %s", r->name, verify_status_string(r->status));
+
+	global.gameover = 0;
+	replay_state_deinit(&global.replay.input);
+	replay_reset(&ctx->rpy);
+
+	++ctx->current_file;
+	verify_next_replay(ctx);
+}
+
+static void verify_next_stage(VerifyContext *ctx) {
+	Replay *rpy = &ctx->rpy;
+	StageInfo *stginfo;
+	ReplayStage *rstg = replay_stage_next_playable(rpy, &ctx->stage_idx, &stginfo);
+
+	if(rstg == NULL) {
+		verify_finish_replay(ctx);
+		return;
+	}
+
+	replay_state_init_play(&global.replay.input, rpy, rstg);
+	global.plr.mode = plrmode_find(rstg->plr_char, rstg->plr_shot);
+	global.is_practice_mode = false;
+	res_group_release(&ctx->rg);
+	stage_enter(stginfo, &ctx->rg, CALLCHAIN(verify_post_stage, ctx));
+}
+
+static void verify_post_stage(CallChainResult ccr) {
+	VerifyContext *ctx = ccr.ctx;
+	VerifyResult *r = ctx->results + ctx->current_file;
+	ReplayState *rst = &global.replay.input;
+
+	r->frames += global.frames;
+
+	if(rst->mode == REPLAY_PLAY && rst->play.desync_frame >= 0) {
+		r->status = VERIFY_DESYNC;
+		r->desync_stage = rst->stage->stage;
+		r->desync_frame = rst->play.desync_frame;
+		verify_finish_replay(ctx);
+		return;
+	}
+
+	if(global.gameover == GAMEOVER_ABORT) {
+		verify_finish_replay(ctx);
+		return;
+	}
+
+	global.gameover = 0;
+	verify_next_stage(ctx);
+}
+
+static void verify_next_replay(VerifyContext *ctx) {
+	for(; ctx->current_file < ctx->num_files; ++ctx->current_file) {
+		VerifyResult *r = ctx->results + ctx->current_file;
+		r->name = ctx->files[ctx->current_file];
+		r->status = VERIFY_PASS;
+		ctx->start_time = time_get();
+
+		char path[sizeof(VERIFY_MOUNTPOINT) + 1 + strlen(r->name)];
+		snprintf(path, sizeof(path), VERIFY_MOUNTPOINT "/%s", r->name);
+
+		if(replay_load_vfspath(&ctx->rpy, path, REPLAY_READ_ALL)) {
+			ctx->stage_idx = 0;
+			verify_next_stage(ctx);
+			return;
+		}
+
+		r->status = VERIFY_ERROR;
+		r->time = time_get() - ctx->start_time;
+		replay_reset(&ctx->rpy);
+	}
+
+	verify_finish(ctx);
+}
+
+void replay_verify_dir(const char *syspath, CallChain next) {
+	if(!vfs_mount_syspath(VERIFY_MOUNTPOINT, syspath, VFS_SYSPATH_MOUNT_READONLY)) {
+		log_fatal("Failed to mount '%s': %s", syspath, vfs_get_error());
+	}
+
+	auto ctx = ALLOC(VerifyContext, { .cc = next });
+
+	ctx->files = vfs_dir_list_sorted(
+		VERIFY_MOUNTPOINT, &ctx->num_files, vfs_dir_list_order_ascending, verify_path_filter
+	);
+
+	if(!ctx->files || !ctx->num_files) {
+		log_fatal("No replays found in '%s'", syspath);
+	}
+
+	log_info("Verifying %zu replays from %s", ctx->num_files, syspath);
+
+	ctx->results = ALLOC_ARRAY(ctx->num_files, VerifyResult);
+	res_group_init(&ctx->rg);
+	verify_next_replay(ctx);
+}
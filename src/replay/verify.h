@@ -0,0 +1,22 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#pragma once
+#include "taisei.h"
+
+#include "util/callchain.h"
+
+/*
+ * Verifies every replay in the directory at syspath, one after another, reusing
+ * the already initialized engine. Playback of a replay stops at the first
+ * desync. A summary table is printed to stdout when all replays are done.
+ *
+ * The number of replays that failed to verify is passed to `next` as the result,
+ * cast to a pointer.
+ */
+void replay_verify_dir(const char *syspath, CallChain next) attr_nonnull(1);
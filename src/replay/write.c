@@ -102,7 +102,17 @@ static bool replay_write_stage(ReplayStage *stg, SDL_RWops *file, uint16_t versi
 	return true;
 }
 
-static void replay_write_stage_events(ReplayStage *stg, SDL_RWops *file) {
+static void replay_write_stage_events(ReplayStage *stg, SDL_RWops *file, uint16_t version) {
+	if(version >= REPLAY_STRUCT_VERSION_TS104000_REV2) {
+		ReplayEventCodec codec = { };
+
+		dynarray_foreach_elem(&stg->events, ReplayEvent *evt, {
+			replay_write_event_packed(file, &codec, evt);
+		});
+
+		return;
+	}
+
 	dynarray_foreach_elem(&stg->events, ReplayEvent *evt, {
 		SDL_WriteLE32(file, evt->frame);
 		SDL_WriteU8(file, evt->type);
@@ -110,9 +120,9 @@ static void replay_write_stage_events(ReplayStage *stg, SDL_RWops *file) {
 	});
 }
 
-static bool replay_write_events(Replay *rpy, SDL_RWops *file) {
+static bool replay_write_events(Replay *rpy, SDL_RWops *file, uint16_t version) {
 	dynarray_foreach_elem(&rpy->stages, ReplayStage *stg, {
-		replay_write_stage_events(stg, file);
+		replay_write_stage_events(stg, file, version);
 	});
 
 	return true;
@@ -169,7 +179,7 @@ bool replay_write(Replay *rpy, SDL_RWops *file, uint16_t version) {
 		vfile = replay_wrap_stream_compress(version, file, false);
 	}
 
-	bool events_ok = replay_write_events(rpy, vfile);
+	bool events_ok = replay_write_events(rpy, vfile, base_version);
 
 	if(compression) {
 		SDL_RWclose(vfile);
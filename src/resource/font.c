@@ -16,7 +16,10 @@
 #include "font.h"
 #include "config.h"
 #include "events.h"
+#include "hirestime.h"
 #include "renderer/api.h"
+#include "taskmanager.h"
+#include "thread.h"
 #include "util.h"
 #include "util/glm.h"
 #include "util/graphics.h"
@@ -69,6 +72,21 @@ FIXED_CONVERSION(FT_Fixed, f16dot16, 65536.0f)
 
 #define GLOBAL_RENDER_MODE FT_RENDER_MODE_NORMAL
 
+// FT_RENDER_MODE_SDF was introduced in FreeType 2.11
+#if FREETYPE_MAJOR > 2 || (FREETYPE_MAJOR == 2 && FREETYPE_MINOR >= 11)
+	#define HAVE_FT_SDF 1
+#else
+	#define HAVE_FT_SDF 0
+#endif
+
+// Distance field fonts are rasterized once at this scale, regardless of the window size and
+// text quality setting; the text shaders take care of the rest.
+#define GLYPH_SDF_REFERENCE_SCALE 2.0f
+
+// Maximum distance from the outline representable in the distance field, in pixels at the
+// reference scale. Also the amount of padding around each glyph image.
+#define GLYPH_SDF_SPREAD 8
+
 static const struct ft_error_def {
 	FT_Error    err_code;
 	const char *err_msg;
@@ -87,6 +105,13 @@ static const char *ft_error_str(FT_Error err_code) {
 	return "Unknown error";
 }
 
+// TODO: Figure out sensible values for these; maybe make them depend on font size in some way.
+#define SS_WIDTH 2048
+#define SS_HEIGHT 2048
+
+#define SS_TEXTURE_TYPE TEX_TYPE_RGB_8
+#define SS_TEXTURE_FLAGS 0
+
 typedef struct SpriteSheet {
 	LIST_INTERFACE(struct SpriteSheet);
 	Texture *tex;
@@ -104,6 +129,15 @@ typedef struct Glyph {
 	ulong ft_index;
 } Glyph;
 
+// Direct-mapped glyph offset caches for the most commonly drawn code points:
+// Basic Latin, Latin-1 Supplement and Latin Extended-A; CJK Symbols and Punctuation,
+// Hiragana and Katakana. Entries store the glyph offset + 1; 0 means not cached.
+// Everything else goes through charcodes_to_glyph_ofs.
+#define GLYPH_TABLE_LATIN_FIRST 0x0000
+#define GLYPH_TABLE_LATIN_SIZE  0x0180
+#define GLYPH_TABLE_KANA_FIRST  0x3000
+#define GLYPH_TABLE_KANA_SIZE   0x0100
+
 struct Font {
 	char *source_path;
 	DYNAMIC_ARRAY(Glyph) glyphs;
@@ -115,9 +149,21 @@ struct Font {
 	float base_border_outer;
 	ht_int2int_t charcodes_to_glyph_ofs;
 	ht_int2int_t ftindex_to_glyph_ofs;
+	int32_t glyph_table_latin[GLYPH_TABLE_LATIN_SIZE];
+	int32_t glyph_table_kana[GLYPH_TABLE_KANA_SIZE];
 	FontMetrics metrics;
 	bool kerning;
 
+	// Glyphs are stored as signed distance fields, at GLYPH_SDF_REFERENCE_SCALE.
+	bool sdf;
+
+	// Incremented whenever the glyph cache is invalidated or kerning is toggled; see TextLayout.
+	uint generation;
+
+	// Background pre-rasterization of commonly used glyphs; see request_glyph_warming().
+	struct GlyphWarmJob *warm_job;
+	uint warm_generation;  // generation + 1 of the last submitted job
+
 #ifdef DEBUG
 	char debug_label[64];
 #endif
@@ -129,6 +175,7 @@ static struct {
 	Texture *render_tex;
 	Framebuffer *render_buf;
 	SpriteSheetAnchor spritesheets;
+	SpriteSheetAnchor sdf_spritesheets;
 
 	struct {
 		SDL_mutex *new_face;
@@ -136,6 +183,14 @@ static struct {
 	} mutex;
 
 	ResourceGroup rg;
+	bool glyph_table_disabled;
+
+	// Optimal upload format for glyph pixmaps, queried once on init.
+	PixmapFormat ss_pixmap_format;
+	PixmapOrigin ss_pixmap_origin;
+
+	// Used by text_draw() and friends to lay out the text on every call.
+	TextLayout *scratch_layout;
 } globals;
 
 static float global_font_scale(void) {
@@ -145,6 +200,7 @@ static float global_font_scale(void) {
 }
 
 static void reload_fonts(float quality);
+static void process_glyph_warm_jobs(void);
 
 static bool fonts_event(SDL_Event *event, void *arg) {
 	if(!IS_TAISEI_EVENT(event->type)) {
@@ -152,6 +208,11 @@ static bool fonts_event(SDL_Event *event, void *arg) {
 	}
 
 	switch(TAISEI_EVENT(event->type)) {
+		case TE_FRAME: {
+			process_glyph_warm_jobs();
+			break;
+		}
+
 		case TE_VIDEO_MODE_CHANGED: {
 			reload_fonts(global_font_scale());
 			break;
@@ -207,6 +268,26 @@ static void init_fonts(void) {
 
 	FT_Add_Default_Modules(globals.lib);
 
+#if HAVE_FT_SDF
+	FT_Int sdf_spread = GLYPH_SDF_SPREAD;
+
+	if((err = FT_Property_Set(globals.lib, "sdf", "spread", &sdf_spread))) {
+		log_warn("FT_Property_Set() failed: %s", ft_error_str(err));
+	}
+#endif
+
+	TextureTypeQueryResult qr = { 0 };
+
+	if(r_texture_type_query(SS_TEXTURE_TYPE, SS_TEXTURE_FLAGS, PIXMAP_FORMAT_RGB8, PIXMAP_ORIGIN_BOTTOMLEFT, &qr)) {
+		globals.ss_pixmap_format = qr.optimal_pixmap_format;
+		globals.ss_pixmap_origin = qr.optimal_pixmap_origin;
+	} else {
+		log_error("Texture query failed!");
+		assert(0);
+		globals.ss_pixmap_format = PIXMAP_FORMAT_RGB8;
+		globals.ss_pixmap_origin = PIXMAP_ORIGIN_BOTTOMLEFT;
+	}
+
 	events_register_handler(&(EventHandler) {
 		fonts_event, NULL, EPRIO_SYSTEM,
 	});
@@ -245,6 +326,8 @@ static void post_init_fonts(void) {
 }
 
 static void shutdown_fonts(void) {
+	text_layout_free(globals.scratch_layout);
+	globals.scratch_layout = NULL;
 	res_group_release(&globals.rg);
 	res_purge();
 	r_texture_destroy(globals.render_tex);
@@ -295,6 +378,16 @@ static FT_Error FT_Done_Face_Thread_Safe(FT_Face face) {
 	return err;
 }
 
+static void free_font_face(FT_Face face) {
+	FT_Stream stream = face->stream;
+	FT_Done_Face_Thread_Safe(face);
+
+	if(stream) {
+		mem_free(stream->pathname.pointer);
+		mem_free(stream);
+	}
+}
+
 static FT_Face load_font_face(char *vfspath, long index) {
 	char *syspath = vfs_repr(vfspath, true);
 
@@ -384,15 +477,14 @@ bool font_get_kerning_enabled(Font *font) {
 }
 
 void font_set_kerning_enabled(Font *font, bool newval) {
-	font->kerning = (newval && FT_HAS_KERNING(font->face));
-}
+	newval = newval && FT_HAS_KERNING(font->face);
 
-// TODO: Figure out sensible values for these; maybe make them depend on font size in some way.
-#define SS_WIDTH 2048
-#define SS_HEIGHT 2048
-
-#define SS_TEXTURE_TYPE TEX_TYPE_RGB_8
-#define SS_TEXTURE_FLAGS 0
+	if(font->kerning != newval) {
+		font->kerning = newval;
+		// Cached layouts have kerning baked into their glyph positions
+		font->generation++;
+	}
+}
 
 static SpriteSheet *add_spritesheet(SpriteSheetAnchor *spritesheets) {
 	auto ss = ALLOC(SpriteSheet, {
@@ -502,33 +594,149 @@ static void delete_spritesheet(SpriteSheetAnchor *spritesheets, SpriteSheet *ss)
 	mem_free(ss);
 }
 
-static Glyph *load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesheets) {
+static SpriteSheetAnchor *font_spritesheets(Font *font) {
+	return font->sdf ? &globals.sdf_spritesheets : &globals.spritesheets;
+}
+
+typedef struct GlyphRaster {
+	GlyphMetrics metrics;
+	Pixmap pixmap;  // data is NULL for invisible glyphs
+	float xpad;     // how much larger the image is than the glyph fill
+	float ypad;
+	FT_UInt ft_index;
+} GlyphRaster;
+
+static void get_glyph_metrics(FT_Face face, GlyphMetrics *metrics) {
+	metrics->bearing_x = f26dot6_to_float(face->glyph->metrics.horiBearingX);
+	metrics->bearing_y = f26dot6_to_float(face->glyph->metrics.horiBearingY);
+	metrics->width = f26dot6_to_float(face->glyph->metrics.width);
+	metrics->height = f26dot6_to_float(face->glyph->metrics.height);
+	metrics->advance = f26dot6_to_float(face->glyph->metrics.horiAdvance);
+	metrics->lsb_delta = f26dot6_to_float(face->glyph->lsb_delta);
+	metrics->rsb_delta = f26dot6_to_float(face->glyph->rsb_delta);
+}
+
+#if HAVE_FT_SDF
+
+/*
+ * The distance field is stored in the same channel layout as regular glyphs: fill, outer border,
+ * inner border. Each channel holds 0.5 + d / (2 * GLYPH_SDF_SPREAD), where d is the distance to
+ * the respective outline in pixels, positive inside. The border channels are just the fill
+ * channel offset by the border widths, so the shaders can resolve all three the same way.
+ */
+static bool rasterize_glyph_sdf(
+	FT_Face face, float border_inner, float border_outer, FT_UInt gindex, GlyphRaster *out
+) {
+	FT_Error err = FT_Load_Glyph(face, gindex, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING);
+
+	if(err) {
+		log_warn("FT_Load_Glyph(%u) failed: %s", gindex, ft_error_str(err));
+		return false;
+	}
+
+	*out = (GlyphRaster) { .ft_index = gindex };
+	get_glyph_metrics(face, &out->metrics);
+
+	if(face->glyph->outline.n_contours == 0) {
+		// invisible glyph (e.g. space)
+		return true;
+	}
+
+	if((err = FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))) {
+		log_warn("FT_Render_Glyph(%u) failed: %s", gindex, ft_error_str(err));
+		return false;
+	}
+
+	FT_Bitmap *bm = &face->glyph->bitmap;
+
+	if(bm->width == 0 || bm->rows == 0) {
+		return true;
+	}
+
+	if(bm->pixel_mode != FT_PIXEL_MODE_GRAY) {
+		log_warn(
+			"Glyph %u returned bitmap with pixel format %s. Only %s is supported, sorry. Ignoring",
+			gindex,
+			pixmode_name(bm->pixel_mode),
+			pixmode_name(FT_PIXEL_MODE_GRAY)
+		);
+
+		return false;
+	}
+
+	float dist_scale = 255.0f / (2.0f * GLYPH_SDF_SPREAD);
+	int ofs_outer = roundf(dist_scale * f26dot6_to_float(
+		FT_MulFix(float_to_f26dot6(border_outer), face->size->metrics.y_scale)));
+	int ofs_inner = roundf(dist_scale * f26dot6_to_float(
+		FT_MulFix(float_to_f26dot6(border_inner), face->size->metrics.y_scale)));
+
+	Pixmap px;
+	px.origin = PIXMAP_ORIGIN_BOTTOMLEFT;
+	px.format = PIXMAP_FORMAT_RGB8;
+	px.width = bm->width;
+	px.height = bm->rows;
+	px.data.rgb8 = pixmap_alloc_buffer_for_copy(&px, &px.data_size);
+
+	for(uint y = 0; y < px.height; ++y) {
+		const uint8_t *row = bm->buffer + (bm->rows - y - 1) * bm->pitch;
+		PixelRGB8 *p = px.data.rgb8 + y * px.width;
+
+		for(uint x = 0; x < px.width; ++x, ++p) {
+			int d = row[x];
+			p->r = d;
+			p->g = imin(d + ofs_outer, 255);
+			p->b = imax(d - ofs_inner, 0);
+		}
+	}
+
+	pixmap_convert_inplace_realloc(&px, globals.ss_pixmap_format);
+	pixmap_flip_to_origin_inplace(&px, globals.ss_pixmap_origin);
+
+	// The image extends GLYPH_SDF_SPREAD pixels past the outline on every side, just like the
+	// border does for regular glyphs, so the padding is the same: image size minus fill size.
+	out->pixmap = px;
+	out->xpad = 2 * GLYPH_SDF_SPREAD;
+	out->ypad = 2 * GLYPH_SDF_SPREAD;
+
+	return true;
+}
+
+#endif
+
+// Renders a glyph into a pixmap suitable for uploading into a spritesheet.
+// Doesn't touch the renderer, so it can be called on any thread, as long as the face and
+// stroker are not used concurrently.
+static bool rasterize_glyph(
+	FT_Face face, FT_Stroker stroker, float border_inner, float border_outer, bool sdf,
+	FT_UInt gindex, GlyphRaster *out
+) {
 	// log_debug("Loading glyph 0x%08x", gindex);
 
+#if HAVE_FT_SDF
+	if(sdf) {
+		return rasterize_glyph_sdf(face, border_inner, border_outer, gindex, out);
+	}
+#else
+	assert(!sdf);
+#endif
+
 	FT_Render_Mode render_mode = GLOBAL_RENDER_MODE;
-	FT_Error err = FT_Load_Glyph(font->face, gindex,
+	FT_Error err = FT_Load_Glyph(face, gindex,
 		FT_LOAD_NO_BITMAP |
 		FT_LOAD_TARGET_(render_mode) |
 	0);
 
 	if(err) {
 		log_warn("FT_Load_Glyph(%u) failed: %s", gindex, ft_error_str(err));
-		return NULL;
+		return false;
 	}
 
-	Glyph *glyph = dynarray_append(&font->glyphs);
-
-	glyph->metrics.bearing_x = f26dot6_to_float(font->face->glyph->metrics.horiBearingX);
-	glyph->metrics.bearing_y = f26dot6_to_float(font->face->glyph->metrics.horiBearingY);
-	glyph->metrics.width = f26dot6_to_float(font->face->glyph->metrics.width);
-	glyph->metrics.height = f26dot6_to_float(font->face->glyph->metrics.height);
-	glyph->metrics.advance = f26dot6_to_float(font->face->glyph->metrics.horiAdvance);
-	glyph->metrics.lsb_delta = f26dot6_to_float(font->face->glyph->lsb_delta);
-	glyph->metrics.rsb_delta = f26dot6_to_float(font->face->glyph->rsb_delta);
+	*out = (GlyphRaster) { .ft_index = gindex };
+	get_glyph_metrics(face, &out->metrics);
 
 	FT_Glyph g_src = NULL, g_fill = NULL, g_border = NULL, g_inner = NULL;
 	FT_BitmapGlyph g_bm_fill = NULL, g_bm_border = NULL, g_bm_inner = NULL;
-	FT_Get_Glyph(font->face->glyph, &g_src);
+	FT_Get_Glyph(face->glyph, &g_src);
 	FT_Glyph_Copy(g_src, &g_fill);
 	FT_Glyph_Copy(g_src, &g_border);
 	FT_Glyph_Copy(g_src, &g_inner);
@@ -541,28 +749,25 @@ static Glyph *load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 		have_bitmap = ((FT_BitmapGlyph)g_fill)->bitmap.width > 0;
 	}
 
-	if(!have_bitmap) {
-		// Some glyphs may be invisible, but we still need the metrics data for them (e.g. space)
-		memset(&glyph->sprite, 0, sizeof(Sprite));
-	} else {
-		FT_Stroker_Set(font->stroker,
+	if(have_bitmap) {
+		FT_Stroker_Set(stroker,
 			FT_MulFix(
-				float_to_f26dot6(font->base_border_outer),
-				font->face->size->metrics.y_scale),
+				float_to_f26dot6(border_outer),
+				face->size->metrics.y_scale),
 			FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0
 		);
 
-		FT_Glyph_StrokeBorder(&g_border, font->stroker, false, true);
+		FT_Glyph_StrokeBorder(&g_border, stroker, false, true);
 		FT_Glyph_To_Bitmap(&g_border, GLOBAL_RENDER_MODE, NULL, true);
 
-		FT_Stroker_Set(font->stroker,
+		FT_Stroker_Set(stroker,
 			FT_MulFix(
-				float_to_f26dot6(font->base_border_inner),
-				font->face->size->metrics.y_scale),
+				float_to_f26dot6(border_inner),
+				face->size->metrics.y_scale),
 			FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_BEVEL, 0
 		);
 
-		FT_Glyph_StrokeBorder(&g_inner, font->stroker, true, true);
+		FT_Glyph_StrokeBorder(&g_inner, stroker, true, true);
 		FT_Glyph_To_Bitmap(&g_inner, GLOBAL_RENDER_MODE, NULL, true);
 
 		g_bm_fill = (FT_BitmapGlyph)g_fill;
@@ -585,8 +790,7 @@ static Glyph *load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 			FT_Done_Glyph(g_fill);
 			FT_Done_Glyph(g_border);
 			FT_Done_Glyph(g_inner);
-			font->glyphs.num_elements--;
-			return NULL;
+			return false;
 		}
 
 		Pixmap px;
@@ -650,60 +854,310 @@ static Glyph *load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 			}
 		}
 
-		TextureTypeQueryResult qr = { 0 };
+		pixmap_convert_inplace_realloc(&px, globals.ss_pixmap_format);
+		pixmap_flip_to_origin_inplace(&px, globals.ss_pixmap_origin);
 
-		// TODO: Only query this once on init.
-		if(r_texture_type_query(SS_TEXTURE_TYPE, SS_TEXTURE_FLAGS, px.format, px.origin, &qr)) {
-			pixmap_convert_inplace_realloc(&px, qr.optimal_pixmap_format);
-			pixmap_flip_to_origin_inplace(&px, qr.optimal_pixmap_origin);
-		} else {
-			log_error("Texture query failed!");
-			assert(0);
+		out->pixmap = px;
+		out->xpad = px.width - (float)g_bm_fill->bitmap.width;
+		out->ypad = px.height - (float)g_bm_fill->bitmap.rows;
+	}
+
+	FT_Done_Glyph(g_src);
+	FT_Done_Glyph(g_fill);
+	FT_Done_Glyph(g_border);
+	FT_Done_Glyph(g_inner);
+
+	return true;
+}
+
+// Adds a rasterized glyph to the font and uploads its image. Takes ownership of the pixmap.
+static Glyph *commit_glyph(Font *font, GlyphRaster *raster, SpriteSheetAnchor *spritesheets) {
+	Glyph *glyph = dynarray_append(&font->glyphs);
+	glyph->metrics = raster->metrics;
+	glyph->ft_index = raster->ft_index;
+
+	Pixmap *px = &raster->pixmap;
+
+	if(px->data.untyped == NULL) {
+		// Some glyphs may be invisible, but we still need the metrics data for them (e.g. space)
+		memset(&glyph->sprite, 0, sizeof(Sprite));
+		return glyph;
+	}
+
+	if(!add_glyph_to_spritesheets(glyph, px, spritesheets)) {
+		log_error(
+			"Glyph %u fill can't fit into any spritesheets (padded bitmap size: %ux%u; max spritesheet size: %ux%u)",
+			raster->ft_index,
+			px->width + 2 * GLYPH_SPRITE_PADDING,
+			px->height + 2 * GLYPH_SPRITE_PADDING,
+			SS_WIDTH,
+			SS_HEIGHT
+		);
+
+		mem_free(px->data.untyped);
+		px->data.untyped = NULL;
+		--font->glyphs.num_elements;
+		return NULL;
+	}
+
+	float xpad = raster->xpad;
+	float ypad = raster->ypad;
+	glyph->sprite.padding.extent.w = xpad;
+	glyph->sprite.padding.extent.h = ypad;
+	glyph->sprite.padding.offset.x = -xpad;
+	glyph->sprite.padding.offset.y = -ypad;
+	glyph->sprite.extent.as_cmplx += glyph->sprite.padding.extent.as_cmplx;
+
+	mem_free(px->data.untyped);
+	px->data.untyped = NULL;
+
+	return glyph;
+}
+
+static Glyph *load_glyph(Font *font, FT_UInt gindex) {
+	GlyphRaster raster;
+
+	if(!rasterize_glyph(
+		font->face, font->stroker, font->base_border_inner, font->base_border_outer, font->sdf,
+		gindex, &raster
+	)) {
+		return NULL;
+	}
+
+	return commit_glyph(font, &raster, font_spritesheets(font));
+}
+
+/*
+ * Glyph warming: shortly after a font is first used (or its glyph cache invalidated), a task
+ * rasterizes the characters we're likely to need on a worker thread, using its own FT_Face.
+ * The main thread then adds the results to the spritesheets a few at a time on every frame,
+ * so that text appearing for the first time doesn't stall on rasterization.
+ */
+
+// Roughly what the menus and dialogue use.
+static const struct { charcode_t first, last; } glyph_warm_charset[] = {
+	{ 0x0020, 0x007e },  // Basic Latin
+	{ 0x00a0, 0x00ff },  // Latin-1 Supplement
+	{ 0x2010, 0x2026 },  // Dashes, quotation marks, ellipsis
+	{ 0x3000, 0x30ff },  // CJK Symbols and Punctuation, Hiragana, Katakana
+};
+
+// Main thread time to spend on uploading warmed glyphs per frame.
+#define GLYPH_WARM_FRAME_BUDGET (HRTIME_RESOLUTION / 1000)
+
+typedef struct GlyphWarmResult {
+	charcode_t charcode;
+	GlyphRaster raster;
+} GlyphWarmResult;
+
+typedef struct GlyphWarmJob {
+	Task *task;
+	uint font_generation;
+	uint num_consumed;
+
+	// Inputs; copied so that the worker never touches the Font
+	char *source_path;
+	long face_idx;
+	int base_size;
+	float scale;
+	float border_inner;
+	float border_outer;
+	bool sdf;
+
+	// Output; accessed on the main thread only once the task has finished
+	DYNAMIC_ARRAY(GlyphWarmResult) results;
+} GlyphWarmJob;
+
+static void *glyph_warm_task(void *arg) {
+	GlyphWarmJob *job = arg;
+	FT_Face face = load_font_face(job->source_path, job->face_idx);
+
+	if(!face) {
+		return NULL;
+	}
+
+	FT_Stroker stroker = NULL;
+	FT_Error err;
+
+	if((err = FT_Set_Char_Size(face, 0, float_to_f26dot6(job->base_size * job->scale), 0, 0))) {
+		log_error("FT_Set_Char_Size() failed: %s", ft_error_str(err));
+		goto done;
+	}
+
+	if((err = FT_Stroker_New(globals.lib, &stroker))) {
+		log_error("FT_Stroker_New() failed: %s", ft_error_str(err));
+		stroker = NULL;
+		goto done;
+	}
+
+	for(int i = 0; i < ARRAY_SIZE(glyph_warm_charset); ++i) {
+		for(charcode_t cp = glyph_warm_charset[i].first; cp <= glyph_warm_charset[i].last; ++cp) {
+			FT_UInt gindex = FT_Get_Char_Index(face, cp);
+
+			if(gindex == 0) {
+				continue;
+			}
+
+			GlyphRaster raster;
+
+			if(rasterize_glyph(
+				face, stroker, job->border_inner, job->border_outer, job->sdf, gindex, &raster
+			)) {
+				*dynarray_append(&job->results) = (GlyphWarmResult) {
+					.charcode = cp,
+					.raster = raster,
+				};
+			}
 		}
+	}
 
-		if(!add_glyph_to_spritesheets(glyph, &px, spritesheets)) {
-			log_error(
-				"Glyph %u fill can't fit into any spritesheets (padded bitmap size: %ux%u; max spritesheet size: %ux%u)",
-				gindex,
-				px.width + 2 * GLYPH_SPRITE_PADDING,
-				px.height + 2 * GLYPH_SPRITE_PADDING,
-				SS_WIDTH,
-				SS_HEIGHT
-			);
+done:
+	if(stroker) {
+		FT_Stroker_Done(stroker);
+	}
 
-			mem_free(px.data.rg8);
-			FT_Done_Glyph(g_src);
-			FT_Done_Glyph(g_fill);
-			FT_Done_Glyph(g_border);
-			FT_Done_Glyph(g_inner);
-			--font->glyphs.num_elements;
-			return NULL;
+	free_font_face(face);
+	return NULL;
+}
+
+static void free_glyph_warm_job(GlyphWarmJob *job) {
+	for(uint i = job->num_consumed; i < job->results.num_elements; ++i) {
+		mem_free(dynarray_get_ptr(&job->results, i)->raster.pixmap.data.untyped);
+	}
+
+	dynarray_free_data(&job->results);
+	mem_free(job->source_path);
+	mem_free(job);
+}
+
+static void cancel_glyph_warm_job(GlyphWarmJob *job) {
+	// Must wait for the task if it's already running, since it writes into the job
+	task_cancel(job->task);
+	task_finish(job->task, NULL);
+	free_glyph_warm_job(job);
+}
+
+static void request_glyph_warming(Font *font) {
+	if(font->warm_job || font->warm_generation == font->generation + 1 || !thread_current_is_main()) {
+		return;
+	}
+
+	font->warm_generation = font->generation + 1;
+
+	auto job = ALLOC(GlyphWarmJob, {
+		.font_generation = font->generation,
+		.source_path = strdup(font->source_path),
+		.face_idx = font->base_face_idx,
+		.base_size = font->base_size,
+		.scale = font->metrics.scale,
+		.border_inner = font->base_border_inner,
+		.border_outer = font->base_border_outer,
+		.sdf = font->sdf,
+	});
+
+	job->task = taskmgr_global_submit((TaskParams) {
+		.callback = glyph_warm_task,
+		.userdata = job,
+		.prio = 1,
+	});
+
+	if(!job->task) {
+		free_glyph_warm_job(job);
+		return;
+	}
+
+	font->warm_job = job;
+}
+
+static void commit_warmed_glyph(Font *font, GlyphWarmResult *r) {
+	if(ht_lookup(&font->charcodes_to_glyph_ofs, r->charcode, NULL)) {
+		mem_free(r->raster.pixmap.data.untyped);
+		r->raster.pixmap.data.untyped = NULL;
+		return;
+	}
+
+	int64_t ofs;
+
+	if(ht_lookup(&font->ftindex_to_glyph_ofs, r->raster.ft_index, &ofs)) {
+		mem_free(r->raster.pixmap.data.untyped);
+		r->raster.pixmap.data.untyped = NULL;
+	} else {
+		Glyph *glyph = commit_glyph(font, &r->raster, font_spritesheets(font));
+		ofs = glyph ? dynarray_indexof(&font->glyphs, glyph) : -1;
+		ht_set(&font->ftindex_to_glyph_ofs, r->raster.ft_index, ofs);
+	}
+
+	ht_set(&font->charcodes_to_glyph_ofs, r->charcode, ofs);
+}
+
+// Returns false if the frame budget has been exhausted.
+static bool consume_glyph_warm_job(Font *font, hrtime_t deadline) {
+	GlyphWarmJob *job = font->warm_job;
+	TaskStatus status = task_status(job->task);
+
+	if(status == TASK_PENDING || status == TASK_RUNNING) {
+		return true;
+	}
+
+	if(job->font_generation == font->generation) {
+		while(job->num_consumed < job->results.num_elements) {
+			if(time_get() >= deadline) {
+				return false;
+			}
+
+			commit_warmed_glyph(font, dynarray_get_ptr(&job->results, job->num_consumed++));
 		}
+	}
 
-		mem_free(px.data.rg8);
+	task_finish(job->task, NULL);
+	free_glyph_warm_job(job);
+	font->warm_job = NULL;
+	return true;
+}
 
-		float xpad = px.width - g_bm_fill->bitmap.width;
-		float ypad = px.height - g_bm_fill->bitmap.rows;
-		glyph->sprite.padding.extent.w = xpad;
-		glyph->sprite.padding.extent.h = ypad;
-		glyph->sprite.padding.offset.x = -xpad;
-		glyph->sprite.padding.offset.y = -ypad;
-		glyph->sprite.extent.as_cmplx += glyph->sprite.padding.extent.as_cmplx;
+static void *process_glyph_warm_jobs_callback(const char *name, Resource *res, void *varg) {
+	Font *font = res->data;
+
+	if(font->warm_job && !consume_glyph_warm_job(font, *(hrtime_t*)varg)) {
+		return res;  // out of time, stop iterating
 	}
 
-	FT_Done_Glyph(g_src);
-	FT_Done_Glyph(g_fill);
-	FT_Done_Glyph(g_border);
-	FT_Done_Glyph(g_inner);
+	return NULL;
+}
 
-	glyph->ft_index = gindex;
-	return glyph;
+static void process_glyph_warm_jobs(void) {
+	hrtime_t deadline = time_get() + GLYPH_WARM_FRAME_BUDGET;
+	res_for_each(RES_FONT, process_glyph_warm_jobs_callback, &deadline);
+}
+
+static int32_t *get_glyph_table_slot(Font *fnt, charcode_t cp) {
+	if(globals.glyph_table_disabled) {
+		return NULL;
+	}
+
+	if(cp - GLYPH_TABLE_LATIN_FIRST < GLYPH_TABLE_LATIN_SIZE) {
+		return fnt->glyph_table_latin + (cp - GLYPH_TABLE_LATIN_FIRST);
+	}
+
+	if(cp - GLYPH_TABLE_KANA_FIRST < GLYPH_TABLE_KANA_SIZE) {
+		return fnt->glyph_table_kana + (cp - GLYPH_TABLE_KANA_FIRST);
+	}
+
+	return NULL;
 }
 
 static Glyph *get_glyph(Font *fnt, charcode_t cp) {
+	int32_t *slot = get_glyph_table_slot(fnt, cp);
+
+	if(slot && *slot) {
+		return dynarray_get_ptr(&fnt->glyphs, *slot - 1);
+	}
+
 	int64_t ofs;
 
 	if(!ht_lookup(&fnt->charcodes_to_glyph_ofs, cp, &ofs)) {
+		request_glyph_warming(fnt);
+
 		Glyph *glyph;
 		uint ft_index = FT_Get_Char_Index(fnt->face, cp);
 		// log_debug("Glyph for charcode 0x%08lx not cached", cp);
@@ -713,7 +1167,7 @@ static Glyph *get_glyph(Font *fnt, charcode_t cp) {
 			glyph = get_glyph(fnt, UNICODE_UNKNOWN);
 			ofs = glyph ? dynarray_indexof(&fnt->glyphs, glyph) : -1;
 		} else if(!ht_lookup(&fnt->ftindex_to_glyph_ofs, ft_index, &ofs)) {
-			glyph = load_glyph(fnt, ft_index, &globals.spritesheets);
+			glyph = load_glyph(fnt, ft_index);
 			ofs = glyph ? dynarray_indexof(&fnt->glyphs, glyph) : -1;
 			ht_set(&fnt->ftindex_to_glyph_ofs, ft_index, ofs);
 		}
@@ -721,7 +1175,19 @@ static Glyph *get_glyph(Font *fnt, charcode_t cp) {
 		ht_set(&fnt->charcodes_to_glyph_ofs, cp, ofs);
 	}
 
-	return ofs < 0 ? NULL : dynarray_get_ptr(&fnt->glyphs, ofs);
+	if(ofs < 0) {
+		return NULL;
+	}
+
+	if(slot) {
+		*slot = ofs + 1;
+	}
+
+	return dynarray_get_ptr(&fnt->glyphs, ofs);
+}
+
+void font_set_glyph_table_enabled(bool enabled) {
+	globals.glyph_table_disabled = !enabled;
 }
 
 attr_nonnull(1)
@@ -740,25 +1206,26 @@ static void wipe_glyph_cache(Font *font) {
 		rectpack_reclaim(rp, section);
 
 		if(rectpack_is_empty(rp)) {
-			delete_spritesheet(&globals.spritesheets, ss);
+			delete_spritesheet(font_spritesheets(font), ss);
 		}
 	});
 
 	ht_unset_all(&font->charcodes_to_glyph_ofs);
 	ht_unset_all(&font->ftindex_to_glyph_ofs);
+	memset(font->glyph_table_latin, 0, sizeof(font->glyph_table_latin));
+	memset(font->glyph_table_kana, 0, sizeof(font->glyph_table_kana));
 
 	font->glyphs.num_elements = 0;
 }
 
 static void free_font_resources(Font *font) {
-	if(font->face) {
-		FT_Stream stream = font->face->stream;
-		FT_Done_Face_Thread_Safe(font->face);
+	if(font->warm_job) {
+		cancel_glyph_warm_job(font->warm_job);
+		font->warm_job = NULL;
+	}
 
-		if(stream) {
-			mem_free(stream->pathname.pointer);
-			mem_free(stream);
-		}
+	if(font->face) {
+		free_font_face(font->face);
 	}
 
 	if(font->stroker) {
@@ -796,6 +1263,7 @@ void load_font(ResourceLoadState *st) {
 		{ "face",          .out_long  = &font.base_face_idx },
 		{ "border_inner",  .out_float = &font.base_border_inner, },
 		{ "border_outer",  .out_float = &font.base_border_outer, },
+		{ "sdf",           .out_bool  = &font.sdf },
 		{ NULL }
 	});
 
@@ -814,6 +1282,13 @@ void load_font(ResourceLoadState *st) {
 		return;
 	}
 
+#if !HAVE_FT_SDF
+	if(font.sdf) {
+		log_warn("%s: Distance field fonts require FreeType 2.11 or newer", st->path);
+		font.sdf = false;
+	}
+#endif
+
 	ht_create(&font.charcodes_to_glyph_ofs);
 	ht_create(&font.ftindex_to_glyph_ofs);
 
@@ -822,7 +1297,7 @@ void load_font(ResourceLoadState *st) {
 		res_load_failed(st);
 	}
 
-	if(set_font_size(&font, global_font_scale())) {
+	if(set_font_size(&font, font.sdf ? GLYPH_SDF_REFERENCE_SCALE : global_font_scale())) {
 		free_font_resources(&font);
 		res_load_failed(st);
 		return;
@@ -860,9 +1335,15 @@ struct rlfonts_arg {
 
 attr_nonnull(1)
 static void reload_font(Font *font, float quality) {
+	if(font->sdf) {
+		// Scale-independent; nothing to do.
+		return;
+	}
+
 	if(font->metrics.scale != quality) {
 		wipe_glyph_cache(font);
 		set_font_size(font, quality);
+		font->generation++;
 	}
 }
 
@@ -1117,15 +1598,123 @@ static Font *font_from_params(const TextParams *params) {
 	return font;
 }
 
-static void set_batch_texture(SpriteStateParams *stp, Texture *tex) {
+static bool set_batch_texture(SpriteStateParams *stp, Texture *tex) {
 	if(stp->primary_texture != tex) {
 		stp->primary_texture = tex;
 		r_sprite_batch_prepare_state(stp);
+		return true;
+	}
+
+	return false;
+}
+
+typedef struct TextLayoutGlyph {
+	Texture *tex;
+	FloatRect texrect;
+	FloatExtent dims;   // image dimensions, in font pixels
+	FloatOffset pos;    // position of the quad center, relative to the text origin, in font pixels
+	FloatOffset tex_ofs;  // offset in the overlay texture space, excluding the overlay height
+	charcode_t charcode;
+} TextLayoutGlyph;
+
+struct TextLayout {
+	// Cache key
+	Font *font;
+	char *text;
+	uint font_generation;
+	Alignment align;
+	float max_width;
+
+	DYNAMIC_ARRAY(TextLayoutGlyph) glyphs;
+	TextBBox bbox;
+	float xofs;
+	float width;
+};
+
+TextLayout *text_layout_new(void) {
+	return ALLOC(TextLayout);
+}
+
+void text_layout_free(TextLayout *layout) {
+	if(layout) {
+		dynarray_free_data(&layout->glyphs);
+		mem_free(layout->text);
+		mem_free(layout);
 	}
 }
 
 attr_nonnull(1, 2, 3)
-static float _text_ucs4_draw(Font *font, const uint32_t *ucs4text, const TextParams *params) {
+static void text_layout_build(TextLayout *layout, Font *font, const uint32_t *ucs4text, Alignment align) {
+	layout->font = font;
+	layout->font_generation = font->generation;
+	layout->align = align;
+	layout->glyphs.num_elements = 0;
+
+	text_ucs4_bbox(font, ucs4text, 0, &layout->bbox);
+
+	Cursor c = cursor_init(font);
+	float y = 0;
+
+	adjust_xpos(font, ucs4text, align, 0, &c.x);
+	layout->xofs = c.x;
+
+	// FIXME: is there a better way?
+	float texmat_offset_sign;
+
+	if(r_supports(RFEAT_TEXTURE_BOTTOMLEFT_ORIGIN)) {
+		texmat_offset_sign = -1;
+	} else {
+		texmat_offset_sign = 1;
+	}
+
+	const uint32_t *tptr = ucs4text;
+
+	while(*tptr) {
+		uint32_t uchar = *tptr++;
+
+		if(uchar == '\n') {
+			cursor_reset(&c);
+			adjust_xpos(font, tptr, align, 0, &c.x);
+			y += font->metrics.lineskip;
+			continue;
+		}
+
+		Glyph *glyph = get_glyph(font, uchar);
+
+		if(glyph == NULL) {
+			continue;
+		}
+
+		float x = cursor_advance(&c, glyph);
+
+		if(glyph->sprite.tex == NULL) {
+			continue;
+		}
+
+		Sprite *spr = &glyph->sprite;
+		FloatOffset ofs = spr->padding.offset;
+		FloatExtent imgdims = spr->extent;
+		imgdims.as_cmplx -= spr->padding.extent.as_cmplx;
+
+		float g_x = x + glyph->metrics.bearing_x + spr->w * 0.5f + ofs.x;
+		float g_y = y - glyph->metrics.bearing_y + spr->h * 0.5f - font->metrics.descent + ofs.y;
+
+		*dynarray_append(&layout->glyphs) = (TextLayoutGlyph) {
+			.tex = spr->tex,
+			.texrect = spr->tex_area,
+			.dims = imgdims,
+			.pos = { g_x, g_y },
+			.tex_ofs = { g_x - imgdims.w * 0.5f, g_y * texmat_offset_sign - imgdims.h * 0.5f },
+			.charcode = uchar,
+		};
+	}
+
+	layout->width = c.x / font->metrics.scale;
+}
+
+attr_nonnull(1, 2)
+static float text_layout_draw_internal(TextLayout *layout, const TextParams *params) {
+	Font *font = layout->font;
 	SpriteStateParams batch_state_params;
 
 	memcpy(batch_state_params.aux_textures, params->aux_textures, sizeof(batch_state_params.aux_textures));
@@ -1144,21 +1733,17 @@ static float _text_ucs4_draw(Font *font, const uint32_t *ucs4text, const TextPar
 
 	batch_state_params.primary_texture = NULL;
 
-	TextBBox bbox;
-	float y = params->pos.y;
+	// Shaders that can handle distance field fonts declare this; see shader/lib/text.glslh
+	Uniform *sdf_uniform = r_shader_uniform(batch_state_params.shader, "glyph_sdf");
+
 	float scale = font->metrics.scale;
 	float iscale = 1.0f / scale;
 
-	Cursor c = cursor_init(font);
-	c.x = params->pos.x;
-
 	struct {
 		struct { float min, max; } x, y;
 		float w, h;
 	} overlay;
 
-	text_ucs4_bbox(font, ucs4text, 0, &bbox);
-
 	Color color;
 
 	if(params->color == NULL) {
@@ -1182,26 +1767,20 @@ static float _text_ucs4_draw(Font *font, const uint32_t *ucs4text, const TextPar
 	r_mat_tex_current(mat_texture);
 	r_mat_mv_current(mat_model);
 
-	glm_translate(mat_model, (vec3) { c.x, y } );
+	glm_translate(mat_model, (vec3) { params->pos.x, params->pos.y } );
 	glm_scale(mat_model, (vec3) { iscale, iscale, 1 } );
 
-	float orig_x = c.x;
-	float orig_y = y;
-	c.x = y = 0;
-
-	adjust_xpos(font, ucs4text, params->align, 0, &c.x);
-
 	if(params->overlay_projection) {
 		FloatRect *op = params->overlay_projection;
-		overlay.x.min = (op->x - orig_x) * scale;
+		overlay.x.min = (op->x - params->pos.x) * scale;
 		overlay.x.max = overlay.x.min + op->w * scale;
-		overlay.y.min = (op->y - orig_y) * scale;
+		overlay.y.min = (op->y - params->pos.y) * scale;
 		overlay.y.max = overlay.y.min + op->h * scale;
 	} else {
-		overlay.x.min = bbox.x.min + c.x;
-		overlay.x.max = bbox.x.max + c.x;
-		overlay.y.min = bbox.y.min - font->metrics.descent;
-		overlay.y.max = bbox.y.max - font->metrics.descent;
+		overlay.x.min = layout->bbox.x.min + layout->xofs;
+		overlay.x.max = layout->bbox.x.max + layout->xofs;
+		overlay.y.min = layout->bbox.y.min - font->metrics.descent;
+		overlay.y.max = layout->bbox.y.max - font->metrics.descent;
 	}
 
 	overlay.w = overlay.x.max - overlay.x.min;
@@ -1210,77 +1789,51 @@ static float _text_ucs4_draw(Font *font, const uint32_t *ucs4text, const TextPar
 	glm_scale(mat_texture, (vec3) { 1/overlay.w, 1/overlay.h, 1.0 });
 	glm_translate(mat_texture, (vec3) { -overlay.x.min, overlay.y.min, 0 });
 
-	// FIXME: is there a better way?
-	float texmat_offset_sign;
-
-	if(r_supports(RFEAT_TEXTURE_BOTTOMLEFT_ORIGIN)) {
-		texmat_offset_sign = -1;
-	} else {
-		texmat_offset_sign = 1;
-	}
-
-	const uint32_t *tptr = ucs4text;
-
-	while(*tptr) {
-		uint32_t uchar = *tptr++;
-
-		if(uchar == '\n') {
-			cursor_reset(&c);
-			adjust_xpos(font, tptr, params->align, 0, &c.x);
-			y += font->metrics.lineskip;
-			continue;
-		}
-
-		Glyph *glyph = get_glyph(font, uchar);
-
-		if(glyph == NULL) {
-			continue;
-		}
-
-		float x = cursor_advance(&c, glyph);
-
-		if(glyph->sprite.tex == NULL) {
-			continue;
+	dynarray_foreach_elem(&layout->glyphs, TextLayoutGlyph *g, {
+		if(set_batch_texture(&batch_state_params, g->tex)) {
+			// Pending sprites are flushed on texture changes, and a spritesheet is either
+			// regular or distance field, so this can't affect anything already batched.
+			r_uniform_float(sdf_uniform, font->sdf);
 		}
 
-		Sprite *spr = &glyph->sprite;
-		set_batch_texture(&batch_state_params, spr->tex);
-
 		SpriteInstanceAttribs attribs;
 		attribs.rgba = color;
 		attribs.custom = shader_params;
 
-		FloatOffset ofs = spr->padding.offset;
-		FloatExtent imgdims = spr->extent;
-		imgdims.as_cmplx -= spr->padding.extent.as_cmplx;
-
-		float g_x = x + glyph->metrics.bearing_x + spr->w * 0.5f + ofs.x;
-		float g_y = y - glyph->metrics.bearing_y + spr->h * 0.5f - font->metrics.descent + ofs.y;
-
 		glm_translate_to(mat_texture, (vec3) {
-			g_x - imgdims.w * 0.5f,
-			g_y * texmat_offset_sign + overlay.h - imgdims.h * 0.5f
+			g->tex_ofs.x,
+			g->tex_ofs.y + overlay.h,
 		}, attribs.tex_transform);
-		glm_scale(attribs.tex_transform, (vec3) { imgdims.w, imgdims.h, 1.0 });
+		glm_scale(attribs.tex_transform, (vec3) { g->dims.w, g->dims.h, 1.0 });
 
-		glm_translate_to(mat_model, (vec3) { g_x, g_y }, attribs.mv_transform);
-		glm_scale(attribs.mv_transform, (vec3) { imgdims.w, imgdims.h, 1.0 } );
+		glm_translate_to(mat_model, (vec3) { g->pos.x, g->pos.y }, attribs.mv_transform);
+		glm_scale(attribs.mv_transform, (vec3) { g->dims.w, g->dims.h, 1.0 } );
 
-		attribs.texrect = spr->tex_area;
+		attribs.texrect = g->texrect;
 
 		// NOTE: Glyphs have their sprite w/h unadjusted for scale.
-		attribs.sprite_size.w = imgdims.w * iscale;
-		attribs.sprite_size.h = imgdims.h * iscale;
+		attribs.sprite_size.w = g->dims.w * iscale;
+		attribs.sprite_size.h = g->dims.h * iscale;
 
 		if(params->glyph_callback.func != NULL) {
 			params->glyph_callback.func(
-				font, uchar, &attribs, params->glyph_callback.userdata);
+				font, g->charcode, &attribs, params->glyph_callback.userdata);
 		}
 
 		r_sprite_batch_add_instance(&attribs);
+	});
+
+	return layout->width;
+}
+
+attr_nonnull(1, 2, 3)
+static float _text_ucs4_draw(Font *font, const uint32_t *ucs4text, const TextParams *params) {
+	if(globals.scratch_layout == NULL) {
+		globals.scratch_layout = text_layout_new();
 	}
 
-	return c.x * iscale;
+	text_layout_build(globals.scratch_layout, font, ucs4text, params->align);
+	return text_layout_draw_internal(globals.scratch_layout, params);
 }
 
 static float _text_draw(Font *font, const char *text, const TextParams *params) {
@@ -1318,6 +1871,32 @@ float text_draw_wrapped(const char *text, float max_width, const TextParams *par
 	return _text_draw(font, buf, params);
 }
 
+float text_layout_draw(TextLayout *layout, const char *text, const TextParams *params) {
+	Font *font = font_from_params(params);
+
+	if(
+		layout->font != font ||
+		layout->font_generation != font->generation ||
+		layout->align != params->align ||
+		layout->max_width != params->max_width ||
+		layout->text == NULL ||
+		strcmp(layout->text, text)
+	) {
+		uint32_t buf[strlen(text) + 1];
+		utf8_to_ucs4(text, ARRAY_SIZE(buf), buf);
+
+		if(params->max_width > 0) {
+			text_ucs4_shorten(font, buf, params->max_width);
+		}
+
+		text_layout_build(layout, font, buf, params->align);
+		layout->max_width = params->max_width;
+		stralloc(&layout->text, text);
+	}
+
+	return text_layout_draw_internal(layout, params);
+}
+
 void text_render(const char *text, Font *font, Sprite *out_sprite, TextBBox *out_bbox) {
 	text_bbox(font, text, 0, out_bbox);
 
@@ -1502,8 +2081,10 @@ const GlyphMetrics *font_get_char_metrics(Font *font, charcode_t c) {
 static bool transfer_font(void *dst, void *src) {
 	auto dfont = CASTPTR_ASSUME_ALIGNED(dst, Font);
 	auto sfont = CASTPTR_ASSUME_ALIGNED(src, Font);
+	uint generation = dfont->generation;
 	free_font_resources(dfont);
 	*dfont = *sfont;
+	dfont->generation = generation + 1;
 	mem_free(sfont);
 	return true;
 }
@@ -97,6 +97,22 @@ float text_ucs4_draw(const uint32_t *text, const TextParams *params) attr_nonnul
 
 float text_draw_wrapped(const char *text, float max_width, const TextParams *params) attr_nonnull(1, 3);
 
+/*
+ * A TextLayout caches the glyph run of a string: UTF-8 decoding, glyph lookup, kerning,
+ * alignment and shortening to max_width. Drawing it again only composes the cached glyph
+ * quads with the current transform, position, color and shader. It's meant for text that
+ * rarely changes, such as menu labels.
+ *
+ * text_layout_draw() works like text_draw(), but reuses the layout if the text, font,
+ * alignment and max_width are the same as in the previous call, and the font's glyph cache
+ * hasn't been invalidated since (e.g. by a reload or a resolution change).
+ */
+typedef struct TextLayout TextLayout;
+
+TextLayout *text_layout_new(void) attr_returns_allocated;
+void text_layout_free(TextLayout *layout);
+float text_layout_draw(TextLayout *layout, const char *text, const TextParams *params) attr_nonnull(1, 2, 3);
+
 void text_render(const char *text, Font *font, Sprite *out_sprite, TextBBox *out_bbox) attr_nonnull(1, 2, 3, 4);
 
 void text_ucs4_shorten(Font *font, uint32_t *text, float width) attr_nonnull(1, 2);
@@ -123,6 +139,10 @@ bool font_get_kerning_available(Font *font) attr_nonnull(1);
 bool font_get_kerning_enabled(Font *font) attr_nonnull(1);
 void font_set_kerning_enabled(Font *font, bool newval) attr_nonnull(1);
 
+// Direct-mapped glyph lookup tables for common code points are enabled by default.
+// Disabling them is only useful for benchmarking; see font_benchmark.h.
+void font_set_glyph_table_enabled(bool enabled);
+
 extern ResourceHandler font_res_handler;
 
 #define FONT_PATH_PREFIX "res/fonts/"
@@ -0,0 +1,97 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "font_benchmark.h"
+#include "font.h"
+
+#include "renderer/api.h"
+#include "util.h"
+
+static const char *const bench_fonts[] = {
+	"standard",
+	"small",
+	"monosmall",
+	"big",
+};
+
+static const struct {
+	const char *name;
+	const char *text;
+} bench_samples[] = {
+	{ "numbers", "123,456,789,000 9.99 x1.00 +1000 GRAZE 1337" },
+	{ "dialog",  "I'm not going to let you pass! You'll have to defeat me first, if you think you can." },
+	{ "kana",    "あいうえおかきくけこアイウエオカキクケコ、。" },
+};
+
+static uint64_t bench_draw(Font *font, const char *text, int iterations) {
+	TextParams params = {
+		.font_ptr = font,
+		.pos = { 0, 0 },
+	};
+
+	// Make sure all glyphs are loaded first
+	text_draw(text, &params);
+	r_flush_sprites();
+
+	uint64_t t = SDL_GetPerformanceCounter();
+
+	for(int i = 0; i < iterations; ++i) {
+		text_draw(text, &params);
+	}
+
+	r_flush_sprites();
+	return SDL_GetPerformanceCounter() - t;
+}
+
+static size_t utf8_len(const char *text) {
+	size_t len = 0;
+
+	while(utf8_getch(&text)) {
+		++len;
+	}
+
+	return len;
+}
+
+bool text_benchmark(int iterations) {
+	iterations = imax(1, iterations);
+	bool ok = true;
+
+	tsfprintf(stdout, "%d iteration(s) per string\n\n", iterations);
+	tsfprintf(stdout, "%-10s %-8s %17s %13s %8s\n", "Font", "Text", "Hashtable (c/ms)", "Table (c/ms)", "Speedup");
+
+	for(int f = 0; f < ARRAY_SIZE(bench_fonts); ++f) {
+		Font *font = res_font(bench_fonts[f]);
+
+		if(!font) {
+			log_error("Font %s not loaded", bench_fonts[f]);
+			ok = false;
+			continue;
+		}
+
+		for(int s = 0; s < ARRAY_SIZE(bench_samples); ++s) {
+			const char *text = bench_samples[s].text;
+			double chars = (double)utf8_len(text) * iterations;
+			double rate[2];
+
+			for(int table = 0; table < 2; ++table) {
+				font_set_glyph_table_enabled(table);
+				uint64_t t = bench_draw(font, text, iterations);
+				rate[table] = chars / (t * 1e3 / SDL_GetPerformanceFrequency());
+			}
+
+			tsfprintf(stdout, "%-10s %-8s %17.0f %13.0f %7.2fx\n",
+				bench_fonts[f], bench_samples[s].name, rate[0], rate[1], rate[1] / rate[0]);
+		}
+	}
+
+	font_set_glyph_table_enabled(true);
+	return ok;
+}
@@ -0,0 +1,15 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+// Measures text_draw() throughput for a few fonts and typical strings (HUD numbers, dialog,
+// kana), with and without the direct-mapped glyph tables. Requires an initialized renderer;
+// the text is drawn into the current framebuffer. Prints a report to stdout.
+bool text_benchmark(int iterations);
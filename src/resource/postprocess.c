@@ -33,6 +33,7 @@ static bool postprocess_load_callback(const char *key, const char *value, void *
 	if(!strcmp(key, "@shader")) {
 		current = ALLOC(PostprocessShader);
 		current->uniforms = NULL;
+		current->cost = PASS_COST_MODERATE;
 
 		// if loading this fails, get_resource will print a warning
 		current->shader = res_get_data(RES_SHADER_PROGRAM, value, ldata->resflags);
@@ -56,6 +57,18 @@ static bool postprocess_load_callback(const char *key, const char *value, void *
 		return true;
 	}
 
+	if(!strcmp(key, "@cost")) {
+		for(PassCost c = 0; c < NUM_PASS_COSTS; ++c) {
+			if(!strcmp(value, passtimer_cost_name(c))) {
+				current->cost = c;
+				return true;
+			}
+		}
+
+		log_error("Unknown pass cost class '%s'", value);
+		return true;
+	}
+
 	const char *name = key;
 	Uniform *uni = r_shader_uniform(current->shader, name);
 
@@ -164,6 +177,7 @@ static void* delete_uniform(List **dest, List *data, void *arg) {
 static void* delete_shader(List **dest, List *data, void *arg) {
 	PostprocessShader *ps = (PostprocessShader*)data;
 	list_foreach(&ps->uniforms, delete_uniform, NULL);
+	passtimer_destroy(&ps->timer);
 	mem_free(list_unlink(dest, data));
 	return NULL;
 }
@@ -201,6 +215,11 @@ void postprocess(PostprocessShader *ppshaders, FBPair *fbos, PostprocessPrepareF
 	for(PostprocessShader *pps = ppshaders; pps; pps = pps->next) {
 		ShaderProgram *s = pps->shader;
 
+		if(!pps->timer.registered) {
+			passtimer_init(&pps->timer, r_shader_program_get_debug_label(s), pps->cost);
+		}
+
+		passtimer_begin(&pps->timer);
 		r_framebuffer(fbos->back);
 		r_shader_ptr(s);
 
@@ -217,6 +236,7 @@ void postprocess(PostprocessShader *ppshaders, FBPair *fbos, PostprocessPrepareF
 		}
 
 		draw(fbos->front, width, height);
+		passtimer_end(&pps->timer);
 		fbpair_swap(fbos);
 	}
 
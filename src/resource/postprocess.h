@@ -13,6 +13,7 @@
 #include "shader_program.h"
 #include "renderer/api.h"
 #include "util/graphics.h"
+#include "util/passtimer.h"
 
 typedef struct PostprocessShader PostprocessShader;
 typedef struct PostprocessShaderUniform PostprocessShaderUniform;
@@ -23,6 +24,10 @@ struct PostprocessShader {
 
 	PostprocessShaderUniform *uniforms;
 	ShaderProgram *shader;
+
+	// Declared with the @cost key; defaults to PASS_COST_MODERATE.
+	PassCost cost;
+	PassTimer timer;
 };
 
 union PostprocessShaderUniformValue {
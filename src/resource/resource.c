@@ -151,6 +151,7 @@ struct InternalResLoadState {
 	InternalResource *ires;
 	Task *async_task;
 	ResourceLoadProc continuation;
+	ResourceLoadReadyProc continuation_ready;
 	LoadStatus status;
 	bool ready_to_finalize;
 };
@@ -460,6 +461,17 @@ void res_load_continue_on_main(ResourceLoadState *st, ResourceLoadProc callback,
 	lstate_set_status(ist, LOAD_CONT_ON_MAIN);
 	ist->st.opaque = opaque;
 	ist->continuation = callback;
+	ist->continuation_ready = NULL;
+}
+
+void res_load_continue_on_main_when_ready(
+	ResourceLoadState *st, ResourceLoadProc callback, void *opaque, ResourceLoadReadyProc ready
+) {
+	InternalResLoadState *ist = loadstate_internal(st);
+	lstate_set_status(ist, LOAD_CONT_ON_MAIN);
+	ist->st.opaque = opaque;
+	ist->continuation = callback;
+	ist->continuation_ready = ready;
 }
 
 void res_load_continue_after_dependencies(ResourceLoadState *st, ResourceLoadProc callback, void *opaque) {
@@ -467,6 +479,7 @@ void res_load_continue_after_dependencies(ResourceLoadState *st, ResourceLoadPro
 	lstate_set_status(ist, LOAD_CONT);
 	ist->st.opaque = opaque;
 	ist->continuation = callback;
+	ist->continuation_ready = NULL;
 }
 
 static uint32_t ires_make_dependent_one(InternalResource *ires, InternalResource *dep);
@@ -718,36 +731,40 @@ static void ires_unmake_dependent(InternalResource *ires, IResPtrArray *dependen
 	ires_unlock(ires);
 }
 
-SDL_RWops *res_open_file(ResourceLoadState *st, const char *path, VFSOpenMode mode) {
-	SDL_RWops *rw = vfs_open(path, mode);
-
-	if(UNLIKELY(!rw)) {
-		return NULL;
-	}
-
+void res_watch_file(ResourceLoadState *st, const char *path) {
 	InternalResLoadState *ist = loadstate_internal(st);
 	InternalResource *ires = ist->ires;
 	ResourceHandler *handler = get_ires_handler(ires);
 
 	if(!handler->procs.transfer) {
-		return rw;
+		return;
 	}
 
 	// FIXME: we probably need a better API to obtain the underlying syspath
 	char *syspath = vfs_repr(path, true);
 
 	if(syspath == NULL) {
-		return rw;
+		return;
 	}
 
 	FileWatch *w = filewatch_watch(syspath);
 	mem_free(syspath);
 
 	if(w == NULL) {
-		return rw;
+		return;
 	}
 
 	register_watched_path(ires, path, w);
+}
+
+SDL_RWops *res_open_file(ResourceLoadState *st, const char *path, VFSOpenMode mode) {
+	SDL_RWops *rw = vfs_open(path, mode);
+
+	if(UNLIKELY(!rw)) {
+		return NULL;
+	}
+
+	res_watch_file(st, path);
 	return rw;
 }
 
@@ -1169,6 +1186,22 @@ static bool should_defer_load(InternalResLoadState *st) {
 	return false;
 }
 
+// Runs main thread continuations until the load is complete, or one of them has to wait for
+// background work (see res_load_continue_on_main_when_ready). Returns false in the latter case.
+static bool pump_main_continuations(InternalResLoadState *st, bool *out_did_work) {
+	while(st->ires->status != RES_STATUS_FAILED && st->status == LOAD_CONT_ON_MAIN) {
+		if(st->continuation_ready && !st->continuation_ready(st->st.opaque)) {
+			return false;
+		}
+
+		lstate_set_status(st, LOAD_NONE);
+		PROTECT_FLAGS(st, st->continuation(&st->st));
+		*out_did_work = true;
+	}
+
+	return true;
+}
+
 static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
 	assert(thread_current_is_main());
 
@@ -1216,7 +1249,17 @@ static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
 	}
 
 	if(st) {
-		load_resource_finish(ires->load);
+		bool did_work = false;
+
+		if(!pump_main_continuations(st, &did_work)) {
+			LOAD_DBG("Deferring %s '%s' until background work completes", type_name(ires->res.type), st->st.name);
+			res_gstate.loaded_this_frame |= did_work;
+			ires_unlock(ires);
+			events_defer(evt);
+			return true;
+		}
+
+		load_resource_finish(st);
 		res_gstate.loaded_this_frame = true;
 	}
 
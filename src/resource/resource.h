@@ -58,6 +58,9 @@ typedef bool (*ResourceCheckProc)(const char *path);
 // Must call one of the following res_load_* functions before returning to indicate status.
 typedef void (*ResourceLoadProc)(ResourceLoadState *st);
 
+// Tells whether a continuation can run without waiting. Receives the continuation's opaque pointer.
+typedef bool (*ResourceLoadReadyProc)(void *opaque);
+
 // Makes `dst` refer to the resource represented by `src`.
 // `src` may no longer be a valid reference to the resource after this operation.
 // Resource previously represented by `dst` is destroyed in the process.
@@ -76,6 +79,13 @@ void res_load_finished(ResourceLoadState *st, void *res) attr_nonnull(1, 2);
 // If the resource has dependencies, callback will not be called until they finish loading.
 void res_load_continue_on_main(ResourceLoadState *st, ResourceLoadProc callback, void *opaque) attr_nonnull(1, 2);
 
+// Like res_load_continue_on_main, but for work that finishes in the background, e.g. in the driver.
+// Asynchronous loads will not invoke callback until ready returns true, polling it once per frame.
+// If the resource is needed immediately, callback is invoked anyway and must wait for the work.
+void res_load_continue_on_main_when_ready(
+	ResourceLoadState *st, ResourceLoadProc callback, void *opaque, ResourceLoadReadyProc ready
+) attr_nonnull(1, 2, 4);
+
 // Like res_load_continue_on_main, but may be called from a worker thread.
 // Use this to wait for dependencies if nothing needs to be done on the main thread.
 void res_load_continue_after_dependencies(ResourceLoadState *st, ResourceLoadProc callback, void *opaque) attr_nonnull(1, 2);
@@ -90,6 +100,10 @@ void res_load_dependency(ResourceLoadState *st, ResourceType type, const char *n
 // Note that file monitoring support is not guaranteed.
 SDL_RWops *res_open_file(ResourceLoadState *st, const char *path, VFSOpenMode mode);
 
+// Like res_open_file(), but only registers the path, for files that are opened elsewhere.
+// Must be called by the load proc or a continuation, not by a task it has spawned.
+void res_watch_file(ResourceLoadState *st, const char *path);
+
 // Unloads a resource, freeing all allocated to it memory.
 typedef void (*ResourceUnloadProc)(void *res);
 
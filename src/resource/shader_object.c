@@ -61,12 +61,40 @@ static bool check_shader_object_path(const char *path) {
 
 static void load_shader_object_stage1(ResourceLoadState *st);
 static void load_shader_object_stage2(ResourceLoadState *st);
+static void load_shader_object_stage3(ResourceLoadState *st);
 
 static SDL_RWops *glsl_open_callback(const char *path, void *userdata) {
 	ResourceLoadState *st = userdata;
 	return res_open_file(st, path, VFS_MODE_READ);
 }
 
+static bool load_bundled_source(ResourceLoadState *st, ShaderStage stage, ShaderSource *out) {
+	if((st->flags & RESF_RELOAD) || !env_get("TAISEI_SHADER_BUNDLE", true)) {
+		// Reloads mean the source has been edited, and the bundle is out of date.
+		return false;
+	}
+
+	char *path = strjoin(SHOBJ_BUNDLE_PATH_PREFIX, r_backend_name(), "/", st->name, ".glsl", NULL);
+	bool result = false;
+
+	if(vfs_query(path).exists) {
+		GLSLSourceOptions opts = {
+			.version = { 330, GLSL_PROFILE_CORE },
+			.stage = stage,
+		};
+
+		result = glsl_load_source(path, out, &opts) && r_shader_language_supported(&out->lang, NULL);
+
+		if(!result) {
+			log_warn("%s: bundled source is unusable, ignoring", path);
+			shader_free_source(out);
+		}
+	}
+
+	mem_free(path);
+	return result;
+}
+
 static void load_shader_object_stage1(ResourceLoadState *st) {
 	struct shobj_type *type = get_shobj_type(st->path);
 
@@ -121,20 +149,25 @@ static void load_shader_object_stage1(ResourceLoadState *st) {
 			goto fail;
 		}
 
-		log_warn("%s: shading language not supported by backend, attempting to translate", st->path);
+		ShaderSource newsrc;
 
-		assert(r_shader_language_supported(&altlang, NULL));
+		if(load_bundled_source(st, type->stage, &newsrc)) {
+			log_debug("%s: using pre-translated source", st->path);
+		} else {
+			log_warn("%s: shading language not supported by backend, attempting to translate", st->path);
 
-		ShaderSource newsrc;
-		bool result = spirv_transpile(&ldata->source, &newsrc, &(SPIRVTranspileOptions) {
-			.lang = &altlang,
-			.optimization_level = SPIRV_OPTIMIZE_PERFORMANCE,
-			.filename = st->path,
-		});
+			assert(r_shader_language_supported(&altlang, NULL));
 
-		if(!result) {
-			log_error("%s: translation failed", st->path);
-			goto fail;
+			bool result = spirv_transpile(&ldata->source, &newsrc, &(SPIRVTranspileOptions) {
+				.lang = &altlang,
+				.optimization_level = SPIRV_OPTIMIZE_PERFORMANCE,
+				.filename = st->path,
+			});
+
+			if(!result) {
+				log_error("%s: translation failed", st->path);
+				goto fail;
+			}
 		}
 
 		shader_free_source(&ldata->source);
@@ -150,6 +183,10 @@ static void load_shader_object_stage1(ResourceLoadState *st) {
 	res_load_failed(st);
 }
 
+static bool shader_object_ready(void *shobj) {
+	return r_shader_object_ready(shobj);
+}
+
 static void load_shader_object_stage2(ResourceLoadState *st) {
 	struct shobj_load_data *ldata = NOT_NULL(st->opaque);
 
@@ -158,10 +195,22 @@ static void load_shader_object_stage2(ResourceLoadState *st) {
 	mem_free(ldata);
 
 	if(shobj) {
+		res_load_continue_on_main_when_ready(st, load_shader_object_stage3, shobj, shader_object_ready);
+	} else {
+		log_error("%s: failed to compile shader object", st->path);
+		res_load_failed(st);
+	}
+}
+
+static void load_shader_object_stage3(ResourceLoadState *st) {
+	ShaderObject *shobj = NOT_NULL(st->opaque);
+
+	if(r_shader_object_finish(shobj)) {
 		r_shader_object_set_debug_label(shobj, st->name);
 		res_load_finished(st, shobj);
 	} else {
 		log_error("%s: failed to compile shader object", st->path);
+		r_shader_object_destroy(shobj);
 		res_load_failed(st);
 	}
 }
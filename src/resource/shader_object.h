@@ -17,5 +17,8 @@ extern ResourceHandler shader_object_res_handler;
 
 #define SHOBJ_PATH_PREFIX "res/shader/"
 
+// Sources translated at build time, as <prefix><backend name>/<shader object name>.glsl
+#define SHOBJ_BUNDLE_PATH_PREFIX "res/shader-bundle/"
+
 DEFINE_RESOURCE_GETTER(ShaderObject, res_shader_object, RES_SHADER_OBJECT)
 DEFINE_OPTIONAL_RESOURCE_GETTER(ShaderObject, res_shader_object_optional, RES_SHADER_OBJECT)
@@ -27,6 +27,7 @@ struct shprog_load_data {
 
 static void load_shader_program_stage1(ResourceLoadState *st);
 static void load_shader_program_stage2(ResourceLoadState *st);
+static void load_shader_program_stage3(ResourceLoadState *st);
 
 static void load_shader_program_stage1(ResourceLoadState *st) {
 	struct shprog_load_data ldata;
@@ -81,6 +82,10 @@ static void load_shader_program_stage1(ResourceLoadState *st) {
 	}
 }
 
+static bool shader_program_ready(void *prog) {
+	return r_shader_program_ready(prog);
+}
+
 static void load_shader_program_stage2(ResourceLoadState *st) {
 	struct shprog_load_data ldata = *(struct shprog_load_data*)NOT_NULL(st->opaque);
 	mem_free(st->opaque);
@@ -103,10 +108,22 @@ static void load_shader_program_stage2(ResourceLoadState *st) {
 	ShaderProgram *prog = r_shader_program_link(ldata.num_objects, objs);
 
 	if(prog) {
+		res_load_continue_on_main_when_ready(st, load_shader_program_stage3, prog, shader_program_ready);
+	} else {
+		log_error("%s: couldn't link shader program", st->path);
+		res_load_failed(st);
+	}
+}
+
+static void load_shader_program_stage3(ResourceLoadState *st) {
+	ShaderProgram *prog = NOT_NULL(st->opaque);
+
+	if(r_shader_program_finish(prog)) {
 		r_shader_program_set_debug_label(prog, st->name);
 		res_load_finished(st, prog);
 	} else {
 		log_error("%s: couldn't link shader program", st->path);
+		r_shader_program_destroy(prog);
 		res_load_failed(st);
 	}
 }
@@ -10,6 +10,7 @@
 
 #include "texture_loader.h"
 #include "basisu.h"
+#include "taskmanager.h"
 
 void texture_loader_cleanup_stage1(TextureLoadData *ld) {
 	mem_free(ld->src_paths.main);
@@ -461,47 +462,143 @@ static bool texture_loader_infer_sources_cubemap(TextureLoadData *ld) {
 	return true;
 }
 
-static bool load_pixmap(
-	TextureLoadData *ld, const char *path, Pixmap *dst, PixmapFormat preferred_format
+/*
+ * Texture images (the main image and its alphamap, or the faces of a cubemap) are decoded
+ * concurrently, one task per image. Each task opens its own file: streams must be read on the
+ * thread that opened them. The task that finishes last runs the post-decode step, and the load
+ * continues on the main thread once all of them are done, so no worker is kept waiting.
+ */
+
+#define TEXTURE_DECODE_MAX_IMAGES 6
+
+typedef struct TextureDecodeJob TextureDecodeJob;
+
+typedef struct TextureDecodeImage {
+	TextureDecodeJob *job;
+	Task *task;
+	const char *path;
+	const char *what;
+	Pixmap *dst;
+	PixmapFormat preferred_format;
+	bool ok;
+} TextureDecodeImage;
+
+struct TextureDecodeJob {
+	TextureLoadData *ld;
+	bool (*finish)(TextureLoadData *ld);
+	TextureDecodeImage images[TEXTURE_DECODE_MAX_IMAGES];
+	uint num_images;
+	SDL_atomic_t remaining;
+	bool ok;
+};
+
+static void texture_decode_job_add(
+	TextureDecodeJob *job, const char *path, const char *what, Pixmap *dst, PixmapFormat preferred_format
 ) {
-	SDL_RWops *stream = res_open_file(ld->st, path, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+	assert(job->num_images < ARRAY_SIZE(job->images));
+
+	job->images[job->num_images++] = (TextureDecodeImage) {
+		.job = job,
+		.path = path,
+		.what = what,
+		.dst = dst,
+		.preferred_format = preferred_format,
+	};
 
-	if(UNLIKELY(!stream)) {
-		log_error("VFS error: %s", vfs_get_error());
-		return false;
+	// Register the file for hot-reloading here; the decode tasks only open it.
+	res_watch_file(job->ld->st, path);
+}
+
+static void *texture_decode_task(void *arg) {
+	TextureDecodeImage *img = arg;
+	TextureDecodeJob *job = img->job;
+
+	img->ok = pixmap_load_file(img->path, img->dst, img->preferred_format);
+
+	if(!SDL_AtomicDecRef(&job->remaining)) {
+		return NULL;
+	}
+
+	// This was the last image; the others are done.
+	bool ok = true;
+
+	for(uint i = 0; i < job->num_images; ++i) {
+		if(!job->images[i].ok) {
+			log_error("%s: Couldn't load %s %s", job->ld->st->name, job->images[i].what, job->images[i].path);
+			ok = false;
+		}
 	}
 
-	bool result = pixmap_load_stream(stream, PIXMAP_FILEFORMAT_AUTO, dst, preferred_format);
-	SDL_RWclose(stream);
-	return result;
+	job->ok = ok && job->finish(job->ld);
+	return NULL;
 }
 
-static void texture_loader_cubemap_from_pixmaps(TextureLoadData *ld) {
-	ResourceLoadState *st = ld->st;
+static bool texture_decode_ready(void *opaque) {
+	TextureDecodeJob *job = opaque;
 
-	static_assert(sizeof(*ld->cubemaps)/sizeof(*ld->pixmaps) == ARRAY_SIZE(ld->src_paths.cubemap));
-	const int nsides = sizeof(*ld->cubemaps)/sizeof(*ld->pixmaps);
-	ld->num_pixmaps = nsides;
-	ld->cubemaps = ALLOC_ARRAY(1, typeof(*ld->cubemaps));
+	for(uint i = 0; i < job->num_images; ++i) {
+		Task *t = job->images[i].task;
+
+		if(t && task_status(t) != TASK_FINISHED) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void texture_decode_done(ResourceLoadState *st) {
+	TextureDecodeJob *job = NOT_NULL(st->opaque);
+	TextureLoadData *ld = job->ld;
+
+	for(uint i = 0; i < job->num_images; ++i) {
+		Task *t = job->images[i].task;
+
+		// Only blocks if the texture is needed right away; see res_load_continue_on_main_when_ready.
+		if(t && !task_finish(t, NULL)) {
+			log_fatal("Internal error: texture decode task failed");
+		}
+	}
+
+	bool ok = job->ok;
+	mem_free(job);
+
+	if(ok) {
+		texture_loader_continue(ld);
+	} else {
+		texture_loader_failed(ld);
+	}
+}
+
+static void texture_decode_job_submit(TextureDecodeJob *job) {
+	SDL_AtomicSet(&job->remaining, job->num_images);
+
+	for(uint i = 0; i < job->num_images; ++i) {
+		TextureDecodeImage *img = job->images + i;
+		img->task = taskmgr_global_submit((TaskParams) { texture_decode_task, img });
+
+		if(UNLIKELY(!img->task)) {
+			texture_decode_task(img);
+		}
+	}
+
+	res_load_continue_on_main_when_ready(job->ld->st, texture_decode_done, job, texture_decode_ready);
+}
 
+static bool texture_loader_cubemap_decoded(TextureLoadData *ld) {
+	ResourceLoadState *st = ld->st;
+	const int nsides = ld->num_pixmaps;
 	Pixmap *ref = &ld->pixmaps[0];
 
 	for(CubemapFace i = 0; i < nsides; ++i) {
 		const char *src = ld->src_paths.cubemap[i];
 		Pixmap *px = ld->pixmaps + i;
 
-		if(!load_pixmap(ld, src, ld->pixmaps + i, ld->preferred_format)) {
-			log_error("%s: Couldn't load cubemap face %s", st->name, src);
-			texture_loader_failed(ld);
-			return;
-		}
-
 		if(px->width != px->height) {
 			log_error("%s: %s: Cubemap face is not square (%ux%u)",
 				st->name, src, px->width, px->height
 			);
-			texture_loader_failed(ld);
-			return;
+			return false;
 		}
 
 		if(px == ref) {
@@ -510,8 +607,7 @@ static void texture_loader_cubemap_from_pixmaps(TextureLoadData *ld) {
 			bool apply_format_ok = texture_loader_set_texture_type_uncompressed(ld, tex_type, px->format, px->origin, NULL);
 
 			if(!apply_format_ok) {
-				texture_loader_failed(ld);
-				return;
+				return false;
 			}
 
 			ld->params.width = px->width;
@@ -521,26 +617,68 @@ static void texture_loader_cubemap_from_pixmaps(TextureLoadData *ld) {
 				log_error("%s: %s: Inconsistent cubemap face size (this: %ux%u, previous: %ux%u)",
 					st->name, src, px->width, px->height, ref->width, ref->height
 				);
-				texture_loader_failed(ld);
-				return;
+				return false;
 			}
+		}
 
-			if(px->format != ref->format) {
-				log_warn("%s: %s: Cubemap face pixel format differs from first face",
-					st->name, src
-				);
-			}
+		if(!texture_loader_prepare_pixmaps(ld, px, NULL, ld->params.type, ld->params.flags)) {
+			return false;
 		}
 
-		if(!texture_loader_prepare_pixmaps(ld, ref, NULL, ld->params.type, ld->params.flags)) {
-			texture_loader_failed(ld);
-			return;
+		if(px->format != ref->format) {
+			log_warn("%s: %s: Cubemap face pixel format differs from first face",
+				st->name, src
+			);
 		}
 	}
 
 	memset(&ld->preprocess, 0, sizeof(ld->preprocess));
+	return true;
+}
 
-	texture_loader_continue(ld);
+static void texture_loader_cubemap_from_pixmaps(TextureLoadData *ld) {
+	static_assert(sizeof(*ld->cubemaps)/sizeof(*ld->pixmaps) == ARRAY_SIZE(ld->src_paths.cubemap));
+	const int nsides = sizeof(*ld->cubemaps)/sizeof(*ld->pixmaps);
+	static_assert(ARRAY_SIZE(ld->src_paths.cubemap) <= TEXTURE_DECODE_MAX_IMAGES);
+	ld->num_pixmaps = nsides;
+	ld->cubemaps = ALLOC_ARRAY(1, typeof(*ld->cubemaps));
+
+	auto job = ALLOC(TextureDecodeJob, {
+		.ld = ld,
+		.finish = texture_loader_cubemap_decoded,
+	});
+
+	for(CubemapFace i = 0; i < nsides; ++i) {
+		texture_decode_job_add(job, ld->src_paths.cubemap[i], "cubemap face", ld->pixmaps + i, ld->preferred_format);
+	}
+
+	texture_decode_job_submit(job);
+}
+
+static bool texture_loader_2d_decoded(TextureLoadData *ld) {
+	ld->preferred_format = ld->preferred_format ? ld->preferred_format : ld->pixmaps->format;
+	TextureType tex_type = r_texture_type_from_pixmap_format(ld->preferred_format);
+	bool apply_format_ok = texture_loader_set_texture_type_uncompressed(ld, tex_type, ld->pixmaps->format, ld->pixmaps->origin, NULL);
+
+	if(!apply_format_ok) {
+		return false;
+	}
+
+	if(!texture_loader_prepare_pixmaps(ld, ld->pixmaps, &ld->alphamap, ld->params.type, ld->params.flags)) {
+		return false;
+	}
+
+	if(ld->alphamap.data.untyped) {
+		ld->preprocess.apply_alphamap = true;
+	}
+
+	if(pixmap_format_layout(ld->preferred_format) != PIXMAP_LAYOUT_RGBA) {
+		ld->preprocess.multiply_alpha = false;
+	}
+
+	ld->params.width = ld->pixmaps->width;
+	ld->params.height = ld->pixmaps->height;
+	return true;
 }
 
 static void texture_loader_stage2(ResourceLoadState *st);
@@ -690,47 +828,24 @@ void texture_loader_stage1(ResourceLoadState *st) {
 	ld->num_pixmaps = 1;
 	ld->pixmaps = ALLOC_ARRAY(1, typeof(*ld->pixmaps));
 
-	if(!load_pixmap(ld, ld->src_paths.main, ld->pixmaps, ld->preferred_format)) {
-		log_error("%s: Couldn't load texture image %s", st->name, ld->src_paths.main);
-		texture_loader_failed(ld);
-		return;
-	}
-
-	if(
-		ld->src_paths.alphamap &&
-		!load_pixmap(ld, ld->src_paths.alphamap, &ld->alphamap, PIXMAP_FORMAT_R8)
-	) {
-		log_error("%s: Couldn't load texture alphamap %s", st->name, ld->src_paths.alphamap);
-		texture_loader_failed(ld);
-		return;
-	}
-
-	ld->preferred_format = ld->preferred_format ? ld->preferred_format : ld->pixmaps->format;
-	TextureType tex_type = r_texture_type_from_pixmap_format(ld->preferred_format);
-	bool apply_format_ok = texture_loader_set_texture_type_uncompressed(ld, tex_type, ld->pixmaps->format, ld->pixmaps->origin, NULL);
-
-	if(!apply_format_ok) {
-		texture_loader_failed(ld);
-		return;
-	}
+	auto job = ALLOC(TextureDecodeJob, {
+		.ld = ld,
+		.finish = texture_loader_2d_decoded,
+	});
 
-	if(!texture_loader_prepare_pixmaps(ld, ld->pixmaps, &ld->alphamap, ld->params.type, ld->params.flags)) {
-		texture_loader_failed(ld);
-		return;
-	}
+	texture_decode_job_add(job, ld->src_paths.main, "texture image", ld->pixmaps, ld->preferred_format);
 
-	if(ld->alphamap.data.untyped) {
-		ld->preprocess.apply_alphamap = true;
+	if(ld->src_paths.alphamap) {
+		texture_decode_job_add(job, ld->src_paths.alphamap, "texture alphamap", &ld->alphamap, PIXMAP_FORMAT_R8);
 	}
 
-	if(pixmap_format_layout(ld->preferred_format) != PIXMAP_LAYOUT_RGBA) {
-		ld->preprocess.multiply_alpha = false;
+	// texture_loader_continue() will run on the main thread, where it's too late to wait for
+	// dependencies. Request the shader here if preprocessing may turn out to be needed.
+	if(ld->preprocess.multiply_alpha || ld->src_paths.alphamap || want_srgb) {
+		res_load_dependency(st, RES_SHADER_PROGRAM, "texture_post_load");
 	}
 
-	ld->params.width = ld->pixmaps->width;
-	ld->params.height = ld->pixmaps->height;
-
-	texture_loader_continue(ld);
+	texture_decode_job_submit(job);
 }
 
 void texture_loader_continue(TextureLoadData *ld) {
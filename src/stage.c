@@ -26,7 +26,9 @@
 #include "stagetext.h"
 #include "stagedraw.h"
 #include "stageobjects.h"
+#include "stagesnapshot.h"
 #include "eventloop/eventloop.h"
+#include "gpuparticles.h"
 #include "common_tasks.h"
 #include "stageinfo.h"
 #include "dynstage.h"
@@ -37,6 +39,7 @@ typedef struct StageFrameState {
 	CallChain cc;
 	CoSched sched;
 	Replay *quicksave;
+	StageSnapshot *quicksave_snapshot;
 	bool quicksave_is_automatic;
 	bool quickload_requested;
 	bool was_skipping;
@@ -51,6 +54,9 @@ typedef struct StageFrameState {
 
 static StageFrameState *_current_stage_state;  // TODO remove this shitty hack
 
+// Frame to fast-forward to after the stage is restarted by a backwards replay seek
+static int pending_replay_seek = -1;
+
 #define BGM_FADE_LONG (2.0 * FADE_TIME / (double)FPS)
 #define BGM_FADE_SHORT (FADE_TIME / (double)FPS)
 
@@ -402,8 +408,13 @@ static void stage_do_quicksave(StageFrameState *fstate, bool isauto) {
 		mem_free(fstate->quicksave);
 	}
 
+	if(!fstate->quicksave_snapshot) {
+		fstate->quicksave_snapshot = ALLOC(StageSnapshot);
+	}
+
 	fstate->quicksave = create_quicksave_replay(global.replay.output.stage);
 	fstate->quicksave_is_automatic = isauto;
+	stage_snapshot_capture(fstate->quicksave_snapshot);
 }
 
 static void stage_do_quickload(StageFrameState *fstate) {
@@ -523,6 +534,16 @@ static void handle_replay_event(ReplayEvent *e, void *arg) {
 }
 
 static void leave_replay_mode(StageFrameState *fstate, ReplayState *rp_in) {
+	if(is_quickloading(fstate) && fstate->quicksave_snapshot) {
+		// The replay can't restore anything it didn't record, and it may have
+		// desynced (e.g. the stage code was hot-reloaded). Make sure the player
+		// gets back exactly what they had when they saved.
+		if(!stage_snapshot_verify(fstate->quicksave_snapshot)) {
+			log_warn("Quicksave state mismatch on frame %i, restoring from snapshot", global.frames);
+			stage_snapshot_restore(fstate->quicksave_snapshot);
+		}
+	}
+
 	replay_state_deinit(rp_in);
 }
 
@@ -717,6 +738,7 @@ static void stage_free(void) {
 	}
 
 	lasers_shutdown();
+	gpuparticles_shutdown();
 	projectiles_free();
 	stagetext_free();
 }
@@ -771,6 +793,7 @@ static void stage_preload(StageInfo *si, ResourceGroup *rg) {
 	items_preload(rg);
 	boss_preload(rg);
 	laserdraw_preload(rg);
+	gpuparticles_preload(rg);
 	enemies_preload(rg);
 
 	if(si->type != STAGE_SPELL) {
@@ -875,7 +898,12 @@ static void stage_replay_sync(StageFrameState *fstate) {
 			global.is_replay_verification &&
 			!global.replay.output.stage
 		) {
-			exit(1);
+			if(!global.is_replay_batch_verification) {
+				exit(1);
+			}
+
+			// Let the batch verifier move on to the next replay
+			global.gameover = GAMEOVER_ABORT;
 		}
 
 		if(fstate->quicksave && fstate->quicksave == global.replay.input.replay) {
@@ -1063,7 +1091,8 @@ TASK(stage_comain, { StageFrameState *fstate; }) {
 }
 
 static void _stage_enter(
-	StageInfo *stage, ResourceGroup *rg, CallChain next, Replay *quickload, bool quicksave_is_automatic
+	StageInfo *stage, ResourceGroup *rg, CallChain next,
+	Replay *quickload, StageSnapshot *quickload_snapshot, bool quicksave_is_automatic
 ) {
 	assert(stage);
 	assert(stage->procs);
@@ -1109,6 +1138,7 @@ static void _stage_enter(
 	stage_preload(stage, rg);
 	stage_draw_init();
 	lasers_init();
+	gpuparticles_init();
 
 	rng_make_active(&global.rand_game);
 	stage_start(stage);
@@ -1142,6 +1172,14 @@ static void _stage_enter(
 
 	rng_seed(&global.rand_game, seed);
 
+	if(global.replay.input.replay && pending_replay_seek >= 0) {
+		assert(!quickload);
+		log_debug("Seeking to frame %i", pending_replay_seek);
+		global.replay.input.play.skip_frames = pending_replay_seek;
+	}
+
+	pending_replay_seek = -1;
+
 	if(global.replay.input.replay) {
 		player_init(&global.plr);
 		replay_stage_sync_player_state(global.replay.input.stage, &global.plr);
@@ -1168,6 +1206,7 @@ static void _stage_enter(
 		.stage = stage,
 		.cc = next,
 		.quicksave = quickload,
+		.quicksave_snapshot = quickload_snapshot,
 		.quicksave_is_automatic = quicksave_is_automatic,
 		.desync_check_freq = env_get("TAISEI_REPLAY_DESYNC_CHECK_FREQUENCY", FPS * 5),
 		.dynstage_generation = dynstage_generation,
@@ -1192,7 +1231,7 @@ static void _stage_enter(
 }
 
 void stage_enter(StageInfo *stage, ResourceGroup *rg, CallChain next) {
-	_stage_enter(stage, rg, next, NULL, false);
+	_stage_enter(stage, rg, next, NULL, NULL, false);
 }
 
 void stage_end_loop(void *ctx) {
@@ -1202,6 +1241,7 @@ void stage_end_loop(void *ctx) {
 	recover_after_skip(s);
 
 	Replay *quicksave = s->quicksave;
+	StageSnapshot *quicksave_snapshot = s->quicksave_snapshot;
 	bool quicksave_is_automatic = s->quicksave_is_automatic;
 	bool is_quickload = s->quickload_requested;
 
@@ -1229,6 +1269,7 @@ void stage_end_loop(void *ctx) {
 	if(quicksave && !is_quickload) {
 		replay_reset(quicksave);
 		mem_free(quicksave);
+		mem_free(quicksave_snapshot);
 	}
 
 	s->stage->procs->end();
@@ -1256,7 +1297,7 @@ void stage_end_loop(void *ctx) {
 	mem_free(s);
 
 	if(is_quickload) {
-		_stage_enter(stginfo, rg, cc, quicksave, quicksave_is_automatic);
+		_stage_enter(stginfo, rg, cc, quicksave, quicksave_snapshot, quicksave_is_automatic);
 	} else {
 		demoplayer_resume();
 		run_call_chain(&cc, NULL);
@@ -1282,6 +1323,28 @@ float stage_get_view_shake_strength(void) {
 	return 0;
 }
 
+void stage_replay_seek(int frame) {
+	StageFrameState *fstate = NOT_NULL(_current_stage_state);
+	ReplayState *rp_in = &global.replay.input;
+
+	if(rp_in->mode != REPLAY_PLAY || is_quickloading(fstate)) {
+		return;
+	}
+
+	frame = imax(0, frame);
+
+	if(frame > global.frames) {
+		// Replays can only be simulated forward, so just fast-forward to the target.
+		rp_in->play.skip_frames = frame - global.frames;
+		audio_sfx_set_enabled(false);
+	} else if(frame < global.frames) {
+		// Going back requires replaying the stage from the beginning.
+		log_info("Rewinding replay to frame %i; re-simulating from the start of the stage", frame);
+		pending_replay_seek = frame;
+		global.gameover = GAMEOVER_RESTART;
+	}
+}
+
 void stage_load_quicksave(void) {
 	stage_do_quickload(NOT_NULL(_current_stage_state));
 }
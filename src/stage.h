@@ -65,6 +65,11 @@ float stage_get_view_shake_strength(void);
 
 void stage_load_quicksave(void);
 
+// Only valid while watching a replay. The stage can't be restored from a snapshot (see
+// stagesnapshot.h), so seeking backwards restarts it and re-simulates every frame up to the
+// target. The time this takes grows with the target frame.
+void stage_replay_seek(int frame);
+
 CoSched *stage_get_sched(void);
 
 bool stage_is_demo_mode(void);
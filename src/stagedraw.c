@@ -14,20 +14,75 @@
 #include "video.h"
 #include "resource/postprocess.h"
 #include "entity.h"
+#include "gpuparticles.h"
 #include "util/fbmgr.h"
+#include "util/passtimer.h"
 #include "replay/struct.h"
 
 #ifdef DEBUG
 	#define GRAPHS_DEFAULT 1
 	#define OBJPOOLSTATS_DEFAULT 0
+	#define GPUTIMERS_DEFAULT 1
 #else
 	#define GRAPHS_DEFAULT 0
 	#define OBJPOOLSTATS_DEFAULT 0
+	#define GPUTIMERS_DEFAULT 0
 #endif
 
 #define SPELL_INTRO_DURATION 120
 #define SPELL_INTRO_TIME_FACTOR 0.8
 
+// Adaptive background resolution: the background framebuffers are scaled between
+// ADAPTIVE_RES_MIN_SCALE and 1 times their scale_best size, so that the measured GPU time
+// of the stage passes stays within the budget. Only active at the highest postprocessing
+// setting.
+
+// Default GPU time budget for the measured passes, in milliseconds
+#define ADAPTIVE_RES_DEFAULT_BUDGET 10.0
+
+// Lowest size of the background framebuffers, as a fraction of scale_best. Also applies
+// to framebuffers without a scale range (scale_worst == scale_best).
+#define ADAPTIVE_RES_MIN_SCALE 0.5
+
+// Number of discrete quality levels above the lowest one; each change reallocates
+// the background framebuffers, so we don't want to do it continuously.
+#define ADAPTIVE_RES_STEPS 4
+
+// Minimum number of rendered frames between changes
+#define ADAPTIVE_RES_COOLDOWN 60
+
+// Only scale up if the prediction leaves this much of the budget unused
+#define ADAPTIVE_RES_UPSCALE_HEADROOM 0.8
+
+typedef enum StagePass {
+	STAGE_PASS_BG_SCENE,
+	STAGE_PASS_BG_DEPTHSYNC,
+	STAGE_PASS_BG_SHADERS,
+	STAGE_PASS_BG_FXAA,
+	STAGE_PASS_SPELLBG,
+	STAGE_PASS_BOSS_DISTORTION,
+	STAGE_PASS_POWERSURGE,
+	STAGE_PASS_OBJECTS,
+	STAGE_PASS_POSTPROCESS,
+	NUM_STAGE_PASSES,
+} StagePass;
+
+static const struct {
+	const char *name;
+	PassCost cost;
+	bool background;  // renders into a background framebuffer
+} stage_passes[NUM_STAGE_PASSES] = {
+	[STAGE_PASS_BG_SCENE]        = { "BG scene",        PASS_COST_EXPENSIVE, true  },
+	[STAGE_PASS_BG_DEPTHSYNC]    = { "BG depth sync",   PASS_COST_CHEAP,     true  },
+	[STAGE_PASS_BG_SHADERS]      = { "BG shaders",      PASS_COST_EXPENSIVE, true  },
+	[STAGE_PASS_BG_FXAA]         = { "BG FXAA",         PASS_COST_MODERATE,  true  },
+	[STAGE_PASS_SPELLBG]         = { "Spell BG",        PASS_COST_EXPENSIVE, true  },
+	[STAGE_PASS_BOSS_DISTORTION] = { "Boss distortion", PASS_COST_MODERATE,  true  },
+	[STAGE_PASS_POWERSURGE]      = { "Powersurge",      PASS_COST_MODERATE,  true  },
+	[STAGE_PASS_OBJECTS]         = { "Objects",         PASS_COST_MODERATE,  false },
+	[STAGE_PASS_POSTPROCESS]     = { "Stage postfx",    PASS_COST_EXPENSIVE, false },
+};
+
 static struct {
 	struct {
 		ShaderProgram *shader;
@@ -62,8 +117,17 @@ static struct {
 		float target_alpha;
 	} clear_screen;
 
+	struct {
+		PassTimer timers[NUM_STAGE_PASSES];
+		double budget;
+		float quality;  // see adaptive_res_scale()
+		int cooldown;
+		bool enabled;
+	} adaptive_res;
+
 	bool framerate_graphs;
 	bool objpool_stats;
+	bool gpu_timers;
 
 	#ifdef DEBUG
 		Sprite dummy;
@@ -88,6 +152,11 @@ static double fb_scale(void) {
 	return (double)vp_height / SCREEN_H;
 }
 
+static double adaptive_res_scale(float quality) {
+	// Size of the background framebuffers at the given quality, relative to scale_best
+	return lerp(ADAPTIVE_RES_MIN_SCALE, 1, quality);
+}
+
 static void set_fb_size(StageFBPair fb_id, int *w, int *h, float scale_worst, float scale_best) {
 	double scale = fb_scale();
 
@@ -97,9 +166,11 @@ static void set_fb_size(StageFBPair fb_id, int *w, int *h, float scale_worst, fl
 
 	int pp_qual = config_get_int(CONFIG_POSTPROCESS);
 
-	// We might lerp between these in the future
 	if(pp_qual < 2) {
 		scale *= scale_worst;
+	} else if(fb_id == FBPAIR_BG || fb_id == FBPAIR_BG_AUX) {
+		// see stage_draw_update_adaptive_res()
+		scale *= scale_best * adaptive_res_scale(stagedraw.adaptive_res.quality);
 	} else {
 		scale *= scale_best;
 	}
@@ -318,6 +389,7 @@ void stage_draw_preload(ResourceGroup *rg) {
 
 	stagedraw.framerate_graphs = env_get("TAISEI_FRAMERATE_GRAPHS", GRAPHS_DEFAULT);
 	stagedraw.objpool_stats = env_get("TAISEI_OBJPOOL_STATS", OBJPOOLSTATS_DEFAULT);
+	stagedraw.gpu_timers = env_get("TAISEI_GPU_TIMERS", GPUTIMERS_DEFAULT);
 
 	if(stagedraw.framerate_graphs) {
 		res_group_preload(rg, RES_SHADER_PROGRAM, RESF_DEFAULT,
@@ -325,7 +397,7 @@ void stage_draw_preload(ResourceGroup *rg) {
 		NULL);
 	}
 
-	if(stagedraw.objpool_stats) {
+	if(stagedraw.objpool_stats || stagedraw.gpu_timers) {
 		res_group_preload(rg, RES_FONT, RESF_DEFAULT,
 			"monotiny",
 		NULL);
@@ -348,6 +420,20 @@ void stage_draw_init(void) {
 	stagedraw.dummy.h = 1;
 	#endif
 
+	stagedraw.adaptive_res.quality = 1;
+	stagedraw.adaptive_res.cooldown = ADAPTIVE_RES_COOLDOWN;
+	stagedraw.adaptive_res.budget = env_get("TAISEI_ADAPTIVE_RES_BUDGET", ADAPTIVE_RES_DEFAULT_BUDGET);
+	stagedraw.adaptive_res.enabled = (
+		env_get("TAISEI_ADAPTIVE_RES", true) &&
+		r_supports(RFEAT_TIMER_QUERY)
+	);
+
+	for(StagePass p = 0; p < NUM_STAGE_PASSES; ++p) {
+		passtimer_init(&stagedraw.adaptive_res.timers[p], stage_passes[p].name, stage_passes[p].cost);
+	}
+
+	passtimers_set_enabled(stagedraw.adaptive_res.enabled || stagedraw.gpu_timers);
+
 	stage_draw_setup_framebuffers();
 
 	stagedraw.clear_screen.alpha = 0;
@@ -364,6 +450,12 @@ void stage_draw_shutdown(void) {
 	COEVENT_CANCEL_ARRAY(stagedraw.events);
 	events_unregister_handler(stage_draw_event);
 	stage_draw_destroy_framebuffers();
+
+	for(StagePass p = 0; p < NUM_STAGE_PASSES; ++p) {
+		passtimer_destroy(&stagedraw.adaptive_res.timers[p]);
+	}
+
+	passtimers_set_enabled(false);
 }
 
 FBPair *stage_get_fbpair(StageFBPair id) {
@@ -375,6 +467,14 @@ FBPair *stage_get_postprocess_fbpair(void) {
 	return NOT_NULL(stagedraw.current_postprocess_fbpair);
 }
 
+static void stage_pass_begin(StagePass pass) {
+	passtimer_begin(&stagedraw.adaptive_res.timers[pass]);
+}
+
+static void stage_pass_end(StagePass pass) {
+	passtimer_end(&stagedraw.adaptive_res.timers[pass]);
+}
+
 static void stage_draw_collision_areas(void) {
 #ifdef DEBUG
 	static bool enabled, keystate_saved;
@@ -733,16 +833,25 @@ static void apply_bg_shaders(ShaderRule *shaderrules, FBPair *fbos) {
 	r_blend(BLEND_NONE);
 
 	if(should_draw_stage_bg()) {
+		stage_pass_begin(STAGE_PASS_BG_DEPTHSYNC);
 		finish_3d_scene(fbos);
+		stage_pass_end(STAGE_PASS_BG_DEPTHSYNC);
+
+		stage_pass_begin(STAGE_PASS_BG_SHADERS);
 		apply_shader_rules(shaderrules, fbos);
+		stage_pass_end(STAGE_PASS_BG_SHADERS);
 
 		// anti-aliasing
 		if(config_get_int(CONFIG_FXAA)) {
+			stage_pass_begin(STAGE_PASS_BG_FXAA);
 			apply_shader_rules((ShaderRule[]) { fxaa_rule, NULL } , fbos);
+			stage_pass_end(STAGE_PASS_BG_FXAA);
 		}
 	}
 
 	if(b && b->current && b->current->draw_rule && b->current->starttime > 0) {
+		stage_pass_begin(STAGE_PASS_SPELLBG);
+
 		int t = global.frames - b->current->starttime;
 		int delay = attacktype_start_delay(b->current->type);
 
@@ -782,8 +891,12 @@ static void apply_bg_shaders(ShaderRule *shaderrules, FBPair *fbos) {
 			r_blend(BLEND_NONE);
 			fbpair_swap(fbos);
 		}
+
+		stage_pass_end(STAGE_PASS_SPELLBG);
 	} else {
+		stage_pass_begin(STAGE_PASS_BOSS_DISTORTION);
 		apply_shader_rules((ShaderRule[]) { boss_distortion_rule, NULL }, fbos);
+		stage_pass_end(STAGE_PASS_BOSS_DISTORTION);
 	}
 
 	r_state_pop();
@@ -796,10 +909,12 @@ static void stage_render_bg(StageInfo *stage) {
 	r_clear(BUFFER_ALL, RGBA(0, 0, 0, 1), 1);
 
 	if(should_draw_stage_bg()) {
+		stage_pass_begin(STAGE_PASS_BG_SCENE);
 		r_mat_mv_push();
 		r_enable(RCAP_DEPTH_TEST);
 		stage->procs->draw();
 		r_mat_mv_pop();
+		stage_pass_end(STAGE_PASS_BG_SCENE);
 		fbpair_swap(background);
 	}
 
@@ -810,6 +925,8 @@ static void stage_render_bg(StageInfo *stage) {
 
 	int pp = config_get_int(CONFIG_POSTPROCESS);
 
+	stage_pass_begin(STAGE_PASS_POWERSURGE);
+
 	if(pp > 1) {
 		draw_powersurge_effect(background->front, BLEND_PREMUL_ALPHA);
 	} else if(pp > 0) {
@@ -824,12 +941,18 @@ static void stage_render_bg(StageInfo *stage) {
 		draw_framebuffer_tex(staging, VIEWPORT_W, VIEWPORT_H);
 		r_state_pop();
 	}
+
+	stage_pass_end(STAGE_PASS_POWERSURGE);
 }
 
 bool stage_should_draw_particle(Projectile *p) {
 	return (p->flags & PFLAG_REQUIREDPARTICLE) || config_get_int(CONFIG_PARTICLES);
 }
 
+bool stage_should_draw_gpu_particles(GPUParticleBatch *batch) {
+	return (batch->flags & PFLAG_REQUIREDPARTICLE) || config_get_int(CONFIG_PARTICLES);
+}
+
 static bool stage_draw_predicate(EntityInterface *ent) {
 	if(ent->type == ENT_TYPE_ID(Projectile)) {
 		Projectile *p = ENT_CAST(ent, Projectile);
@@ -839,6 +962,10 @@ static bool stage_draw_predicate(EntityInterface *ent) {
 		}
 	}
 
+	if(ent->type == ENT_TYPE_ID(GPUParticleBatch)) {
+		return stage_should_draw_gpu_particles(ENT_CAST(ent, GPUParticleBatch));
+	}
+
 	return true;
 }
 
@@ -969,6 +1096,87 @@ void stage_draw_viewport(void) {
 	r_mat_mv_pop();
 }
 
+static void stage_draw_update_adaptive_res(void) {
+	auto ar = &stagedraw.adaptive_res;
+
+	passtimers_update();
+
+	if(!ar->enabled || config_get_int(CONFIG_POSTPROCESS) < 2) {
+		return;
+	}
+
+	if(ar->cooldown > 0) {
+		--ar->cooldown;
+		return;
+	}
+
+	// Split the measured GPU time by how it responds to the background resolution
+	double fixed = 0, linear = 0, quadratic = 0;
+	bool have_bg_data = false;
+
+	for(StagePass p = 0; p < NUM_STAGE_PASSES; ++p) {
+		PassTimer *t = ar->timers + p;
+
+		if(!t->have_data) {
+			continue;
+		}
+
+		if(!stage_passes[p].background) {
+			fixed += t->avg_msec;
+			continue;
+		}
+
+		have_bg_data = true;
+
+		switch(t->cost) {
+			case PASS_COST_CHEAP:     fixed     += t->avg_msec; break;
+			case PASS_COST_MODERATE:  linear    += t->avg_msec; break;
+			case PASS_COST_EXPENSIVE: quadratic += t->avg_msec; break;
+			default: UNREACHABLE;
+		}
+	}
+
+	if(!have_bg_data) {
+		return;
+	}
+
+	// Pick the highest quality level that is predicted to fit into the budget
+	double cur_scale = adaptive_res_scale(ar->quality);
+	float new_quality = 0;
+
+	for(int step = ADAPTIVE_RES_STEPS; step > 0; --step) {
+		float q = step / (float)ADAPTIVE_RES_STEPS;
+		double k = adaptive_res_scale(q) / cur_scale;
+		double predicted = fixed + linear * k + quadratic * k * k;
+		double budget = ar->budget;
+
+		if(q > ar->quality) {
+			budget *= ADAPTIVE_RES_UPSCALE_HEADROOM;
+		}
+
+		if(predicted <= budget) {
+			new_quality = q;
+			break;
+		}
+	}
+
+	if(new_quality == ar->quality) {
+		return;
+	}
+
+	log_debug("Background quality %.2f -> %.2f (%.2fms fixed, %.2fms linear, %.2fms quadratic; %.2fms budget)",
+		ar->quality, new_quality, fixed, linear, quadratic, ar->budget
+	);
+
+	ar->quality = new_quality;
+	ar->cooldown = ADAPTIVE_RES_COOLDOWN;
+	fbmgr_group_update(stagedraw.mfb_group);
+
+	for(StagePass p = 0; p < NUM_STAGE_PASSES; ++p) {
+		passtimer_reset(ar->timers + p);
+	}
+}
+
 void stage_draw_scene(StageInfo *stage) {
 #ifdef DEBUG
 	bool key_nobg = gamekeypressed(KEY_NOBACKGROUND);
@@ -1008,7 +1216,9 @@ void stage_draw_scene(StageInfo *stage) {
 	}
 
 	// draw the 2D objects
+	stage_pass_begin(STAGE_PASS_OBJECTS);
 	stage_draw_objects();
+	stage_pass_end(STAGE_PASS_OBJECTS);
 
 	end_viewport_shake();
 
@@ -1027,7 +1237,9 @@ void stage_draw_scene(StageInfo *stage) {
 	coevent_signal(&stagedraw.events.postprocess_after_overlay);
 
 	// stage postprocessing
+	stage_pass_begin(STAGE_PASS_POSTPROCESS);
 	apply_shader_rules(global.stage->procs->postprocess_rules, foreground);
+	stage_pass_end(STAGE_PASS_POSTPROCESS);
 
 	// custom postprocessing
 	postprocess(
@@ -1057,6 +1269,8 @@ void stage_draw_scene(StageInfo *stage) {
 
 	// draw "bottom text" (FPS, replay info, etc.)
 	stage_draw_bottom_text();
+
+	stage_draw_update_adaptive_res();
 }
 
 #define HUD_X_PADDING 16
@@ -1213,6 +1427,85 @@ static void stage_draw_hud_objpool_stats(float x, float y, float width) {
 	r_shader_ptr(sh_prev);
 }
 
+static float stage_draw_hud_gpu_timers(float x, float y, float width) {
+	char buf[128];
+	Font *font = res_font("monotiny");
+
+	ShaderProgram *sh_prev = r_shader_current();
+	r_shader("text_hud");
+
+	float lineskip = font_get_lineskip(font);
+
+	if(!r_supports(RFEAT_TIMER_QUERY)) {
+		text_draw("GPU timers not supported", &(TextParams) {
+			.pos = { x, y },
+			.font_ptr = font,
+			.align = ALIGN_LEFT,
+		});
+
+		r_shader_ptr(sh_prev);
+		return y + lineskip * 1.5;
+	}
+
+	snprintf(buf, sizeof(buf), "BG scale: %3.0f%%",
+		100 * adaptive_res_scale(stagedraw.adaptive_res.quality));
+
+	text_draw("GPU time:", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
+	y += lineskip * 1.5;
+	double total = 0;
+
+	for(PassTimer *t = passtimers_first(); t; t = t->next) {
+		if(!t->have_data) {
+			continue;
+		}
+
+		total += t->avg_msec;
+		snprintf(buf, sizeof(buf), "%c %6.3fms", toupper(*passtimer_cost_name(t->cost)), t->avg_msec);
+
+		text_draw(t->name, &(TextParams) {
+			.pos = { x, y },
+			.font_ptr = font,
+			.align = ALIGN_LEFT,
+		});
+
+		text_draw(buf, &(TextParams) {
+			.pos = { x + width, y },
+			.font_ptr = font,
+			.align = ALIGN_RIGHT,
+		});
+
+		y += lineskip;
+	}
+
+	snprintf(buf, sizeof(buf), "%6.3fms", total);
+
+	text_draw("Total", &(TextParams) {
+		.pos = { x, y },
+		.font_ptr = font,
+		.align = ALIGN_LEFT,
+	});
+
+	text_draw(buf, &(TextParams) {
+		.pos = { x + width, y },
+		.font_ptr = font,
+		.align = ALIGN_RIGHT,
+	});
+
+	r_shader_ptr(sh_prev);
+	return y + lineskip * 1.5;
+}
+
 struct labels_s {
 	struct {
 		float next_life;
@@ -1447,19 +1740,27 @@ static void stage_draw_hud_text(struct labels_s* labels) {
 		});
 	}
 
+	float debug_ypos = 440;
+
+	if(stagedraw.gpu_timers) {
+		debug_ypos = stage_draw_hud_gpu_timers(0, debug_ypos, HUD_EFFECTIVE_WIDTH);
+	}
+
 	if(stagedraw.objpool_stats) {
-		stage_draw_hud_objpool_stats(0, 440, HUD_EFFECTIVE_WIDTH);
+		stage_draw_hud_objpool_stats(0, debug_ypos, HUD_EFFECTIVE_WIDTH);
 	}
 }
 
 void stage_draw_bottom_text(void) {
-	char buf[64];
+	char buf[96];
 	Font *font;
 
 #ifdef DEBUG
-	snprintf(buf, sizeof(buf), "%.2f lfps, %.2f rfps, frames: %d (%d:%02d) ",
+	snprintf(buf, sizeof(buf), "%.2f lfps, %.2f rfps (p50 %.1f, p99 %.1f ms), frames: %d (%d:%02d) ",
 		global.fps.logic.fps,
 		global.fps.render.fps,
+		fpscounter_percentile(&global.fps.render, 0.50) / (double)(HRTIME_RESOLUTION / 1000),
+		fpscounter_percentile(&global.fps.render, 0.99) / (double)(HRTIME_RESOLUTION / 1000),
 		global.frames,
 		global.frames / 3600,
 		(global.frames % 3600) / 60
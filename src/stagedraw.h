@@ -43,6 +43,7 @@ void stage_draw_begin_noshake(void);
 void stage_draw_end_noshake(void);
 
 bool stage_should_draw_particle(Projectile *p);
+bool stage_should_draw_gpu_particles(GPUParticleBatch *batch);
 
 void stage_display_clear_screen(const StageClearBonus *bonus);
 
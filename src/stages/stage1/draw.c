@@ -13,6 +13,7 @@
 #include "stagedraw.h"
 #include "stageutils.h"
 #include "global.h"
+#include "gpuparticles.h"
 #include "util/glm.h"
 
 static Stage1DrawData *stage1_draw_data;
@@ -77,6 +78,11 @@ static bool reflect_draw_predicate(EntityInterface *ent) {
 			return false;
 		}
 
+		case ENT_TYPE_ID(GPUParticleBatch): {
+			GPUParticleBatch *batch = ENT_CAST(ent, GPUParticleBatch);
+			return !(batch->flags & PFLAG_NOREFLECT) && stage_should_draw_gpu_particles(batch);
+		}
+
 		default: return false;
 	}
 
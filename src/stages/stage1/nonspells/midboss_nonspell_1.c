@@ -130,7 +130,7 @@ DEFINE_EXTERN_TASK(stage1_midboss_nonspell_1) {
 		// play_sfx("shot_special1");
 
 		ENT_ARRAY_FOREACH(&snowflake_projs, Projectile *p, {
-			spawn_projectile_highlight_effect(p)->opacity = 0.25;
+			spawn_projectile_highlight_effect_ex(p, 0.25);
 			color_lerp(&p->color, RGB(0.5, 0.5, 0.5), 0.5);
 			p->move.velocity = 2 * cdir(p->angle);
 			p->move.acceleration = -cdir(p->angle) * difficulty_value(0.1, 0.15, 0.2, 0.2);
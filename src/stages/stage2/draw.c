@@ -143,8 +143,8 @@ static void stage2_bg_setup_pbr_env(Camera3D *cam, int max_lights, PBREnvironmen
 	env->disable_tonemap = true;
 }
 
-static void stage2_branch_mv_transform(vec3 pos) {
-	uint64_t seed = stage2_draw_data->branch_rng_seed ^ float_to_bits(pos[1]);
+static void stage2_branch_transform(vec3 origin, mat4 out) {
+	uint64_t seed = stage2_draw_data->branch_rng_seed ^ float_to_bits(origin[1]);
 
 #if 0
 	RandomState rng;
@@ -162,14 +162,33 @@ static void stage2_branch_mv_transform(vec3 pos) {
 	float r5 = RAND();
 	#undef RAND
 
-	pos[0] += 0.5f * r0 - 0.8f;
-	pos[1] += 0.4f * BRANCH_DIST * r1;
-	pos[2] += 0.6f * r2 - 0.25f;
+	vec3 pos = {
+		origin[0] + 0.5f * r0 - 0.8f,
+		origin[1] + 0.4f * BRANCH_DIST * r1,
+		origin[2] + 0.6f * r2 - 0.25f,
+	};
 
-	r_mat_mv_translate_v(pos);
-	r_mat_mv_rotate(r3 * M_PI/16,    1, 0, 0);
-	r_mat_mv_rotate(r4 * M_PI/8    , 0, 0, 1);
-	r_mat_mv_rotate(r5 * M_PI/16,    0, 1, 0);
+	glm_translate_make(out, pos);
+	glm_rotate(out, r3 * M_PI/16,    (vec3) { 1, 0, 0 });
+	glm_rotate(out, r4 * M_PI/8    , (vec3) { 0, 0, 1 });
+	glm_rotate(out, r5 * M_PI/16,    (vec3) { 0, 1, 0 });
+}
+
+static void stage2_branch_mv_transform(vec3 pos) {
+	mat4 m;
+	stage2_branch_transform(pos, m);
+	mat4 *mv = r_mat_mv_current_ptr();
+	glm_mul(*mv, m, *mv);
+}
+
+static void stage2_branch_set_instance_transforms(uint num, vec3 positions[num]) {
+	mat4 transforms[num];
+
+	for(uint i = 0; i < num; ++i) {
+		stage2_branch_transform(positions[i], transforms[i]);
+	}
+
+	pbr_set_instance_transforms(num, transforms);
 }
 
 static void stage2_bg_branch_draw(vec3 pos) {
@@ -189,6 +208,20 @@ static void stage2_bg_branch_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage2_bg_branch_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	stage2_branch_set_instance_transforms(num, pos);
+	r_shader("pbr_instanced");
+
+	PBREnvironment env = { 0 };
+	stage2_bg_setup_pbr_env(&stage_3d_context.cam, 1, &env);
+
+	pbr_draw_model_instanced(&stage2_draw_data->models.branch, &env);
+
+	r_state_pop();
+}
+
 static void stage2_bg_leaves_draw(vec3 pos) {
 	r_state_push();
 
@@ -206,6 +239,20 @@ static void stage2_bg_leaves_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage2_bg_leaves_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	stage2_branch_set_instance_transforms(num, pos);
+	r_shader("pbr_instanced_diffuse_alpha_discard");
+
+	PBREnvironment env = { 0 };
+	stage2_bg_setup_pbr_env(&stage_3d_context.cam, 1, &env);
+
+	pbr_draw_model_instanced(&stage2_draw_data->models.leaves, &env);
+
+	r_state_pop();
+}
+
 static void stage2_bg_ground_draw(vec3 pos) {
 	r_state_push();
 
@@ -223,6 +270,21 @@ static void stage2_bg_ground_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage2_bg_ground_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	pbr_set_instance_positions(num, pos);
+
+	r_blend(BLEND_NONE);
+	r_shader("pbr_instanced");
+	PBREnvironment env = { 0 };
+	stage2_bg_setup_pbr_env(&stage_3d_context.cam, STAGE2_MAX_LIGHTS, &env);
+
+	pbr_draw_model_instanced(&stage2_draw_data->models.ground, &env);
+
+	r_state_pop();
+}
+
 static void stage2_bg_ground_rocks_draw(vec3 pos) {
 	r_state_push();
 
@@ -240,6 +302,21 @@ static void stage2_bg_ground_rocks_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage2_bg_ground_rocks_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	pbr_set_instance_positions(num, pos);
+
+	r_blend(BLEND_NONE);
+	r_shader("pbr_instanced");
+	PBREnvironment env = { 0 };
+	stage2_bg_setup_pbr_env(&stage_3d_context.cam, STAGE2_MAX_LIGHTS, &env);
+
+	pbr_draw_model_instanced(&stage2_draw_data->models.rocks, &env);
+
+	r_state_pop();
+}
+
 static void stage2_bg_ground_grass_draw(vec3 pos) {
 	r_state_push();
 
@@ -258,6 +335,22 @@ static void stage2_bg_ground_grass_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage2_bg_ground_grass_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	pbr_set_instance_positions(num, pos);
+
+	r_blend(BLEND_PREMUL_ALPHA);
+	r_disable(RCAP_CULL_FACE);
+	r_shader("pbr_instanced_diffuse_alpha_discard");
+	PBREnvironment env = { 0 };
+	stage2_bg_setup_pbr_env(&stage_3d_context.cam, STAGE2_MAX_LIGHTS, &env);
+
+	pbr_draw_model_instanced(&stage2_draw_data->models.grass, &env);
+
+	r_state_pop();
+}
+
 static void stage2_bg_water_draw(vec3 pos) {
 	r_state_push();
 
@@ -446,13 +539,13 @@ static void stage3d_hinalights_draw(vec3 pos) {
 
 void stage2_draw(void) {
 	Stage3DSegment segs[] = {
-		{ stage2_bg_branch_draw, stage2_bg_branch_pos },
-		{ stage2_bg_ground_rocks_draw, stage2_bg_pos},
-		{ stage2_bg_ground_draw, stage2_bg_pos},
+		{ stage2_bg_branch_draw, stage2_bg_branch_pos, stage2_bg_branch_draw_instanced },
+		{ stage2_bg_ground_rocks_draw, stage2_bg_pos, stage2_bg_ground_rocks_draw_instanced },
+		{ stage2_bg_ground_draw, stage2_bg_pos, stage2_bg_ground_draw_instanced },
 		{ stage2_bg_water_draw, stage2_bg_water_pos},
 		{ stage2_bg_water_draw, stage2_bg_water_start_pos},
-		{ stage2_bg_leaves_draw, stage2_bg_branch_pos },
-		{ stage2_bg_ground_grass_draw, stage2_bg_pos},
+		{ stage2_bg_leaves_draw, stage2_bg_branch_pos, stage2_bg_leaves_draw_instanced },
+		{ stage2_bg_ground_grass_draw, stage2_bg_pos, stage2_bg_ground_grass_draw_instanced },
 		{ stage3d_hinalights_draw, stage2_testlights_pos },
 #if TESTLIGHTS
 		{ stage3d_testlights_draw, stage2_testlights_pos },
@@ -106,6 +106,8 @@ static void stage2_preload(ResourceGroup *rg) {
 		"fireparticles",
 		"pbr",
 		"pbr_diffuse_alpha_discard",
+		"pbr_instanced",
+		"pbr_instanced_diffuse_alpha_discard",
 		"pbr_water",
 		"zbuf_fog_tonemap",
 	NULL);
@@ -82,6 +82,22 @@ static void stage3_bg_ground_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage3_bg_ground_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	pbr_set_instance_positions(num, pos);
+	r_shader("pbr_instanced");
+
+	PBREnvironment env = { 0 };
+	stage3_bg_setup_pbr_env(&stage_3d_context.cam, &env);
+
+	pbr_draw_model_instanced(&stage3_draw_data->models.trees, &env);
+	pbr_draw_model_instanced(&stage3_draw_data->models.rocks, &env);
+	pbr_draw_model_instanced(&stage3_draw_data->models.ground, &env);
+
+	r_state_pop();
+}
+
 static void stage3_bg_leaves_draw(vec3 pos) {
 	r_state_push();
 	r_mat_mv_push();
@@ -99,6 +115,24 @@ static void stage3_bg_leaves_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage3_bg_leaves_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	r_mat_mv_push();
+	r_mat_mv_translate(0, 0, -0.0002);
+
+	pbr_set_instance_positions(num, pos);
+	r_shader("pbr_instanced_roughness_alpha_discard");
+
+	PBREnvironment env = { 0 };
+	stage3_bg_setup_pbr_env(&stage_3d_context.cam, &env);
+
+	pbr_draw_model_instanced(&stage3_draw_data->models.leaves, &env);
+
+	r_mat_mv_pop();
+	r_state_pop();
+}
+
 void stage3_drawsys_init(void) {
 	stage3d_init(&stage_3d_context, 16);
 	stage_3d_context.cam.pos[1] = -16;
@@ -160,8 +194,8 @@ static bool stage3_glitch(Framebuffer *fb) {
 
 void stage3_draw(void) {
 	Stage3DSegment segments[] = {
-		{ stage3_bg_leaves_draw, stage3_bg_pos },
-		{ stage3_bg_ground_draw, stage3_bg_pos },
+		{ stage3_bg_leaves_draw, stage3_bg_pos, stage3_bg_leaves_draw_instanced },
+		{ stage3_bg_ground_draw, stage3_bg_pos, stage3_bg_ground_draw_instanced },
 	};
 	r_clear(BUFFER_COLOR, RGB(0.12, 0.11, 0.10), 1);
 	stage3d_draw(&stage_3d_context, 120, ARRAY_SIZE(segments), segments);
@@ -124,6 +124,8 @@ static void stage3_preload(ResourceGroup *rg) {
 		"glitch",
 		"maristar_bombbg",
 		"pbr",
+		"pbr_instanced",
+		"pbr_instanced_roughness_alpha_discard",
 		"pbr_roughness_alpha_discard",
 		"stage3_wriggle_bg",
 		"zbuf_fog_tonemap",
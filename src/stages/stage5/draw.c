@@ -95,8 +95,28 @@ static void stage5_stairs_draw(vec3 pos) {
 	r_state_pop();
 }
 
+static void stage5_stairs_draw_instanced(uint num, vec3 pos[num]) {
+	r_state_push();
+
+	pbr_set_instance_positions(num, pos);
+	r_shader("pbr_instanced");
+
+	PBREnvironment env = { 0 };
+	stage5_bg_setup_pbr_env(&stage_3d_context.cam, &env);
+
+	pbr_draw_model_instanced(&stage5_draw_data->models.metal, &env);
+	pbr_draw_model_instanced(&stage5_draw_data->models.stairs, &env);
+	pbr_draw_model_instanced(&stage5_draw_data->models.wall, &env);
+
+	r_state_pop();
+}
+
 void stage5_draw(void) {
-	stage3d_draw(&stage_3d_context, 50, 1, (Stage3DSegment[]) { stage5_stairs_draw, stage5_stairs_pos });
+	Stage3DSegment segs[] = {
+		{ stage5_stairs_draw, stage5_stairs_pos, stage5_stairs_draw_instanced },
+	};
+
+	stage3d_draw(&stage_3d_context, 50, ARRAY_SIZE(segs), segs);
 }
 
 static bool stage5_fog(Framebuffer *fb) {
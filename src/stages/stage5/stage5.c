@@ -105,6 +105,7 @@ static void stage5_preload(ResourceGroup *rg) {
 	NULL);
 	res_group_preload(rg, RES_SHADER_PROGRAM, RESF_DEFAULT,
 		"pbr",
+		"pbr_instanced",
 		"zbuf_fog",
 	NULL);
 	res_group_preload(rg, RES_ANIM, RESF_DEFAULT,
@@ -292,6 +292,7 @@ static void baryons_bg_fill(Stage6DrawData *draw_data, int t, EllyBaryons *baryo
 	r_framebuffer(draw_data->baryon.fbpair.front);
 
 	ENT_ARRAY_FOREACH(particles, Projectile *p, {
+		r_state_block_apply(p->ent.draw_state);
 		r_state_push();
 		p->ent.draw_func(&p->entity_interface);
 		r_state_pop();
@@ -0,0 +1,110 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "stagesnapshot.h"
+#include "global.h"
+#include "log.h"
+
+#define PLR_FIELDS \
+	PLR_FIELD(points, PRIu64) \
+	PLR_FIELD(extralife_threshold, PRIu64) \
+	PLR_FIELD(extralives_given, "u") \
+	PLR_FIELD(point_item_value, "u") \
+	PLR_FIELD(graze, "u") \
+	PLR_FIELD(voltage, "u") \
+	PLR_FIELD(lives, "i") \
+	PLR_FIELD(bombs, "i") \
+	PLR_FIELD(life_fragments, "i") \
+	PLR_FIELD(bomb_fragments, "i") \
+	PLR_FIELD(power_stored, "i") \
+
+void stage_snapshot_capture(StageSnapshot *snap) {
+	Player *plr = &global.plr;
+
+	*snap = (StageSnapshot) {
+		.frame = global.frames,
+		.voltage_threshold = global.voltage_threshold,
+		.total_spawns = ent_get_total_spawns(),
+		.rng = global.rand_game,
+		.plr.stats = plr->stats,
+	};
+
+	#define PLR_FIELD(name, fmt) snap->plr.name = plr->name;
+	PLR_FIELDS
+	#undef PLR_FIELD
+
+	ent_count_by_type(snap->num_entities);
+
+	log_debug("Captured stage snapshot on frame %i (%u spawns)", snap->frame, snap->total_spawns);
+}
+
+bool stage_snapshot_verify(const StageSnapshot *snap) {
+	Player *plr = &global.plr;
+	bool ok = true;
+
+	#define CHECK(what, fmt, expected, actual) do { \
+		if((expected) != (actual)) { \
+			log_warn("Snapshot mismatch: " what ": expected %" fmt ", got %" fmt, (expected), (actual)); \
+			ok = false; \
+		} \
+	} while(0)
+
+	CHECK("frame", "i", snap->frame, global.frames);
+	CHECK("voltage threshold", "u", snap->voltage_threshold, global.voltage_threshold);
+	CHECK("total entity spawns", PRIu32, snap->total_spawns, ent_get_total_spawns());
+
+	uint num_entities[_ENT_TYPE_ENUM_END];
+	ent_count_by_type(num_entities);
+
+	for(EntityType t = _ENT_TYPE_ENUM_BEGIN + 1; t < _ENT_TYPE_ENUM_END; ++t) {
+		if(snap->num_entities[t] != num_entities[t]) {
+			log_warn(
+				"Snapshot mismatch: %s count: expected %u, got %u",
+				ent_type_name(t), snap->num_entities[t], num_entities[t]
+			);
+			ok = false;
+		}
+	}
+
+	if(memcmp(snap->rng.state, global.rand_game.state, sizeof(snap->rng.state))) {
+		log_warn("Snapshot mismatch: game RNG state differs");
+		ok = false;
+	}
+
+	#define PLR_FIELD(name, fmt) CHECK("player " #name, fmt, snap->plr.name, plr->name);
+	PLR_FIELDS
+	#undef PLR_FIELD
+
+	if(memcmp(&snap->plr.stats, &plr->stats, sizeof(snap->plr.stats))) {
+		log_warn("Snapshot mismatch: player stats differ");
+		ok = false;
+	}
+
+	#undef CHECK
+
+	return ok;
+}
+
+void stage_snapshot_restore(const StageSnapshot *snap) {
+	Player *plr = &global.plr;
+
+	#define PLR_FIELD(name, fmt) plr->name = snap->plr.name;
+	PLR_FIELDS
+	#undef PLR_FIELD
+
+	plr->stats = snap->plr.stats;
+	global.voltage_threshold = snap->voltage_threshold;
+
+	if(snap->frame == global.frames) {
+		memcpy(global.rand_game.state, snap->rng.state, sizeof(snap->rng.state));
+	}
+
+	log_info("Restored player state from the snapshot taken on frame %i", snap->frame);
+}
@@ -0,0 +1,60 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "entity.h"
+#include "random.h"
+#include "stats.h"
+
+/*
+ * An in-memory checkpoint of the plain-data parts of the game state.
+ *
+ * Stage scripts keep most of their state on coroutine stacks, which can't be
+ * copied or restored safely, so a snapshot can't reconstruct the world on its
+ * own. Quickloads still fast-forward through the quicksave replay to rebuild
+ * entities and tasks; the snapshot is then used to verify the result on the
+ * resume frame and to restore the player's state if the replay went out of sync
+ * (e.g. after a stage hot-reload).
+ */
+
+typedef struct StageSnapshot {
+	int frame;
+	uint voltage_threshold;
+	uint32_t total_spawns;
+	uint num_entities[_ENT_TYPE_ENUM_END];
+	RandomState rng;
+
+	struct {
+		uint64_t points;
+		uint64_t extralife_threshold;
+		uint extralives_given;
+		uint point_item_value;
+		uint graze;
+		uint voltage;
+		int lives;
+		int bombs;
+		int life_fragments;
+		int bomb_fragments;
+		int power_stored;
+		Stats stats;
+	} plr;
+} StageSnapshot;
+
+void stage_snapshot_capture(StageSnapshot *snap)
+	attr_nonnull_all;
+
+// Compares the snapshot against the current state, logging every mismatch.
+bool stage_snapshot_verify(const StageSnapshot *snap)
+	attr_nonnull_all;
+
+// Restores the player's resources and score. The game RNG is also restored if
+// the snapshot was taken on the current frame.
+void stage_snapshot_restore(const StageSnapshot *snap)
+	attr_nonnull_all;
@@ -48,6 +48,7 @@ StageText* stagetext_add_numeric(int n, cmplx pos, Alignment align, Font *font,
 }
 
 static void* stagetext_delete(List **dest, List *txt, void *arg) {
+	text_layout_free(((StageText*)txt)->layout);
 	objpool_release(&stage_object_pools.stagetext, list_unlink(dest, txt));
 	return NULL;
 }
@@ -109,7 +110,11 @@ static void stagetext_draw_single(StageText *txt) {
 	params.pos.y = cimag(txt->pos) + ofs_y;
 	params.color = &txt->color;
 
-	text_draw(txt->text, &params);
+	if(txt->layout == NULL) {
+		txt->layout = text_layout_new();
+	}
+
+	text_layout_draw(txt->layout, txt->text, &params);
 }
 
 void stagetext_update(void) {
@@ -27,6 +27,7 @@ struct StageText {
 	LIST_INTERFACE(StageText);
 
 	Font *font;
+	TextLayout *layout;
 	cmplx pos;
 
 	struct {
@@ -17,6 +17,12 @@
 
 Stage3D stage_3d_context;
 
+static struct {
+	VertexBuffer *vbuf;
+	VertexArray *varr;
+	uint num_instances;
+} pbr_instances;
+
 void stage3d_init(Stage3D *s, uint pos_buffer_size) {
 	memset(s, 0, sizeof(*s));
 	camera3d_init(&s->cam);
@@ -219,7 +225,86 @@ void pbr_load_model(PBRModel *pmdl, const char *model_name, const char *mat_name
 	pmdl->mat = res_material(mat_name);
 }
 
-void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawRule draw_rule, float maxrange) {
+static void pbr_instances_init(void) {
+	size_t sz_vert = sizeof(GenericModelVertex);
+	size_t sz_inst = sizeof(mat4);
+
+	#define VERTEX_OFS(attr) offsetof(GenericModelVertex, attr)
+
+	VertexAttribFormat fmt[] = {
+		// Per-vertex attributes (for the static models buffer, bound at 0)
+		{ { 3, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert, VERTEX_OFS(position),    0 },
+		{ { 2, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert, VERTEX_OFS(uv),          0 },
+		{ { 3, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert, VERTEX_OFS(normal),      0 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 0 }, sz_vert, VERTEX_OFS(tangent),     0 },
+
+		// Per-instance model matrix, one column per attribute (for our own buffer, bound at 1)
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_inst, sizeof(vec4) * 0,        1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_inst, sizeof(vec4) * 1,        1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_inst, sizeof(vec4) * 2,        1 },
+		{ { 4, VA_FLOAT, VA_CONVERT_FLOAT, 1 }, sz_inst, sizeof(vec4) * 3,        1 },
+	};
+
+	#undef VERTEX_OFS
+
+	pbr_instances.vbuf = r_vertex_buffer_create(sz_inst * 32, NULL);
+	r_vertex_buffer_set_debug_label(pbr_instances.vbuf, "Stage3D instances vertex buffer");
+
+	pbr_instances.varr = r_vertex_array_create();
+	r_vertex_array_set_debug_label(pbr_instances.varr, "Stage3D instances vertex array");
+	r_vertex_array_attach_vertex_buffer(pbr_instances.varr, r_vertex_buffer_static_models(), 0);
+	r_vertex_array_attach_vertex_buffer(pbr_instances.varr, pbr_instances.vbuf, 1);
+	r_vertex_array_attach_index_buffer(
+		pbr_instances.varr, r_vertex_array_get_index_attachment(r_vertex_array_static_models()));
+	r_vertex_array_layout(pbr_instances.varr, ARRAY_SIZE(fmt), fmt);
+}
+
+static void pbr_instances_shutdown(void) {
+	if(pbr_instances.varr) {
+		r_vertex_array_destroy(pbr_instances.varr);
+		r_vertex_buffer_destroy(pbr_instances.vbuf);
+		memset(&pbr_instances, 0, sizeof(pbr_instances));
+	}
+}
+
+void pbr_set_instance_transforms(uint num_instances, mat4 transforms[num_instances]) {
+	if(UNLIKELY(!pbr_instances.varr)) {
+		pbr_instances_init();
+	}
+
+	// Previous contents may still be in use by pending draws; orphan them.
+	r_vertex_buffer_invalidate(pbr_instances.vbuf);
+	SDL_RWops *stream = r_vertex_buffer_get_stream(pbr_instances.vbuf);
+	SDL_RWwrite(stream, transforms, sizeof(mat4), num_instances);
+	pbr_instances.num_instances = num_instances;
+}
+
+void pbr_set_instance_positions(uint num_instances, vec3 positions[num_instances]) {
+	mat4 transforms[num_instances];
+
+	for(uint i = 0; i < num_instances; ++i) {
+		glm_translate_make(transforms[i], positions[i]);
+	}
+
+	pbr_set_instance_transforms(num_instances, transforms);
+}
+
+void pbr_draw_model_instanced(const PBRModel *pmdl, const PBREnvironment *env) {
+	assert(pbr_instances.varr != NULL);
+
+	if(pbr_instances.num_instances == 0) {
+		return;
+	}
+
+	Model mdl = *NOT_NULL(pmdl->mdl);
+	assert(mdl.vertex_array == r_vertex_array_static_models());
+	mdl.vertex_array = pbr_instances.varr;
+
+	pbr_set_material_uniforms(NOT_NULL(pmdl->mat), env);
+	r_draw_model_ptr(&mdl, pbr_instances.num_instances, 0);
+}
+
+static uint stage3d_gather_positions(Stage3D *s, SegmentPositionRule pos_rule, float maxrange) {
 	s->positions.num_elements = 0;
 
 	// TODO maybe get rid of the return value
@@ -229,19 +314,40 @@ void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawR
 		s->positions.num_elements = num;
 	}
 
+	return s->positions.num_elements;
+}
+
+void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawRule draw_rule, float maxrange) {
+	stage3d_gather_positions(s, pos_rule, maxrange);
+
 	dynarray_foreach_elem(&s->positions, vec3 *p, {
 		draw_rule(*p);
 	});
 }
 
+void stage3d_draw_segment_instanced(Stage3D *s, SegmentPositionRule pos_rule, SegmentInstancedDrawRule draw_rule, float maxrange) {
+	uint num = stage3d_gather_positions(s, pos_rule, maxrange);
+
+	if(num > 0) {
+		draw_rule(num, s->positions.data);
+	}
+}
+
 void stage3d_draw(Stage3D *s, float maxrange, uint nsegments, const Stage3DSegment segments[nsegments]) {
 	r_mat_mv_push();
 	stage3d_apply_transforms(s, *r_mat_mv_current_ptr());
 	r_mat_proj_push_perspective(s->cam.fovy, s->cam.aspect, s->cam.near, s->cam.far);
 
+	bool instancing = r_supports(RFEAT_DRAW_INSTANCED);
+
 	for(uint i = 0; i < nsegments; ++i) {
 		const Stage3DSegment *seg = segments + i;
-		stage3d_draw_segment(s, seg->pos, seg->draw, maxrange);
+
+		if(seg->draw_instanced && instancing) {
+			stage3d_draw_segment_instanced(s, seg->pos, seg->draw_instanced, maxrange);
+		} else {
+			stage3d_draw_segment(s, seg->pos, seg->draw, maxrange);
+		}
 	}
 
 	r_mat_mv_pop();
@@ -250,6 +356,7 @@ void stage3d_draw(Stage3D *s, float maxrange, uint nsegments, const Stage3DSegme
 
 void stage3d_shutdown(Stage3D *s) {
 	dynarray_free_data(&s->positions);
+	pbr_instances_shutdown();
 }
 
 struct pos_ray_data {
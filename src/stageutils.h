@@ -16,11 +16,16 @@
 typedef struct Stage3D Stage3D;
 
 typedef void (*SegmentDrawRule)(vec3 pos);
+typedef void (*SegmentInstancedDrawRule)(uint num_positions, vec3 positions[num_positions]);
 typedef uint (*SegmentPositionRule)(Stage3D *s3d, vec3 q, float maxrange); // returns number of elements written to Stage3D pos_buffer
 
 typedef struct Stage3DSegment {
 	SegmentDrawRule draw;
 	SegmentPositionRule pos;
+
+	// Optional. Draws all positions of the segment at once, usually with pbr_draw_model_instanced().
+	// Used instead of `draw` if instanced drawing is supported.
+	SegmentInstancedDrawRule draw_instanced;
 } Stage3DSegment;
 
 typedef union Camera3DRotation {
@@ -89,6 +94,7 @@ void stage3d_shutdown(Stage3D *s);
 void stage3d_apply_transforms(Stage3D *s, mat4 mat);
 void stage3d_apply_inverse_transforms(Stage3D *s, mat4 mat);
 void stage3d_draw_segment(Stage3D *s, SegmentPositionRule pos_rule, SegmentDrawRule draw_rule, float maxrange);
+void stage3d_draw_segment_instanced(Stage3D *s, SegmentPositionRule pos_rule, SegmentInstancedDrawRule draw_rule, float maxrange);
 void stage3d_draw(Stage3D *s, float maxrange, uint nsegments, const Stage3DSegment segments[nsegments]);
 
 void camera3d_init(Camera3D *cam) attr_nonnull(1);
@@ -116,6 +122,17 @@ void pbr_set_material_uniforms(const PBRMaterial *m, const PBREnvironment *env)
 void pbr_draw_model(const PBRModel *pmdl, const PBREnvironment *env) attr_nonnull_all;
 void pbr_load_model(PBRModel *pmdl, const char *model_name, const char *mat_name);
 
+/*
+ * Instanced PBR drawing. Requires RFEAT_DRAW_INSTANCED and one of the pbr_instanced* shaders.
+ *
+ * pbr_set_instance_transforms() uploads a model matrix per instance; these are applied before the
+ * current modelview matrix. Every pbr_draw_model_instanced() call that follows draws the model once
+ * per instance, in a single draw call. pbr_set_instance_positions() is a shorthand for translations.
+ */
+void pbr_set_instance_transforms(uint num_instances, mat4 transforms[num_instances]);
+void pbr_set_instance_positions(uint num_instances, vec3 positions[num_instances]);
+void pbr_draw_model_instanced(const PBRModel *pmdl, const PBREnvironment *env) attr_nonnull_all;
+
 /*
  * Generate an array of equally spaced positions on a ray starting at `origin`:
  *
@@ -285,6 +285,11 @@ typedef _Complex double cmplx;
 #define attr_alloc_align(arg_index) \
 	__attribute__ ((alloc_align(arg_index)))
 
+// Function is compiled for a specific instruction set extension (e.g. "ssse3").
+// The caller is responsible for checking that the CPU supports it.
+#define attr_target(isa) \
+	__attribute__ ((target(isa)))
+
 
 #define INLINE static inline attr_must_inline __attribute__((gnu_inline))
 
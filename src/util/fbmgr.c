@@ -189,6 +189,12 @@ void fbmgr_group_fbpair_create(ManagedFramebufferGroup *group, const char *name,
 	fbpair->back = fbmgr_group_framebuffer_create(group, buf, cfg);
 }
 
+void fbmgr_group_update(ManagedFramebufferGroup *group) {
+	for(List *n = group->members; n; n = n->next) {
+		fbmgr_framebuffer_update(GROUPNODE_TO_DATA(n));
+	}
+}
+
 void fbmgr_resize_strategy_screensized(void *ignored, IntExtent *out_dimensions, FloatRect *out_viewport) {
 	float w, h;
 	video_get_viewport_size(&w, &h);
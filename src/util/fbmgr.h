@@ -58,6 +58,12 @@ Framebuffer *fbmgr_group_framebuffer_create(ManagedFramebufferGroup *group, cons
 void fbmgr_group_fbpair_create(ManagedFramebufferGroup *group, const char *name, const FramebufferConfig *cfg, FBPair *fbpair)
 	attr_nonnull(1, 2, 3, 4);
 
+// Re-evaluates the resize strategies of all framebuffers in the group.
+// Use this when a strategy's result may have changed outside of the usual triggers
+// (video mode and quality settings changes).
+void fbmgr_group_update(ManagedFramebufferGroup *group)
+	attr_nonnull(1);
+
 // For use as FramebufferConfig.resize_func.resize_func
 // Configures the framebuffer to be as large as the main framebuffer, minus the letterboxing
 // (as in video_get_viewport_size())
@@ -0,0 +1,128 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "passtimer.h"
+#include "util.h"
+
+// Weight of the newest sample in the moving average
+#define PASSTIMER_SMOOTHING 0.1
+
+static struct {
+	LIST_ANCHOR(PassTimer) timers;
+	bool enabled;
+} passtimers;
+
+void passtimer_init(PassTimer *t, const char *name, PassCost cost) {
+	assert(!t->registered);
+	*t = (PassTimer) {
+		.name = name,
+		.cost = cost,
+		.registered = true,
+	};
+	alist_append(&passtimers.timers, t);
+}
+
+void passtimer_destroy(PassTimer *t) {
+	if(!t->registered) {
+		return;
+	}
+
+	if(t->query) {
+		r_timer_query_destroy(t->query);
+	}
+
+	alist_unlink(&passtimers.timers, t);
+	*t = (PassTimer) { 0 };
+}
+
+void passtimer_begin(PassTimer *t) {
+	if(!passtimers.enabled) {
+		return;
+	}
+
+	assert(t->registered);
+
+	if(!t->query) {
+		t->query = r_timer_query_create();
+
+		if(!t->query) {
+			return;
+		}
+	}
+
+	r_timer_query_begin(t->query);
+	t->sampled = true;
+}
+
+void passtimer_end(PassTimer *t) {
+	if(!passtimers.enabled || !t->query) {
+		return;
+	}
+
+	r_timer_query_end(t->query);
+}
+
+void passtimer_reset(PassTimer *t) {
+	t->have_data = false;
+	t->avg_msec = 0;
+}
+
+static void passtimer_update(PassTimer *t) {
+	uint64_t nsec;
+
+	if(!t->query || !r_timer_query_result(t->query, &nsec)) {
+		return;
+	}
+
+	double msec = nsec / 1e6;
+
+	if(t->have_data) {
+		t->avg_msec = lerp(t->avg_msec, msec, PASSTIMER_SMOOTHING);
+	} else {
+		t->avg_msec = msec;
+		t->have_data = true;
+	}
+}
+
+void passtimers_update(void) {
+	if(!passtimers.enabled) {
+		return;
+	}
+
+	for(PassTimer *t = passtimers.timers.first; t; t = t->next) {
+		if(t->sampled) {
+			passtimer_update(t);
+			t->sampled = false;
+		} else {
+			passtimer_reset(t);
+		}
+	}
+}
+
+PassTimer *passtimers_first(void) {
+	return passtimers.timers.first;
+}
+
+void passtimers_set_enabled(bool enabled) {
+	passtimers.enabled = enabled;
+}
+
+bool passtimers_enabled(void) {
+	return passtimers.enabled;
+}
+
+const char *passtimer_cost_name(PassCost cost) {
+	switch(cost) {
+		case PASS_COST_CHEAP:     return "cheap";
+		case PASS_COST_MODERATE:  return "moderate";
+		case PASS_COST_EXPENSIVE: return "expensive";
+		default: UNREACHABLE;
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2019, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2019, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "list.h"
+#include "renderer/api.h"
+
+/*
+ * GPU time measurement for individual rendering passes.
+ *
+ * Each pass declares a cost class, which describes how its GPU time is expected to scale
+ * with the resolution of its render target. This is used to predict the effect of changing
+ * framebuffer sizes (see stagedraw.c).
+ *
+ * Timers do nothing unless enabled with passtimers_set_enabled(), and silently do nothing
+ * if the renderer doesn't support timer queries. Like the underlying timer queries, pass
+ * timers must not be nested.
+ *
+ * A timer that wasn't started since the previous passtimers_update() has its average
+ * discarded, so that passes which are currently skipped don't report stale measurements.
+ */
+
+typedef enum PassCost {
+	PASS_COST_CHEAP,      // roughly constant (e.g. a copy or a clear)
+	PASS_COST_MODERATE,   // scales linearly with the target's dimensions
+	PASS_COST_EXPENSIVE,  // scales with the target's area (fill-rate bound)
+	NUM_PASS_COSTS,
+} PassCost;
+
+typedef struct PassTimer {
+	LIST_INTERFACE(struct PassTimer);
+	const char *name;
+	TimerQuery *query;
+	double avg_msec;
+	PassCost cost;
+	bool have_data;
+	bool sampled;  // started since the last passtimers_update()
+	bool registered;
+} PassTimer;
+
+void passtimer_init(PassTimer *t, const char *name, PassCost cost) attr_nonnull_all;
+void passtimer_destroy(PassTimer *t) attr_nonnull_all;
+void passtimer_begin(PassTimer *t) attr_nonnull_all;
+void passtimer_end(PassTimer *t) attr_nonnull_all;
+
+// Discards the averaged measurements, e.g. after changing the framebuffer size.
+void passtimer_reset(PassTimer *t) attr_nonnull_all;
+
+// Polls the latest results of all registered timers, and resets the ones that weren't
+// started since the previous call. Should be called once per frame, after all passes.
+void passtimers_update(void);
+
+// Iterate over registered timers, in registration order.
+PassTimer *passtimers_first(void);
+
+void passtimers_set_enabled(bool enabled);
+bool passtimers_enabled(void);
+
+const char *passtimer_cost_name(PassCost cost) attr_returns_nonnull;
@@ -15,6 +15,7 @@
 #include "util/fbmgr.h"
 #include "taskmanager.h"
 #include "video_postprocess.h"
+#include "framedump.h"
 #include "dynarray.h"
 #include "version.h"
 
@@ -29,6 +30,7 @@ static struct {
 	VideoMode current;
 	VideoBackend backend;
 	double scaling_factor;
+	bool present_pending;
 } video;
 
 VideoCapabilityState (*video_query_capability)(VideoCapability cap);
@@ -587,20 +589,19 @@ static void video_screenshot_free_task_data(void *arg) {
 	mem_free(tdata);
 }
 
-void video_take_screenshot(void) {
-	ScreenshotTaskData tdata;
-	memset(&tdata, 0, sizeof(tdata));
+static void video_screenshot_ready(Pixmap *image, void *userdata) {
+	char *dest_path = userdata;
 
-	if(!r_screenshot(&tdata.image)) {
+	if(!image) {
 		log_error("Failed to take a screenshot");
+		mem_free(dest_path);
 		return;
 	}
 
-	SystemTime systime;
-	char timestamp[FILENAME_TIMESTAMP_MIN_BUF_SIZE];
-	get_system_time(&systime);
-	filename_timestamp(timestamp, sizeof(timestamp), systime);
-	tdata.dest_path = strfmt("storage/screenshots/taisei_%s.png", timestamp);
+	ScreenshotTaskData tdata = {
+		.dest_path = dest_path,
+		.image = *image,
+	};
 
 	task_detach(taskmgr_global_submit((TaskParams) {
 		.callback = video_screenshot_task,
@@ -609,6 +610,16 @@ void video_take_screenshot(void) {
 	}));
 }
 
+void video_take_screenshot(void) {
+	SystemTime systime;
+	char timestamp[FILENAME_TIMESTAMP_MIN_BUF_SIZE];
+	get_system_time(&systime);
+	filename_timestamp(timestamp, sizeof(timestamp), systime);
+
+	// The current frame is captured when it's presented, and saved once the pixels arrive.
+	r_screenshot_async(video_screenshot_ready, strfmt("storage/screenshots/taisei_%s.png", timestamp));
+}
+
 bool video_is_resizable(void) {
 	return SDL_GetWindowFlags(video.window) & SDL_WINDOW_RESIZABLE;
 }
@@ -877,8 +888,11 @@ Framebuffer *video_get_screen_framebuffer(void) {
 	return video_postprocess_get_framebuffer(video.postprocess);
 }
 
-void video_swap_buffers(void) {
+static void video_finish_frame(void) {
+	video_present_pending();
+
 	Framebuffer *pp_fb = video_postprocess_render(video.postprocess);
+	framedump_frame();
 
 	if(pp_fb) {
 		r_flush_sprites();
@@ -895,16 +909,37 @@ void video_swap_buffers(void) {
 		r_mat_proj_pop();
 		r_state_pop();
 
-		r_swap(video.window);
 		r_framebuffer(prev_fb);
-	} else {
-		r_swap(video.window);
 	}
+}
+
+static void video_present(void) {
+	r_swap(video.window);
 
 	// XXX: Unfortunately, there seems to be no reliable way to sync this up with events
 	config_set_int(CONFIG_FULLSCREEN, video_is_fullscreen());
 }
 
+void video_swap_buffers(void) {
+	video_finish_frame();
+	video_present();
+}
+
+void video_swap_buffers_deferred(void) {
+	video_finish_frame();
+
+	// Make sure the driver starts working on the frame now, rather than when it's presented.
+	r_flush();
+	video.present_pending = true;
+}
+
+void video_present_pending(void) {
+	if(video.present_pending) {
+		video.present_pending = false;
+		video_present();
+	}
+}
+
 VideoBackend video_get_backend(void) {
 	return video.backend;
 }
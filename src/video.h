@@ -74,6 +74,13 @@ bool video_is_resizable(void);
 extern VideoCapabilityState (*video_query_capability)(VideoCapability cap);
 void video_take_screenshot(void);
 void video_swap_buffers(void);
+
+// Like video_swap_buffers, but only finishes the frame; presenting it is postponed until the
+// next call to video_present_pending (or any other swap). Nothing must draw into the default
+// framebuffer in between.
+void video_swap_buffers_deferred(void);
+void video_present_pending(void);
+
 uint video_num_displays(void);
 uint video_current_display(void);
 void video_set_display(uint idx);